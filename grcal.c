@@ -7,7 +7,25 @@
  */
 
 #include "grcal.h"
+
+/*
+ * Fault handling
+ * ==============
+ * 
+ * In the default (hosted) configuration, faults are handled by calling
+ * the standard library abort() function.
+ * 
+ * If GRCAL_FREESTANDING is defined, the standard library is not used at
+ * all and faults are instead routed to the grcal_fault() function,
+ * which the embedding runtime must provide.  See the header for
+ * further information.
+ */
+#ifdef GRCAL_FREESTANDING
+#define GRCAL_FAULT() grcal_fault()
+#else
 #include <stdlib.h>
+#define GRCAL_FAULT() abort()
+#endif
 
 /*
  * Constants
@@ -146,8 +164,22 @@
  * Pattern digits that are "+" indicate 31-day months, pattern digits
  * that are "-" indicate 30-day months, and pattern digits that are "*"
  * indicate variable-length months.
+ * 
+ * This is declared as an array rather than as a pointer to a string
+ * literal so that it does not require a load-time relocation when the
+ * library is compiled as position-independent code.
+ */
+static const char m_pattern[MONTH_COUNT + 1] = "+-+-++-+-++*";
+
+/*
+ * Compile-time checks that the GRCAL_DATE() macro in grcal.h agrees
+ * with the range constants.
  */
-static const char *m_pattern = "+-+-++-+-++*";
+typedef char check_date_zero[(GRCAL_DATE(1582, 10, 15) == 0) ? 1 : -1];
+typedef char check_date_unix[
+    (GRCAL_DATE(1970, 1, 1) == GRCAL_DAY_UNIX) ? 1 : -1];
+typedef char check_date_max[
+    (GRCAL_DATE(9999, 12, 31) == GRCAL_DAY_MAX) ? 1 : -1];
 
 /*
  * Local functions
@@ -177,7 +209,7 @@ static int isLeapYear(int y) {
   
   /* Check parameter */
   if (y < 1) {
-    abort();
+    GRCAL_FAULT();
   }
   
   /* Years divisible by 400 are leap years */
@@ -221,7 +253,7 @@ static int monthLength(int i) {
   
   /* Check parameter */
   if ((i < 0) || (i >= MONTH_COUNT)) {
-    abort();
+    GRCAL_FAULT();
   }
   
   /* Get the requested pattern character */
@@ -238,7 +270,7 @@ static int monthLength(int i) {
     result = 0;
     
   } else {
-    abort();
+    GRCAL_FAULT();
   }
   
   /* Return result */
@@ -275,7 +307,7 @@ void grcal_offsetToDate(
   
   /* Check parameter */
   if ((offs < 0) || (offs > GRCAL_DAY_MAX)) {
-    abort();
+    GRCAL_FAULT();
   }
   
   /* Adjust offset so it uses 1200-03-01 as day zero */
@@ -519,7 +551,7 @@ int grcal_weekday(int32_t offs) {
   
   /* Check parameter */
   if ((offs < 0) || (offs > GRCAL_DAY_MAX)) {
-    abort();
+    GRCAL_FAULT();
   }
   
   /* If the day offset is before the first Monday of the Gregorian
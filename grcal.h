@@ -25,6 +25,22 @@
  * Julian calendar was used previously.  Proleptic dates are only used
  * during computations; clients are never able to use proleptic dates in
  * the public interface.
+ * 
+ * Freestanding configuration
+ * --------------------------
+ * 
+ * By default, the library uses the standard library abort() function to
+ * handle faults, which is its only dependency on the C library.
+ * 
+ * If GRCAL_FREESTANDING is defined when compiling both this header and
+ * grcal.c, the library makes no C library calls at all and only relies
+ * on the freestanding headers <stddef.h> and <stdint.h>.  It can then
+ * be compiled with -ffreestanding -nostdlib.  In this configuration,
+ * the embedding runtime must supply the grcal_fault() function that is
+ * declared below.
+ * 
+ * The library has no writable static data and no static data that
+ * requires load-time relocation in either configuration.
  */
 
 #include <stddef.h>
@@ -47,6 +63,96 @@
  */
 #define GRCAL_DAY_UNIX INT32_C(141427)
 
+/*
+ * Compile-time date constants
+ * ---------------------------
+ * 
+ * GRCAL_DATE(y, m, d) is the day offset of a Gregorian date, computed
+ * as an integer constant expression when its arguments are integer
+ * constant expressions.  It can therefore be used in static
+ * initializers, case labels, and array sizes, and it costs nothing at
+ * run time.  The result is only meaningful for valid dates, which
+ * GRCAL_DATE_VALID(y, m, d) checks, also as a constant expression.
+ * 
+ * GRCAL_DATE_CHECKED(y, m, d) is the same as GRCAL_DATE(y, m, d),
+ * except that compilation fails if the date is not valid.
+ * GRCAL_DATE_ASSERT(y, m, d) is a declaration that fails compilation if
+ * the date is not valid; before C11, it should only be used at file
+ * scope, and only once per line.
+ * 
+ * The arguments are evaluated more than once, so they must not have
+ * side effects.  The macros agree with grcal_dateToOffset() for every
+ * valid date.
+ */
+
+/*
+ * Helpers for the macros below: whether a year is a leap year, the
+ * number of days in a month, and the year counted from March.
+ */
+#define GRCAL_DATE_LEAP(y) \
+    (((((y) % 4) == 0) && (((y) % 100) != 0)) || (((y) % 400) == 0))
+#define GRCAL_DATE_MDAYS(y, m) (((m) == 2) ? \
+    (28 + (GRCAL_DATE_LEAP(y) ? 1 : 0)) : \
+    (30 + (((m) + ((m) >> 3)) & 1)))
+#define GRCAL_DATE_MYEAR(y, m) ((int32_t) (y) - (((m) <= 2) ? 1 : 0))
+
+/*
+ * The day offset of a date.
+ * 
+ * This counts days from 0000-03-01 in the proleptic Gregorian calendar,
+ * then subtracts the count for 1582-10-15.
+ */
+#define GRCAL_DATE(y, m, d) ((int32_t) ( \
+    (GRCAL_DATE_MYEAR(y, m) * 365) + (GRCAL_DATE_MYEAR(y, m) / 4) - \
+    (GRCAL_DATE_MYEAR(y, m) / 100) + (GRCAL_DATE_MYEAR(y, m) / 400) + \
+    (((153 * (((m) + 9) % 12)) + 2) / 5) + (d) - 1 - 578041))
+
+/*
+ * One if a date is valid, zero if not.
+ */
+#define GRCAL_DATE_VALID(y, m, d) (( \
+    ((y) >= 1582) && ((y) <= 9999) && ((m) >= 1) && ((m) <= 12) && \
+    ((d) >= 1) && ((d) <= GRCAL_DATE_MDAYS(y, m)) && \
+    (((y) > 1582) || ((m) > 10) || (((m) == 10) && ((d) >= 15)))) \
+    ? 1 : 0)
+
+/*
+ * The day offset of a date that is checked at compile time.
+ */
+#define GRCAL_DATE_CHECKED(y, m, d) ((int32_t) (GRCAL_DATE(y, m, d) + \
+    (int32_t) (0 * sizeof(char[GRCAL_DATE_VALID(y, m, d) ? 1 : -1]))))
+
+/*
+ * Declaration that checks a date at compile time.
+ */
+#if defined(__cplusplus) && (__cplusplus >= 201103L)
+#define GRCAL_DATE_ASSERT(y, m, d) \
+    static_assert(GRCAL_DATE_VALID(y, m, d), "invalid grcal date")
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define GRCAL_DATE_ASSERT(y, m, d) \
+    _Static_assert(GRCAL_DATE_VALID(y, m, d), "invalid grcal date")
+#else
+#define GRCAL_DATE_JOIN2(a, b) a ## b
+#define GRCAL_DATE_JOIN(a, b) GRCAL_DATE_JOIN2(a, b)
+#define GRCAL_DATE_ASSERT(y, m, d) \
+    typedef char GRCAL_DATE_JOIN(grcal_date_assert_, __LINE__) \
+    [GRCAL_DATE_VALID(y, m, d) ? 1 : -1]
+#endif
+
+#ifdef GRCAL_FREESTANDING
+/*
+ * Fault handler for the freestanding configuration.
+ * 
+ * This function is NOT implemented by the grcal library.  When
+ * GRCAL_FREESTANDING is defined, the embedding runtime must provide it.
+ * The library calls it wherever the hosted configuration would call
+ * abort(), such as when a day offset is out of range.
+ * 
+ * The function must not return.  Behavior is undefined if it does.
+ */
+void grcal_fault(void);
+#endif
+
 /*
  * Convert a Gregorian day offset into the year, month, and day of
  * month.
@@ -0,0 +1,606 @@
+/*
+ * grcal_arrow.c
+ * 
+ * Implementation of grcal_arrow.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_arrow.h"
+#include "grcal_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of elements converted at a time when producing output
+ * fields.
+ */
+#define BLOCK_SIZE 1024
+
+/*
+ * The number of seconds in a day.
+ */
+#define DAY_SECONDS INT64_C(86400)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Decoded input format.
+ */
+typedef struct {
+  
+  /*
+   * Non-zero if the values are 64-bit, zero if they are 32-bit.
+   */
+  int wide;
+  
+  /*
+   * The number of value units in a day.
+   */
+  int64_t upd;
+  
+  /*
+   * The time zone offset, in value units.
+   */
+  int64_t zone;
+  
+} IN_FORMAT;
+
+/*
+ * Private data of exported arrays.
+ * 
+ * The buffers array is what the exported structure points to.  The mem
+ * array holds the allocations to free on release.
+ */
+typedef struct {
+  const void *buffers[3];
+  void *mem[3];
+} OUT_PRIVATE;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int parseZone(const char *pz, int64_t *pSec);
+static int parseFormat(
+    const struct ArrowSchema * pSchema,
+          IN_FORMAT          * pf);
+static int checkArray(const struct ArrowArray *pArray);
+static int64_t floorDiv(int64_t a, int64_t b);
+static int64_t convertRange(
+    const IN_FORMAT         * pf,
+    const struct ArrowArray * pArray,
+          int64_t             first,
+          size_t              count,
+          int32_t           * pOffs,
+          uint8_t           * pValid);
+static void releaseSchema(struct ArrowSchema *pSchema);
+static void releaseArray(struct ArrowArray *pArray);
+
+/*
+ * Parse a timestamp time zone string.
+ * 
+ * Parameters:
+ * 
+ *   pz - the time zone string
+ * 
+ *   pSec - pointer to the variable to receive the offset in seconds
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the time zone is not supported
+ */
+static int parseZone(const char *pz, int64_t *pSec) {
+  
+  int64_t h = 0;
+  int64_t m = 0;
+  int64_t sign = 1;
+  int i = 0;
+  
+  /* Empty and UTC zones */
+  if ((*pz == 0) || (strcmp(pz, "UTC") == 0) ||
+      (strcmp(pz, "Z") == 0) || (strcmp(pz, "Etc/UTC") == 0)) {
+    *pSec = 0;
+    return 1;
+  }
+  
+  /* Otherwise, must be +HH:MM or -HH:MM */
+  if (strlen(pz) != 6) {
+    return 0;
+  }
+  if (pz[0] == '-') {
+    sign = -1;
+  } else if (pz[0] != '+') {
+    return 0;
+  }
+  for(i = 1; i < 6; i++) {
+    if (i == 3) {
+      if (pz[i] != ':') {
+        return 0;
+      }
+    } else if ((pz[i] < '0') || (pz[i] > '9')) {
+      return 0;
+    }
+  }
+  
+  h = ((pz[1] - '0') * 10) + (pz[2] - '0');
+  m = ((pz[4] - '0') * 10) + (pz[5] - '0');
+  if ((h > 23) || (m > 59)) {
+    return 0;
+  }
+  
+  *pSec = sign * ((h * 3600) + (m * 60));
+  return 1;
+}
+
+/*
+ * Decode the format of an input schema.
+ * 
+ * Parameters:
+ * 
+ *   pSchema - the input schema
+ * 
+ *   pf - the structure to receive the decoded format
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the format is not supported
+ */
+static int parseFormat(
+    const struct ArrowSchema * pSchema,
+          IN_FORMAT          * pf) {
+  
+  const char *fmt = NULL;
+  int64_t zone = 0;
+  
+  if ((pSchema == NULL) || (pSchema->format == NULL)) {
+    return 0;
+  }
+  fmt = pSchema->format;
+  
+  pf->wide = 1;
+  pf->zone = 0;
+  
+  if (strcmp(fmt, "tdD") == 0) {
+    pf->wide = 0;
+    pf->upd = 1;
+    return 1;
+    
+  } else if (strcmp(fmt, "tdm") == 0) {
+    pf->upd = DAY_SECONDS * 1000;
+    return 1;
+  }
+  
+  /* Timestamps are tsX: followed by the time zone */
+  if ((strncmp(fmt, "ts", 2) != 0) || (fmt[2] == 0) ||
+      (fmt[3] != ':')) {
+    return 0;
+  }
+  
+  if (fmt[2] == 's') {
+    pf->upd = DAY_SECONDS;
+  } else if (fmt[2] == 'm') {
+    pf->upd = DAY_SECONDS * 1000;
+  } else if (fmt[2] == 'u') {
+    pf->upd = DAY_SECONDS * 1000000;
+  } else if (fmt[2] == 'n') {
+    pf->upd = DAY_SECONDS * 1000000000;
+  } else {
+    return 0;
+  }
+  
+  if (!parseZone(fmt + 4, &zone)) {
+    return 0;
+  }
+  pf->zone = zone * (pf->upd / DAY_SECONDS);
+  
+  return 1;
+}
+
+/*
+ * Check that an input array has the shape of a primitive array.
+ * 
+ * Parameters:
+ * 
+ *   pArray - the input array
+ * 
+ * Return:
+ * 
+ *   non-zero if the array is usable, zero if not
+ */
+static int checkArray(const struct ArrowArray *pArray) {
+  
+  if (pArray == NULL) {
+    return 0;
+  }
+  if ((pArray->length < 0) || (pArray->offset < 0) ||
+      (pArray->n_buffers != 2) || (pArray->buffers == NULL)) {
+    return 0;
+  }
+  if ((pArray->length > 0) && ((pArray->buffers)[1] == NULL)) {
+    return 0;
+  }
+  if ((uint64_t) pArray->length > (uint64_t) (SIZE_MAX / 16)) {
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * Divide rounding towards negative infinity.
+ * 
+ * Parameters:
+ * 
+ *   a - the dividend
+ * 
+ *   b - the divisor, which must be greater than zero
+ * 
+ * Return:
+ * 
+ *   the floor of a divided by b
+ */
+static int64_t floorDiv(int64_t a, int64_t b) {
+  
+  int64_t q = 0;
+  
+  q = a / b;
+  if ((a % b) < 0) {
+    q--;
+  }
+  return q;
+}
+
+/*
+ * Convert a range of input elements to day offsets.
+ * 
+ * pOffs receives count day offsets, with -1 for null results.  If
+ * pValid is not NULL, bits first up to first + count - 1 of it are
+ * written with the validity of the results.
+ * 
+ * Parameters:
+ * 
+ *   pf - the decoded input format
+ * 
+ *   pArray - the input array
+ * 
+ *   first - the index of the first element to convert
+ * 
+ *   count - the number of elements to convert
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pValid - the output validity bitmap, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of null results
+ */
+static int64_t convertRange(
+    const IN_FORMAT         * pf,
+    const struct ArrowArray * pArray,
+          int64_t             first,
+          size_t              count,
+          int32_t           * pOffs,
+          uint8_t           * pValid) {
+  
+  const uint8_t *pBits = NULL;
+  const int32_t *pv32 = NULL;
+  const int64_t *pv64 = NULL;
+  
+  int64_t nulls = 0;
+  int64_t j = 0;
+  int64_t v = 0;
+  int64_t day = 0;
+  int64_t o = 0;
+  size_t i = 0;
+  int ok = 0;
+  
+  if (pArray->null_count != 0) {
+    pBits = (const uint8_t *) (pArray->buffers)[0];
+  }
+  pv32 = ((const int32_t *) (pArray->buffers)[1]) + pArray->offset;
+  pv64 = ((const int64_t *) (pArray->buffers)[1]) + pArray->offset;
+  
+  for(i = 0; i < count; i++) {
+    j = first + (int64_t) i;
+    
+    /* Check the input validity bitmap, which is indexed including the
+     * array offset */
+    ok = 1;
+    if (pBits != NULL) {
+      o = j + pArray->offset;
+      ok = (pBits[o >> 3] >> (o & 7)) & 1;
+    }
+    
+    /* Get the day relative to the Unix epoch; the zone shift is
+     * applied to the remainder so that it can not overflow */
+    if (ok) {
+      if (pf->wide) {
+        v = pv64[j];
+        day = floorDiv(v, pf->upd);
+        if (pf->zone != 0) {
+          day += floorDiv((v - (day * pf->upd)) + pf->zone, pf->upd);
+        }
+      } else {
+        day = pv32[j];
+      }
+      
+      day += GRCAL_DAY_UNIX;
+      if ((day < 0) || (day > GRCAL_DAY_MAX)) {
+        ok = 0;
+      }
+    }
+    
+    if (ok) {
+      pOffs[i] = (int32_t) day;
+    } else {
+      pOffs[i] = -1;
+      nulls++;
+    }
+    
+    if (pValid != NULL) {
+      if (ok) {
+        pValid[j >> 3] = (uint8_t) (pValid[j >> 3] | (1 << (j & 7)));
+      } else {
+        pValid[j >> 3] = (uint8_t) (pValid[j >> 3] & ~(1 << (j & 7)));
+      }
+    }
+  }
+  
+  return nulls;
+}
+
+/*
+ * Release callback for exported schemas.
+ * 
+ * Parameters:
+ * 
+ *   pSchema - the schema to release
+ */
+static void releaseSchema(struct ArrowSchema *pSchema) {
+  if (pSchema != NULL) {
+    pSchema->release = NULL;
+  }
+}
+
+/*
+ * Release callback for exported arrays.
+ * 
+ * Parameters:
+ * 
+ *   pArray - the array to release
+ */
+static void releaseArray(struct ArrowArray *pArray) {
+  
+  OUT_PRIVATE *pp = NULL;
+  int i = 0;
+  
+  if (pArray == NULL) {
+    return;
+  }
+  
+  pp = (OUT_PRIVATE *) pArray->private_data;
+  if (pp != NULL) {
+    for(i = 0; i < 3; i++) {
+      free((pp->mem)[i]);
+    }
+    free(pp);
+  }
+  
+  pArray->private_data = NULL;
+  pArray->release = NULL;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_arrowOffsets function.
+ */
+int grcal_arrowOffsets(
+    const struct ArrowSchema * pSchema,
+    const struct ArrowArray  * pArray,
+          int32_t            * pOffs,
+          uint8_t            * pValid,
+          int64_t            * pNulls) {
+  
+  IN_FORMAT f;
+  int64_t nulls = 0;
+  
+  if (!parseFormat(pSchema, &f)) {
+    return 0;
+  }
+  if (!checkArray(pArray)) {
+    return 0;
+  }
+  if ((pOffs == NULL) && (pArray->length > 0)) {
+    abort();
+  }
+  
+  nulls = convertRange(
+            &f, pArray, 0, (size_t) pArray->length, pOffs, pValid);
+  
+  if (pNulls != NULL) {
+    *pNulls = nulls;
+  }
+  return 1;
+}
+
+/*
+ * grcal_arrowField function.
+ */
+int grcal_arrowField(
+    const struct ArrowSchema * pSchema,
+    const struct ArrowArray  * pArray,
+          int                  field,
+          struct ArrowSchema * pOutSchema,
+          struct ArrowArray  * pOutArray) {
+  
+  IN_FORMAT f;
+  OUT_PRIVATE *pp = NULL;
+  size_t len = 0;
+  size_t pos = 0;
+  size_t n = 0;
+  size_t i = 0;
+  size_t k = 0;
+  int64_t nulls = 0;
+  
+  uint8_t *pValid = NULL;
+  int32_t *pVal = NULL;
+  char *pChar = NULL;
+  int32_t coff = 0;
+  int32_t start = 0;
+  
+  int32_t offs[BLOCK_SIZE];
+  
+  /* Check parameters */
+  if ((pOutSchema == NULL) || (pOutArray == NULL)) {
+    abort();
+  }
+  if ((field < GRCAL_ARROW_OFFSET) || (field > GRCAL_ARROW_ISO)) {
+    return 0;
+  }
+  if (!parseFormat(pSchema, &f)) {
+    return 0;
+  }
+  if (!checkArray(pArray)) {
+    return 0;
+  }
+  len = (size_t) pArray->length;
+  
+  /* String offsets are 32-bit, which limits the length of ISO output */
+  if ((field == GRCAL_ARROW_ISO) &&
+      (len > (size_t) (INT32_MAX / GRCAL_ISO_LENGTH))) {
+    return 0;
+  }
+  
+  /* Allocate the private data, validity bitmap, and value buffers;
+   * allocations are at least one byte so that empty arrays still have
+   * non-NULL value buffers */
+  pp = (OUT_PRIVATE *) calloc(1, sizeof(OUT_PRIVATE));
+  if (pp == NULL) {
+    return 0;
+  }
+  
+  pValid = (uint8_t *) calloc((len / 8) + 1, 1);
+  if (field == GRCAL_ARROW_ISO) {
+    pVal = (int32_t *) malloc((len + 1) * sizeof(int32_t));
+    pChar = (char *) malloc((len * GRCAL_ISO_LENGTH) + 1);
+  } else {
+    pVal = (int32_t *) malloc((len + 1) * sizeof(int32_t));
+  }
+  
+  (pp->mem)[0] = pValid;
+  (pp->mem)[1] = pVal;
+  (pp->mem)[2] = pChar;
+  
+  if ((pValid == NULL) || (pVal == NULL) ||
+      ((field == GRCAL_ARROW_ISO) && (pChar == NULL))) {
+    free(pValid);
+    free(pVal);
+    free(pChar);
+    free(pp);
+    return 0;
+  }
+  
+  /* Convert block by block */
+  if (field == GRCAL_ARROW_ISO) {
+    pVal[0] = 0;
+  }
+  for(pos = 0; pos < len; pos += n) {
+    n = len - pos;
+    if (n > BLOCK_SIZE) {
+      n = BLOCK_SIZE;
+    }
+    
+    nulls += convertRange(&f, pArray, (int64_t) pos, n, offs, pValid);
+    
+    /* Day offsets are copied directly, with zero for nulls */
+    if (field == GRCAL_ARROW_OFFSET) {
+      for(i = 0; i < n; i++) {
+        pVal[pos + i] = (offs[i] >= 0) ? offs[i] : 0;
+      }
+      continue;
+    }
+    
+    /* Substitute day zero for nulls so that the batch kernels accept
+     * them; the results are masked by the validity bitmap */
+    for(i = 0; i < n; i++) {
+      offs[i] = (offs[i] >= 0) ? offs[i] : 0;
+    }
+    
+    if (field == GRCAL_ARROW_YEAR) {
+      grcal_offsetToDateBatch(offs, n, pVal + pos, NULL, NULL);
+      
+    } else if (field == GRCAL_ARROW_MONTH) {
+      grcal_offsetToDateBatch(offs, n, NULL, pVal + pos, NULL);
+      
+    } else if (field == GRCAL_ARROW_DAY) {
+      grcal_offsetToDateBatch(offs, n, NULL, NULL, pVal + pos);
+      
+    } else if (field == GRCAL_ARROW_WEEKDAY) {
+      grcal_weekdayBatch(offs, n, pVal + pos);
+      
+    } else {
+      /* ISO strings; null elements are empty strings, so the day
+       * offsets of the other elements are packed to the front of the
+       * block and formatted together */
+      start = coff;
+      k = 0;
+      for(i = 0; i < n; i++) {
+        if ((pValid[(pos + i) >> 3] >> ((pos + i) & 7)) & 1) {
+          offs[k] = offs[i];
+          k++;
+          coff += GRCAL_ISO_LENGTH;
+        }
+        pVal[pos + i + 1] = coff;
+      }
+      grcal_offsetToIsoBatch(offs, k, pChar + start, GRCAL_ISO_LENGTH);
+    }
+  }
+  
+  /* Fill in the exported structures; omit the validity bitmap if there
+   * are no nulls */
+  (pp->buffers)[0] = (nulls > 0) ? pValid : NULL;
+  (pp->buffers)[1] = pVal;
+  (pp->buffers)[2] = pChar;
+  
+  memset(pOutArray, 0, sizeof(struct ArrowArray));
+  pOutArray->length = (int64_t) len;
+  pOutArray->null_count = nulls;
+  pOutArray->offset = 0;
+  pOutArray->n_buffers = (field == GRCAL_ARROW_ISO) ? 3 : 2;
+  pOutArray->n_children = 0;
+  pOutArray->buffers = pp->buffers;
+  pOutArray->children = NULL;
+  pOutArray->dictionary = NULL;
+  pOutArray->release = &releaseArray;
+  pOutArray->private_data = pp;
+  
+  memset(pOutSchema, 0, sizeof(struct ArrowSchema));
+  pOutSchema->format = (field == GRCAL_ARROW_ISO) ? "u" : "i";
+  pOutSchema->name = NULL;
+  pOutSchema->metadata = NULL;
+  pOutSchema->flags = ARROW_FLAG_NULLABLE;
+  pOutSchema->n_children = 0;
+  pOutSchema->children = NULL;
+  pOutSchema->dictionary = NULL;
+  pOutSchema->release = &releaseSchema;
+  pOutSchema->private_data = NULL;
+  
+  return 1;
+}
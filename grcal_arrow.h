@@ -0,0 +1,163 @@
+#ifndef GRCAL_ARROW_H_INCLUDED
+#define GRCAL_ARROW_H_INCLUDED
+
+/*
+ * grcal_arrow.h
+ * =============
+ * 
+ * Conversion of Apache Arrow date and timestamp columns through the
+ * Arrow C Data Interface.
+ * 
+ * The C Data Interface structures are defined by a stable ABI, so this
+ * module declares them itself and does not depend on any Arrow library.
+ * If another header has already declared them, that declaration is
+ * used instead.
+ * 
+ * The following input formats are supported:
+ * 
+ *   tdD - date32, days since the Unix epoch
+ *   tdm - date64, milliseconds since the Unix epoch
+ *   tss - timestamp in seconds
+ *   tsm - timestamp in milliseconds
+ *   tsu - timestamp in microseconds
+ *   tsn - timestamp in nanoseconds
+ * 
+ * Timestamps are converted to the date in their time zone.  The time
+ * zone must be empty, "UTC", "Z", or a fixed offset in the form +HH:MM
+ * or -HH:MM.  Named time zones other than UTC are not supported since
+ * grcal has no time zone database.
+ * 
+ * Input arrays are read in place, including their array offset and
+ * validity bitmap.  Input elements that are null produce null outputs.
+ * Input elements that are valid but fall outside the range of grcal day
+ * offsets also produce null outputs.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char *format;
+  const char *name;
+  const char *metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema **children;
+  struct ArrowSchema *dictionary;
+  void (*release)(struct ArrowSchema *);
+  void *private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void **buffers;
+  struct ArrowArray **children;
+  struct ArrowArray *dictionary;
+  void (*release)(struct ArrowArray *);
+  void *private_data;
+};
+
+#endif
+
+/*
+ * Output field selectors for grcal_arrowField().
+ * 
+ * All fields except GRCAL_ARROW_ISO are produced as int32 arrays.
+ * GRCAL_ARROW_ISO is produced as a utf8 string array with dates in
+ * YYYY-MM-DD format.
+ */
+#define GRCAL_ARROW_OFFSET  1
+#define GRCAL_ARROW_YEAR    2
+#define GRCAL_ARROW_MONTH   3
+#define GRCAL_ARROW_DAY     4
+#define GRCAL_ARROW_WEEKDAY 5
+#define GRCAL_ARROW_ISO     6
+
+/*
+ * Convert an Arrow date or timestamp array into grcal day offsets.
+ * 
+ * pOffs receives one day offset for each element of the array.  The
+ * day offset of null elements is set to -1.
+ * 
+ * pValid may be NULL.  Otherwise, it receives an Arrow validity bitmap
+ * for the results, starting at bit zero, with one bit for each element
+ * of the array.
+ * 
+ * The function fails if the schema format is not supported or if the
+ * array does not have the expected buffers.  In that case, zero is
+ * returned and the output buffers are undefined.
+ * 
+ * Parameters:
+ * 
+ *   pSchema - the schema of the input array
+ * 
+ *   pArray - the input array
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pValid - the bitmap to receive the validity, or NULL
+ * 
+ *   pNulls - pointer to a variable to receive the number of null
+ *   results, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the input is not supported
+ */
+int grcal_arrowOffsets(
+    const struct ArrowSchema * pSchema,
+    const struct ArrowArray  * pArray,
+          int32_t            * pOffs,
+          uint8_t            * pValid,
+          int64_t            * pNulls);
+
+/*
+ * Convert an Arrow date or timestamp array into a newly allocated
+ * Arrow array holding one calendar field of each element.
+ * 
+ * field is one of the GRCAL_ARROW constants.  On success, pOutSchema
+ * and pOutArray are initialized as a released-by-consumer Arrow schema
+ * and array, following the rules of the C Data Interface.  The caller
+ * must eventually invoke their release callbacks.
+ * 
+ * The function fails if the field selector or the input format is not
+ * supported, if the input array does not have the expected buffers, or
+ * if memory could not be allocated.  In that case, zero is returned and
+ * the output structures are not modified.
+ * 
+ * Parameters:
+ * 
+ *   pSchema - the schema of the input array
+ * 
+ *   pArray - the input array
+ * 
+ *   field - the field to produce
+ * 
+ *   pOutSchema - the schema structure to initialize
+ * 
+ *   pOutArray - the array structure to initialize
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if not
+ */
+int grcal_arrowField(
+    const struct ArrowSchema * pSchema,
+    const struct ArrowArray  * pArray,
+          int                  field,
+          struct ArrowSchema * pOutSchema,
+          struct ArrowArray  * pOutArray);
+
+#endif
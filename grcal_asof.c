@@ -0,0 +1,166 @@
+/*
+ * grcal_asof.c
+ * 
+ * Implementation of grcal_asof.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_asof.h"
+#include <stdlib.h>
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static size_t gallop(
+    const int32_t * pRight,
+          size_t    count,
+          size_t    pos,
+          int32_t   x);
+
+/*
+ * Find the first right row after a position whose day offset is after
+ * a given one.
+ * 
+ * Parameters:
+ * 
+ *   pRight - the sorted right day offsets
+ * 
+ *   count - the number of right rows
+ * 
+ *   pos - the position to search from, where every row before it is no
+ *   later than x
+ * 
+ *   x - the day offset to search for
+ * 
+ * Return:
+ * 
+ *   the index of the first row after x, or count if there is none
+ */
+static size_t gallop(
+    const int32_t * pRight,
+          size_t    count,
+          size_t    pos,
+          int32_t   x) {
+  
+  size_t lo = 0;
+  size_t hi = 0;
+  size_t step = 1;
+  size_t mid = 0;
+  
+  if ((pos >= count) || (pRight[pos] > x)) {
+    return pos;
+  }
+  
+  /* Probe ahead in doubling steps, keeping row lo no later than x */
+  lo = pos;
+  while ((step < count - lo) && (pRight[lo + step] <= x)) {
+    lo += step;
+    step *= 2;
+  }
+  hi = (step < count - lo) ? (lo + step) : count;
+  
+  /* The first row after x is after lo and no later than hi */
+  while (hi - lo > 1) {
+    mid = lo + ((hi - lo) / 2);
+    if (pRight[mid] <= x) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  
+  return hi;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_asofJoin function.
+ */
+size_t grcal_asofJoin(
+    const int32_t    * pLeft,
+          size_t       leftCount,
+    const int32_t    * pRight,
+          size_t       rightCount,
+          int32_t      tolerance,
+    const GRCAL_BDAY * pCal,
+          size_t     * pIdx) {
+  
+  size_t matched = 0;
+  size_t pos = 0;
+  size_t i = 0;
+  int32_t x = 0;
+  int32_t r = 0;
+  int late = 0;
+  
+  /* Check parameters */
+  if (((pLeft == NULL) || (pIdx == NULL)) && (leftCount > 0)) {
+    abort();
+  }
+  if ((pRight == NULL) && (rightCount > 0)) {
+    abort();
+  }
+  if (tolerance < GRCAL_ASOF_ANY) {
+    abort();
+  }
+  
+  /* Check that the left column is sorted in a separate pass, so that a
+   * fault occurs before any output is written */
+  for(i = 1; i < leftCount; i++) {
+    if (pLeft[i] < pLeft[i - 1]) {
+      abort();
+    }
+  }
+  
+  /* With a calendar, every day offset must be valid; both columns are
+   * sorted, so checking the first and last rows covers every row */
+  if (pCal != NULL) {
+    if ((leftCount > 0) && ((pLeft[0] < 0) ||
+          (pLeft[leftCount - 1] > GRCAL_DAY_MAX))) {
+      abort();
+    }
+    if ((rightCount > 0) && ((pRight[0] < 0) ||
+          (pRight[rightCount - 1] > GRCAL_DAY_MAX))) {
+      abort();
+    }
+  }
+  
+  for(i = 0; i < leftCount; i++) {
+    x = pLeft[i];
+    
+    /* Every right row before pos is no later than the previous left
+     * row, so also no later than this one */
+    pos = gallop(pRight, rightCount, pos, x);
+    if (pos < 1) {
+      pIdx[i] = GRCAL_ASOF_NONE;
+      continue;
+    }
+    
+    r = pRight[pos - 1];
+    if (tolerance != GRCAL_ASOF_ANY) {
+      if (pCal == NULL) {
+        late = (((int64_t) x - r) > tolerance);
+      } else {
+        late = (x > r) && (grcal_bdayCount(pCal, r + 1, x) > tolerance);
+      }
+      if (late) {
+        pIdx[i] = GRCAL_ASOF_NONE;
+        continue;
+      }
+    }
+    
+    pIdx[i] = pos - 1;
+    matched++;
+  }
+  
+  return matched;
+}
@@ -0,0 +1,96 @@
+#ifndef GRCAL_ASOF_H_INCLUDED
+#define GRCAL_ASOF_H_INCLUDED
+
+/*
+ * grcal_asof.h
+ * ============
+ * 
+ * As-of joins of sorted columns of day offsets.
+ * 
+ * An as-of join matches each row of a left column, such as the dates of
+ * events, with the latest row of a right column, such as the dates of
+ * reference data, whose date is not after it.  If several right rows
+ * have that date, the last of them is matched.  A tolerance can limit
+ * how far back a match may be, in calendar days or in business days.
+ * 
+ * Both columns are sorted, so the join is a single merge pass instead
+ * of a binary search per row.  The pass keeps its position in the right
+ * column and searches forward from it for each left row with galloping,
+ * probing 1, 2, 4, and so on rows ahead before a binary search within
+ * the last step.  When the columns are of similar length, each search
+ * ends after a probe or two.  When the right column is much longer, the
+ * pass skips over it in steps that grow with the distance, and the cost
+ * depends on the length of the left column and only logarithmically on
+ * the length of the right column.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_bday.h"
+#include <stddef.h>
+
+/*
+ * The tolerance value that allows a match of any age.
+ */
+#define GRCAL_ASOF_ANY INT32_C(-1)
+
+/*
+ * The index stored for left rows that have no match.
+ */
+#define GRCAL_ASOF_NONE ((size_t) -1)
+
+/*
+ * Join two sorted columns of day offsets as of each left row.
+ * 
+ * The left column must be sorted in ascending order, or a fault occurs
+ * before any output is written.  The right column must also be sorted
+ * in ascending order.  This is not checked, since the search does not
+ * look at every right row, and the matches are unspecified if it is
+ * not.
+ * 
+ * tolerance is GRCAL_ASOF_ANY, or the greatest allowed age of a match,
+ * where zero only allows matches on the same day.  If pCal is NULL,
+ * the age is the number of calendar days from the right date to the
+ * left date.  Otherwise, it is the number of business days after the
+ * right date up to and including the left date, so that a Friday
+ * matches the following Monday with an age of one.
+ * 
+ * If pCal is not NULL, every day offset must be valid, even if
+ * tolerance is GRCAL_ASOF_ANY.  Otherwise, a fault occurs before any
+ * output is written.  Only the first and last rows of each column are
+ * checked, which covers every row if the columns are sorted.  A fault
+ * also occurs if tolerance is less than GRCAL_ASOF_ANY.
+ * 
+ * pIdx receives, for each left row, the index of the matching right
+ * row, or GRCAL_ASOF_NONE.
+ * 
+ * Parameters:
+ * 
+ *   pLeft - the left day offsets
+ * 
+ *   leftCount - the number of left rows
+ * 
+ *   pRight - the right day offsets
+ * 
+ *   rightCount - the number of right rows
+ * 
+ *   tolerance - the greatest age of a match, or GRCAL_ASOF_ANY
+ * 
+ *   pCal - the business-day calendar to measure ages with, or NULL
+ * 
+ *   pIdx - the array to receive the indices of the matches
+ * 
+ * Return:
+ * 
+ *   the number of left rows that have a match
+ */
+size_t grcal_asofJoin(
+    const int32_t    * pLeft,
+          size_t       leftCount,
+    const int32_t    * pRight,
+          size_t       rightCount,
+          int32_t      tolerance,
+    const GRCAL_BDAY * pCal,
+          size_t     * pIdx);
+
+#endif
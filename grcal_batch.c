@@ -0,0 +1,552 @@
+/*
+ * grcal_batch.c
+ * 
+ * Implementation of grcal_batch.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_batch.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The last year supported in the Gregorian calendar.
+ */
+#define MAX_YEAR 9999
+
+/*
+ * The number of strings converted at a time by the ISO functions.
+ */
+#define ISO_BLOCK 256
+
+/*
+ * The number of records converted at a time by the record functions.
+ */
+#define RECORD_BLOCK 256
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t digits(const char *pc, int n);
+static void checkField(size_t field, size_t stride);
+static void loadField(
+    const unsigned char * pBase,
+          size_t          count,
+          size_t          stride,
+          size_t          field,
+          int32_t       * pDst);
+static void storeField(
+          unsigned char * pBase,
+          size_t          count,
+          size_t          stride,
+          size_t          field,
+    const int32_t       * pSrc);
+
+/*
+ * Parse a fixed number of decimal digits.
+ * 
+ * Parameters:
+ * 
+ *   pc - the digits
+ * 
+ *   n - the number of digits, at most four
+ * 
+ * Return:
+ * 
+ *   the value of the digits, or -1 if any character is not a digit
+ */
+static int32_t digits(const char *pc, int n) {
+  
+  int32_t v = 0;
+  int32_t bad = 0;
+  int32_t c = 0;
+  int i = 0;
+  
+  for(i = 0; i < n; i++) {
+    c = ((int32_t) pc[i]) - '0';
+    bad |= (c < 0) | (c > 9);
+    v = (v * 10) + c;
+  }
+  
+  return bad ? -1 : v;
+}
+
+/*
+ * Fault if a record field does not fit within the record stride.
+ * 
+ * Parameters:
+ * 
+ *   field - the byte offset of an int32_t field
+ * 
+ *   stride - the distance in bytes between records
+ */
+static void checkField(size_t field, size_t stride) {
+  if ((stride < sizeof(int32_t)) ||
+      (field > stride - sizeof(int32_t))) {
+    abort();
+  }
+}
+
+/*
+ * Gather an int32_t field from a run of records.
+ * 
+ * Parameters:
+ * 
+ *   pBase - the first record
+ * 
+ *   count - the number of records
+ * 
+ *   stride - the distance in bytes between records
+ * 
+ *   field - the byte offset of the field
+ * 
+ *   pDst - the array to receive the field values
+ */
+static void loadField(
+    const unsigned char * pBase,
+          size_t          count,
+          size_t          stride,
+          size_t          field,
+          int32_t       * pDst) {
+  
+  size_t i = 0;
+  
+  /* memcpy of a fixed size compiles to a plain load, and it does not
+   * require the field to be aligned */
+  for(i = 0; i < count; i++) {
+    memcpy(&(pDst[i]), pBase + (i * stride) + field, sizeof(int32_t));
+  }
+}
+
+/*
+ * Scatter an int32_t field into a run of records.
+ * 
+ * Parameters:
+ * 
+ *   pBase - the first record
+ * 
+ *   count - the number of records
+ * 
+ *   stride - the distance in bytes between records
+ * 
+ *   field - the byte offset of the field
+ * 
+ *   pSrc - the field values
+ */
+static void storeField(
+          unsigned char * pBase,
+          size_t          count,
+          size_t          stride,
+          size_t          field,
+    const int32_t       * pSrc) {
+  
+  size_t i = 0;
+  
+  for(i = 0; i < count; i++) {
+    memcpy(pBase + (i * stride) + field, &(pSrc[i]), sizeof(int32_t));
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_offsetToDateBatch function.
+ */
+void grcal_offsetToDateBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pYear,
+          int32_t * pMonth,
+          int32_t * pDayOfMonth) {
+  
+  size_t i = 0;
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t doy = 0;
+  
+  /* Check parameters */
+  if ((pOffs == NULL) && (count > 0)) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  /* Convert each offset with the closed-form arithmetic of
+   * grcal_priv.h, which avoids the month table walk */
+  for(i = 0; i < count; i++) {
+    grcal_privSplit(pOffs[i], &year, &month, &day, &doy);
+    
+    if (pYear != NULL) {
+      pYear[i] = year;
+    }
+    if (pMonth != NULL) {
+      pMonth[i] = month;
+    }
+    if (pDayOfMonth != NULL) {
+      pDayOfMonth[i] = day;
+    }
+  }
+}
+
+/*
+ * grcal_dateToOffsetBatch function.
+ */
+size_t grcal_dateToOffsetBatch(
+    const int32_t * pYear,
+    const int32_t * pMonth,
+    const int32_t * pDayOfMonth,
+          size_t    count,
+          int32_t * pOffs) {
+  
+  size_t i = 0;
+  size_t invalid = 0;
+  
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t ml = 0;
+  int32_t ok = 0;
+  int32_t offs = 0;
+  
+  /* Check parameters */
+  if (((pYear == NULL) || (pMonth == NULL) || (pDayOfMonth == NULL) ||
+        (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    year  = pYear[i];
+    month = pMonth[i];
+    day   = pDayOfMonth[i];
+    
+    /* Check year and month range, then substitute a safe date for
+     * invalid elements so the arithmetic below can not overflow */
+    ok = (year > GRCAL_PRIV_BASE_YEAR) & (year <= MAX_YEAR) &
+          (month >= 1) & (month <= 12) & (day >= 1);
+    year  = ok ? year  : 2000;
+    month = ok ? month : 1;
+    day   = ok ? day   : 1;
+    
+    /* Check day against the month length */
+    ml = grcal_privMonthDays(year, month);
+    ok &= (day <= ml);
+    
+    offs = grcal_privCompose(year, month, day);
+    
+    /* Days before 1582-10-15 are not valid */
+    ok &= ((offs >= 0) & (offs <= GRCAL_DAY_MAX));
+    
+    pOffs[i] = ok ? offs : -1;
+    invalid += (size_t) (!ok);
+  }
+  
+  return invalid;
+}
+
+/*
+ * grcal_weekdayBatch function.
+ */
+void grcal_weekdayBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pWeekday) {
+  
+  size_t i = 0;
+  
+  /* Check parameters */
+  if (((pOffs == NULL) || (pWeekday == NULL)) && (count > 0)) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  /* Day offset zero is a Friday */
+  for(i = 0; i < count; i++) {
+    pWeekday[i] = ((pOffs[i] + 4) % 7) + 1;
+  }
+}
+
+/*
+ * grcal_isoToOffsetBatch function.
+ */
+size_t grcal_isoToOffsetBatch(
+    const char    * pStr,
+          size_t    stride,
+          size_t    count,
+          int32_t * pOffs) {
+  
+  int32_t y[ISO_BLOCK];
+  int32_t m[ISO_BLOCK];
+  int32_t d[ISO_BLOCK];
+  
+  const char *pc = NULL;
+  size_t invalid = 0;
+  size_t pos = 0;
+  size_t n = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  if (stride < GRCAL_ISO_LENGTH) {
+    abort();
+  }
+  if (((pStr == NULL) || (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  /* Parse a block of strings into fields, marking malformed strings
+   * with an invalid year, then convert the block */
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > ISO_BLOCK) {
+      n = ISO_BLOCK;
+    }
+    
+    for(i = 0; i < n; i++) {
+      pc = pStr + ((pos + i) * stride);
+      y[i] = digits(pc, 4);
+      m[i] = digits(pc + 5, 2);
+      d[i] = digits(pc + 8, 2);
+      if ((pc[4] != '-') || (pc[7] != '-')) {
+        y[i] = -1;
+      }
+    }
+    
+    invalid += grcal_dateToOffsetBatch(y, m, d, n, pOffs + pos);
+  }
+  
+  return invalid;
+}
+
+/*
+ * grcal_offsetToIsoBatch function.
+ */
+void grcal_offsetToIsoBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          char    * pStr,
+          size_t    stride) {
+  
+  int32_t y[ISO_BLOCK];
+  int32_t m[ISO_BLOCK];
+  int32_t d[ISO_BLOCK];
+  
+  char *pc = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  if (stride < GRCAL_ISO_LENGTH) {
+    abort();
+  }
+  if (((pStr == NULL) || (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > ISO_BLOCK) {
+      n = ISO_BLOCK;
+    }
+    
+    grcal_offsetToDateBatch(pOffs + pos, n, y, m, d);
+    
+    for(i = 0; i < n; i++) {
+      pc = pStr + ((pos + i) * stride);
+      pc[0] = (char) ('0' + (y[i] / 1000));
+      pc[1] = (char) ('0' + ((y[i] / 100) % 10));
+      pc[2] = (char) ('0' + ((y[i] / 10) % 10));
+      pc[3] = (char) ('0' + (y[i] % 10));
+      pc[4] = '-';
+      pc[5] = (char) ('0' + (m[i] / 10));
+      pc[6] = (char) ('0' + (m[i] % 10));
+      pc[7] = '-';
+      pc[8] = (char) ('0' + (d[i] / 10));
+      pc[9] = (char) ('0' + (d[i] % 10));
+    }
+  }
+}
+
+/*
+ * grcal_offsetToDateRecords function.
+ */
+void grcal_offsetToDateRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   offsField,
+    size_t   yearField,
+    size_t   monthField,
+    size_t   dayField) {
+  
+  int32_t o[RECORD_BLOCK];
+  int32_t y[RECORD_BLOCK];
+  int32_t m[RECORD_BLOCK];
+  int32_t d[RECORD_BLOCK];
+  
+  unsigned char *pBase = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  
+  /* Check parameters */
+  if ((pRecords == NULL) && (count > 0)) {
+    abort();
+  }
+  checkField(offsField, stride);
+  if (yearField != GRCAL_FIELD_NONE) {
+    checkField(yearField, stride);
+  }
+  if (monthField != GRCAL_FIELD_NONE) {
+    checkField(monthField, stride);
+  }
+  if (dayField != GRCAL_FIELD_NONE) {
+    checkField(dayField, stride);
+  }
+  pBase = (unsigned char *) pRecords;
+  
+  /* Check every offset before writing anything */
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > RECORD_BLOCK) {
+      n = RECORD_BLOCK;
+    }
+    loadField(pBase + (pos * stride), n, stride, offsField, o);
+    if (grcal_privBadOffsets(o, n)) {
+      abort();
+    }
+  }
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > RECORD_BLOCK) {
+      n = RECORD_BLOCK;
+    }
+    
+    loadField(pBase + (pos * stride), n, stride, offsField, o);
+    grcal_offsetToDateBatch(o, n, y, m, d);
+    
+    if (yearField != GRCAL_FIELD_NONE) {
+      storeField(pBase + (pos * stride), n, stride, yearField, y);
+    }
+    if (monthField != GRCAL_FIELD_NONE) {
+      storeField(pBase + (pos * stride), n, stride, monthField, m);
+    }
+    if (dayField != GRCAL_FIELD_NONE) {
+      storeField(pBase + (pos * stride), n, stride, dayField, d);
+    }
+  }
+}
+
+/*
+ * grcal_dateToOffsetRecords function.
+ */
+size_t grcal_dateToOffsetRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   yearField,
+    size_t   monthField,
+    size_t   dayField,
+    size_t   offsField) {
+  
+  int32_t o[RECORD_BLOCK];
+  int32_t y[RECORD_BLOCK];
+  int32_t m[RECORD_BLOCK];
+  int32_t d[RECORD_BLOCK];
+  
+  unsigned char *pBase = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  size_t invalid = 0;
+  
+  /* Check parameters */
+  if ((pRecords == NULL) && (count > 0)) {
+    abort();
+  }
+  checkField(yearField, stride);
+  checkField(monthField, stride);
+  checkField(dayField, stride);
+  checkField(offsField, stride);
+  pBase = (unsigned char *) pRecords;
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > RECORD_BLOCK) {
+      n = RECORD_BLOCK;
+    }
+    
+    loadField(pBase + (pos * stride), n, stride, yearField, y);
+    loadField(pBase + (pos * stride), n, stride, monthField, m);
+    loadField(pBase + (pos * stride), n, stride, dayField, d);
+    invalid += grcal_dateToOffsetBatch(y, m, d, n, o);
+    storeField(pBase + (pos * stride), n, stride, offsField, o);
+  }
+  
+  return invalid;
+}
+
+/*
+ * grcal_weekdayRecords function.
+ */
+void grcal_weekdayRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   offsField,
+    size_t   weekdayField) {
+  
+  int32_t o[RECORD_BLOCK];
+  
+  unsigned char *pBase = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  
+  /* Check parameters */
+  if ((pRecords == NULL) && (count > 0)) {
+    abort();
+  }
+  checkField(offsField, stride);
+  checkField(weekdayField, stride);
+  pBase = (unsigned char *) pRecords;
+  
+  /* Check every offset before writing anything */
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > RECORD_BLOCK) {
+      n = RECORD_BLOCK;
+    }
+    loadField(pBase + (pos * stride), n, stride, offsField, o);
+    if (grcal_privBadOffsets(o, n)) {
+      abort();
+    }
+  }
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > RECORD_BLOCK) {
+      n = RECORD_BLOCK;
+    }
+    
+    loadField(pBase + (pos * stride), n, stride, offsField, o);
+    grcal_weekdayBatch(o, n, o);
+    storeField(pBase + (pos * stride), n, stride, weekdayField, o);
+  }
+}
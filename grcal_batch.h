@@ -0,0 +1,297 @@
+#ifndef GRCAL_BATCH_H_INCLUDED
+#define GRCAL_BATCH_H_INCLUDED
+
+/*
+ * grcal_batch.h
+ * =============
+ * 
+ * Array versions of the core grcal conversions.
+ * 
+ * These functions produce exactly the same results as calling the
+ * grcal.h functions on each element, but they are structured so that
+ * the compiler can vectorize the inner loops.  The date arithmetic uses
+ * closed-form expressions rather than the month table walk that the
+ * scalar functions use.
+ * 
+ * Year, month, day, and weekday values are passed as int32_t arrays
+ * rather than int so that the memory layout is the same on all
+ * platforms.
+ * 
+ * Input and output arrays may not overlap, except where noted.
+ */
+
+#include "grcal.h"
+
+/*
+ * The number of characters in a date in YYYY-MM-DD format, not
+ * including any terminating nul.
+ */
+#define GRCAL_ISO_LENGTH 10
+
+/*
+ * Convert an array of Gregorian day offsets into years, months, and
+ * days of month.
+ * 
+ * Every day offset must be in range zero up to and including
+ * GRCAL_DAY_MAX or a fault occurs.  In that case, the fault occurs
+ * before any output is written.
+ * 
+ * You may pass NULL for any output arrays that you do not require.
+ * Each non-NULL output array must have room for count elements.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets to convert
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pYear - the array to receive the years, or NULL
+ * 
+ *   pMonth - the array to receive the months, or NULL
+ * 
+ *   pDayOfMonth - the array to receive the days of the month, or NULL
+ */
+void grcal_offsetToDateBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pYear,
+          int32_t * pMonth,
+          int32_t * pDayOfMonth);
+
+/*
+ * Convert arrays of Gregorian years, months, and days of month into day
+ * offsets.
+ * 
+ * Elements that are not valid Gregorian dates, as defined by
+ * grcal_dateToOffset(), receive a day offset of -1 in the output.
+ * 
+ * The output array may be the same as one of the input arrays.
+ * 
+ * Parameters:
+ * 
+ *   pYear - the years
+ * 
+ *   pMonth - the months
+ * 
+ *   pDayOfMonth - the days of the month
+ * 
+ *   count - the number of elements in each array
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of elements that were not valid dates
+ */
+size_t grcal_dateToOffsetBatch(
+    const int32_t * pYear,
+    const int32_t * pMonth,
+    const int32_t * pDayOfMonth,
+          size_t    count,
+          int32_t * pOffs);
+
+/*
+ * Convert an array of Gregorian day offsets into weekdays.
+ * 
+ * Every day offset must be in range zero up to and including
+ * GRCAL_DAY_MAX or a fault occurs.  In that case, the fault occurs
+ * before any output is written.
+ * 
+ * The weekdays are one for Monday up to seven for Sunday, as in
+ * grcal_weekday().  The output array may be the same as the input
+ * array.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pWeekday - the array to receive the weekdays
+ */
+void grcal_weekdayBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pWeekday);
+
+/*
+ * Convert an array of dates in YYYY-MM-DD format into day offsets.
+ * 
+ * The strings are fixed-width and need not be nul-terminated.  String i
+ * begins stride bytes after string i - 1, and stride must be at least
+ * GRCAL_ISO_LENGTH or a fault occurs.
+ * 
+ * Elements that are not exactly four digits, a hyphen, two digits, a
+ * hyphen, and two digits, or that are not valid dates according to
+ * grcal_dateToOffset(), receive a day offset of -1 in the output.
+ * 
+ * Parameters:
+ * 
+ *   pStr - the first date string
+ * 
+ *   stride - the distance in bytes between date strings
+ * 
+ *   count - the number of date strings
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of elements that were not valid dates
+ */
+size_t grcal_isoToOffsetBatch(
+    const char    * pStr,
+          size_t    stride,
+          size_t    count,
+          int32_t * pOffs);
+
+/*
+ * Convert an array of day offsets into dates in YYYY-MM-DD format.
+ * 
+ * Every day offset must be in range zero up to and including
+ * GRCAL_DAY_MAX or a fault occurs.
+ * 
+ * Exactly GRCAL_ISO_LENGTH characters are written for each date, with
+ * no terminating nul.  String i begins stride bytes after string i - 1,
+ * and stride must be at least GRCAL_ISO_LENGTH or a fault occurs.
+ * Bytes between the strings are not modified.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pStr - the buffer to receive the first date string
+ * 
+ *   stride - the distance in bytes between date strings
+ */
+void grcal_offsetToIsoBatch(
+    const int32_t * pOffs,
+          size_t    count,
+          char    * pStr,
+          size_t    stride);
+
+/*
+ * Record conversions
+ * ------------------
+ * 
+ * The record functions below work on caller-defined records, such as
+ * an array of structures, without copying the fields out into separate
+ * arrays first.  Record i begins stride bytes after record i - 1, and
+ * each field is an int32_t at the given byte offset within every
+ * record, as given by offsetof().  Fields need not be aligned.  Each
+ * field must lie entirely within stride bytes, or a fault occurs.
+ */
+
+/*
+ * Field offset that means a field is not present.
+ */
+#define GRCAL_FIELD_NONE ((size_t) -1)
+
+/*
+ * Convert day offsets stored inside an array of records into years,
+ * months, and days of month stored in the same records.
+ * 
+ * Every day offset must be in range zero up to and including
+ * GRCAL_DAY_MAX or a fault occurs.  In that case, the fault occurs
+ * before any output is written.
+ * 
+ * Any output field may be GRCAL_FIELD_NONE if it is not required.  An
+ * output field may be the same as the input field, but the output
+ * fields must not overlap each other.
+ * 
+ * Parameters:
+ * 
+ *   pRecords - the first record
+ * 
+ *   count - the number of records
+ * 
+ *   stride - the distance in bytes between records
+ * 
+ *   offsField - the offset of the day offset field
+ * 
+ *   yearField - the offset of the field to receive the year, or
+ *   GRCAL_FIELD_NONE
+ * 
+ *   monthField - the offset of the field to receive the month, or
+ *   GRCAL_FIELD_NONE
+ * 
+ *   dayField - the offset of the field to receive the day of the month,
+ *   or GRCAL_FIELD_NONE
+ */
+void grcal_offsetToDateRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   offsField,
+    size_t   yearField,
+    size_t   monthField,
+    size_t   dayField);
+
+/*
+ * Convert years, months, and days of month stored inside an array of
+ * records into day offsets stored in the same records.
+ * 
+ * Records and fields are as for grcal_offsetToDateRecords().  Records
+ * that do not hold valid dates receive a day offset of -1, as in
+ * grcal_dateToOffsetBatch().  The output field may be the same as one
+ * of the input fields.
+ * 
+ * Parameters:
+ * 
+ *   pRecords - the first record
+ * 
+ *   count - the number of records
+ * 
+ *   stride - the distance in bytes between records
+ * 
+ *   yearField - the offset of the year field
+ * 
+ *   monthField - the offset of the month field
+ * 
+ *   dayField - the offset of the day of the month field
+ * 
+ *   offsField - the offset of the field to receive the day offset
+ * 
+ * Return:
+ * 
+ *   the number of records that did not hold valid dates
+ */
+size_t grcal_dateToOffsetRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   yearField,
+    size_t   monthField,
+    size_t   dayField,
+    size_t   offsField);
+
+/*
+ * Convert day offsets stored inside an array of records into weekdays
+ * stored in the same records.
+ * 
+ * Records and fields are as for grcal_offsetToDateRecords(), and the
+ * weekdays are as for grcal_weekdayBatch().  The output field may be
+ * the same as the input field.
+ * 
+ * Parameters:
+ * 
+ *   pRecords - the first record
+ * 
+ *   count - the number of records
+ * 
+ *   stride - the distance in bytes between records
+ * 
+ *   offsField - the offset of the day offset field
+ * 
+ *   weekdayField - the offset of the field to receive the weekday
+ */
+void grcal_weekdayRecords(
+    void   * pRecords,
+    size_t   count,
+    size_t   stride,
+    size_t   offsField,
+    size_t   weekdayField);
+
+#endif
@@ -0,0 +1,470 @@
+/*
+ * grcal_bday.c
+ * 
+ * Implementation of grcal_bday.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_bday.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of 64-bit words in a calendar bitmap.
+ */
+#define WORD_COUNT ((GRCAL_DAY_MAX / 64) + 1)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * GRCAL_BDAY structure.
+ */
+struct GRCAL_BDAY_TAG {
+  
+  /*
+   * The bitmap, where bit (offs % 64) of word (offs / 64) is set if
+   * day offset offs is a business day.  Bits past GRCAL_DAY_MAX are
+   * always clear.
+   */
+  uint64_t *pBits;
+  
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int popCount(uint64_t v);
+static int lowBit(uint64_t v);
+static int highBit(uint64_t v);
+static int selectLow(uint64_t v, int32_t n);
+static int selectHigh(uint64_t v, int32_t n);
+
+/*
+ * Count the set bits in a word.
+ * 
+ * Parameters:
+ * 
+ *   v - the word
+ * 
+ * Return:
+ * 
+ *   the number of set bits
+ */
+static int popCount(uint64_t v) {
+#ifdef __GNUC__
+  return __builtin_popcountll((unsigned long long) v);
+#else
+  v = v - ((v >> 1) & UINT64_C(0x5555555555555555));
+  v = (v & UINT64_C(0x3333333333333333)) +
+        ((v >> 2) & UINT64_C(0x3333333333333333));
+  v = (v + (v >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (int) ((v * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/*
+ * Find the lowest set bit in a non-zero word.
+ * 
+ * Parameters:
+ * 
+ *   v - the word, which must not be zero
+ * 
+ * Return:
+ * 
+ *   the index of the lowest set bit
+ */
+static int lowBit(uint64_t v) {
+#ifdef __GNUC__
+  return __builtin_ctzll((unsigned long long) v);
+#else
+  int i = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/*
+ * Find the highest set bit in a non-zero word.
+ * 
+ * Parameters:
+ * 
+ *   v - the word, which must not be zero
+ * 
+ * Return:
+ * 
+ *   the index of the highest set bit
+ */
+static int highBit(uint64_t v) {
+#ifdef __GNUC__
+  return 63 - __builtin_clzll((unsigned long long) v);
+#else
+  int i = 63;
+  while (!(v >> 63)) {
+    v <<= 1;
+    i--;
+  }
+  return i;
+#endif
+}
+
+/*
+ * Find the n-th lowest set bit in a word.
+ * 
+ * Parameters:
+ * 
+ *   v - the word, which must have at least n bits set
+ * 
+ *   n - the one-based rank of the bit
+ * 
+ * Return:
+ * 
+ *   the index of the bit
+ */
+static int selectLow(uint64_t v, int32_t n) {
+  for( ; n > 1; n--) {
+    v &= v - 1;
+  }
+  return lowBit(v);
+}
+
+/*
+ * Find the n-th highest set bit in a word.
+ * 
+ * Parameters:
+ * 
+ *   v - the word, which must have at least n bits set
+ * 
+ *   n - the one-based rank of the bit
+ * 
+ * Return:
+ * 
+ *   the index of the bit
+ */
+static int selectHigh(uint64_t v, int32_t n) {
+  for( ; n > 1; n--) {
+    v &= ~(((uint64_t) 1) << highBit(v));
+  }
+  return highBit(v);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_bdayNew function.
+ */
+GRCAL_BDAY *grcal_bdayNew(int weekend) {
+  
+  GRCAL_BDAY *pc = NULL;
+  uint64_t pattern[7];
+  int32_t offs = 0;
+  int32_t i = 0;
+  int w = 0;
+  int k = 0;
+  
+  /* Check parameter */
+  if ((weekend < 0) || (weekend > 0x7f)) {
+    abort();
+  }
+  
+  /* Allocate */
+  pc = (GRCAL_BDAY *) calloc(1, sizeof(GRCAL_BDAY));
+  if (pc == NULL) {
+    return NULL;
+  }
+  pc->pBits = (uint64_t *) calloc(WORD_COUNT, sizeof(uint64_t));
+  if (pc->pBits == NULL) {
+    free(pc);
+    return NULL;
+  }
+  
+  /* Since 64 days is one more than a multiple of seven, the bitmap
+   * words cycle through seven patterns; word i starts on the same
+   * weekday as day offset i, so build the pattern for each weekday */
+  for(k = 0; k < 7; k++) {
+    pattern[k] = 0;
+    for(i = 0; i < 64; i++) {
+      w = (int) ((k + i + 4) % 7);
+      if (!(weekend & (1 << w))) {
+        pattern[k] |= ((uint64_t) 1) << i;
+      }
+    }
+  }
+  
+  for(i = 0; i < WORD_COUNT; i++) {
+    (pc->pBits)[i] = pattern[i % 7];
+  }
+  
+  /* Clear the bits past the end of the range */
+  offs = GRCAL_DAY_MAX + 1;
+  if (offs % 64) {
+    (pc->pBits)[WORD_COUNT - 1] &=
+      (((uint64_t) 1) << (offs % 64)) - 1;
+  }
+  
+  return pc;
+}
+
+/*
+ * grcal_bdayFree function.
+ */
+void grcal_bdayFree(GRCAL_BDAY *pCal) {
+  if (pCal != NULL) {
+    free(pCal->pBits);
+    free(pCal);
+  }
+}
+
+/*
+ * grcal_bdaySet function.
+ */
+void grcal_bdaySet(GRCAL_BDAY *pCal, int32_t offs, int business) {
+  
+  uint64_t bit = 0;
+  
+  if ((pCal == NULL) || (offs < 0) || (offs > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  bit = ((uint64_t) 1) << (offs % 64);
+  if (business) {
+    (pCal->pBits)[offs / 64] |= bit;
+  } else {
+    (pCal->pBits)[offs / 64] &= ~bit;
+  }
+}
+
+/*
+ * grcal_bdayIs function.
+ */
+int grcal_bdayIs(const GRCAL_BDAY *pCal, int32_t offs) {
+  
+  if ((pCal == NULL) || (offs < 0) || (offs > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  return (int) (((pCal->pBits)[offs / 64] >> (offs % 64)) & 1);
+}
+
+/*
+ * grcal_bdayCount function.
+ */
+int32_t grcal_bdayCount(
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last) {
+  
+  const uint64_t *pw = NULL;
+  int32_t wf = 0;
+  int32_t wl = 0;
+  int32_t i = 0;
+  int32_t result = 0;
+  uint64_t mf = 0;
+  uint64_t ml = 0;
+  
+  /* Check parameters */
+  if (pCal == NULL) {
+    abort();
+  }
+  if (last < first) {
+    return 0;
+  }
+  if ((first < 0) || (last > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  /* Masks for the partial words at each end */
+  pw = pCal->pBits;
+  wf = first / 64;
+  wl = last / 64;
+  mf = ~((((uint64_t) 1) << (first % 64)) - 1);
+  ml = (last % 64 == 63) ? ~((uint64_t) 0)
+          : ((((uint64_t) 1) << ((last % 64) + 1)) - 1);
+  
+  if (wf == wl) {
+    return popCount(pw[wf] & mf & ml);
+  }
+  
+  result = popCount(pw[wf] & mf) + popCount(pw[wl] & ml);
+  for(i = wf + 1; i < wl; i++) {
+    result += popCount(pw[i]);
+  }
+  
+  return result;
+}
+
+/*
+ * grcal_bdayCountArray function.
+ */
+size_t grcal_bdayCountArray(
+    const GRCAL_BDAY * pCal,
+    const int32_t    * pOffs,
+          size_t       count) {
+  
+  const uint64_t *pw = NULL;
+  uint32_t x = 0;
+  size_t result = 0;
+  size_t i = 0;
+  
+  /* Check parameters, checking every entry before any bit is read */
+  if ((pCal == NULL) || ((pOffs == NULL) && (count > 0))) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  pw = pCal->pBits;
+  for(i = 0; i < count; i++) {
+    x = (uint32_t) pOffs[i];
+    result += (size_t) ((pw[x / 64] >> (x % 64)) & 1);
+  }
+  
+  return result;
+}
+
+/*
+ * grcal_bdayNext function.
+ */
+int32_t grcal_bdayNext(const GRCAL_BDAY *pCal, int32_t offs) {
+  
+  const uint64_t *pw = NULL;
+  int32_t i = 0;
+  uint64_t v = 0;
+  
+  if ((pCal == NULL) || (offs < 0) || (offs > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  pw = pCal->pBits;
+  i = offs / 64;
+  v = pw[i] & ~((((uint64_t) 1) << (offs % 64)) - 1);
+  while (v == 0) {
+    i++;
+    if (i >= WORD_COUNT) {
+      return -1;
+    }
+    v = pw[i];
+  }
+  
+  return (i * 64) + lowBit(v);
+}
+
+/*
+ * grcal_bdayPrev function.
+ */
+int32_t grcal_bdayPrev(const GRCAL_BDAY *pCal, int32_t offs) {
+  
+  const uint64_t *pw = NULL;
+  int32_t i = 0;
+  uint64_t v = 0;
+  
+  if ((pCal == NULL) || (offs < 0) || (offs > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  pw = pCal->pBits;
+  i = offs / 64;
+  v = pw[i];
+  if (offs % 64 != 63) {
+    v &= (((uint64_t) 1) << ((offs % 64) + 1)) - 1;
+  }
+  while (v == 0) {
+    i--;
+    if (i < 0) {
+      return -1;
+    }
+    v = pw[i];
+  }
+  
+  return (i * 64) + highBit(v);
+}
+
+/*
+ * grcal_bdayAdd function.
+ */
+int32_t grcal_bdayAdd(const GRCAL_BDAY *pCal, int32_t offs, int32_t n) {
+  
+  const uint64_t *pw = NULL;
+  int32_t i = 0;
+  int32_t c = 0;
+  uint64_t v = 0;
+  
+  if ((pCal == NULL) || (offs < 0) || (offs > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  pw = pCal->pBits;
+  
+  /* Steps longer than the whole range can not succeed */
+  if ((n > GRCAL_DAY_MAX) || (n < -GRCAL_DAY_MAX)) {
+    return -1;
+  }
+  
+  if (n > 0) {
+    /* Count business days forward, starting just after offs */
+    if (offs == GRCAL_DAY_MAX) {
+      return -1;
+    }
+    offs++;
+    i = offs / 64;
+    v = pw[i] & ~((((uint64_t) 1) << (offs % 64)) - 1);
+    for(;;) {
+      c = popCount(v);
+      if (c >= n) {
+        return (i * 64) + selectLow(v, n);
+      }
+      n -= c;
+      i++;
+      if (i >= WORD_COUNT) {
+        return -1;
+      }
+      v = pw[i];
+    }
+    
+  } else if (n < 0) {
+    /* Count business days backward, starting just before offs */
+    if (offs == 0) {
+      return -1;
+    }
+    offs--;
+    n = -n;
+    i = offs / 64;
+    v = pw[i];
+    if (offs % 64 != 63) {
+      v &= (((uint64_t) 1) << ((offs % 64) + 1)) - 1;
+    }
+    for(;;) {
+      c = popCount(v);
+      if (c >= n) {
+        return (i * 64) + selectHigh(v, n);
+      }
+      n -= c;
+      i--;
+      if (i < 0) {
+        return -1;
+      }
+      v = pw[i];
+    }
+  }
+  
+  return offs;
+}
@@ -0,0 +1,217 @@
+#ifndef GRCAL_BDAY_H_INCLUDED
+#define GRCAL_BDAY_H_INCLUDED
+
+/*
+ * grcal_bday.h
+ * ============
+ * 
+ * Business-day calendars.
+ * 
+ * A GRCAL_BDAY is a bitmap with one bit for every valid day offset,
+ * set if that day is a business day.  A new calendar marks the days of
+ * the week that are not in its weekend mask as business days; holidays
+ * and other exceptions are then set one day at a time.
+ * 
+ * The bitmap takes about 384 kilobytes regardless of the weekend mask
+ * or the number of holidays, and queries over ranges of days work on
+ * 64 days at a time.
+ * 
+ * A calendar may be queried from any number of threads at once, but it
+ * may not be modified while it is being queried.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Weekend masks for grcal_bdayNew().
+ * 
+ * Bit (w - 1) is set if weekday w is not a business day, where one is
+ * Monday, the same numbering as grcal_weekday().
+ */
+#define GRCAL_BDAY_SAT_SUN 0x60
+#define GRCAL_BDAY_FRI_SAT 0x30
+#define GRCAL_BDAY_SUN 0x40
+#define GRCAL_BDAY_NONE 0x00
+
+/*
+ * Opaque business-day calendar structure.
+ */
+struct GRCAL_BDAY_TAG;
+typedef struct GRCAL_BDAY_TAG GRCAL_BDAY;
+
+/*
+ * Create a new business-day calendar with no holidays.
+ * 
+ * weekend is a weekend mask, normally one of the GRCAL_BDAY constants.
+ * Only the low seven bits may be set or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   weekend - the weekend mask
+ * 
+ * Return:
+ * 
+ *   the new calendar, or NULL if memory could not be allocated
+ */
+GRCAL_BDAY *grcal_bdayNew(int weekend);
+
+/*
+ * Release a business-day calendar.
+ * 
+ * Does nothing if NULL is passed.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar to release, or NULL
+ */
+void grcal_bdayFree(GRCAL_BDAY *pCal);
+
+/*
+ * Mark a single day as a business day or not.
+ * 
+ * This is how holidays are entered, and how weekend days can be made
+ * into business days.  A fault occurs if the day offset is out of
+ * range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   offs - the day offset
+ * 
+ *   business - non-zero to make the day a business day, zero to make it
+ *   a non-business day
+ */
+void grcal_bdaySet(GRCAL_BDAY *pCal, int32_t offs, int business);
+
+/*
+ * Determine whether a day is a business day.
+ * 
+ * A fault occurs if the day offset is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   offs - the day offset
+ * 
+ * Return:
+ * 
+ *   non-zero if the day is a business day, zero if not
+ */
+int grcal_bdayIs(const GRCAL_BDAY *pCal, int32_t offs);
+
+/*
+ * Count the business days in a range of days.
+ * 
+ * The range is inclusive at both ends.  If last is less than first,
+ * the range is empty and zero is returned.  Otherwise, a fault occurs
+ * if either end is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   first - the day offset of the first day in the range
+ * 
+ *   last - the day offset of the last day in the range
+ * 
+ * Return:
+ * 
+ *   the number of business days in the range
+ */
+int32_t grcal_bdayCount(
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last);
+
+/*
+ * Count the business days in an array of day offsets.
+ * 
+ * Each entry is counted separately, so a day that appears more than
+ * once is counted each time.  A fault occurs if any entry is out of
+ * range.  The loops have no branches, so the count is cheap enough to
+ * check whether a whole block of day offsets are business days.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ * Return:
+ * 
+ *   the number of entries that are business days
+ */
+size_t grcal_bdayCountArray(
+    const GRCAL_BDAY * pCal,
+    const int32_t    * pOffs,
+          size_t       count);
+
+/*
+ * Find the first business day on or after a given day.
+ * 
+ * A fault occurs if the day offset is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   offs - the day offset to start from
+ * 
+ * Return:
+ * 
+ *   the day offset of the business day, or -1 if there are no business
+ *   days from offs up to GRCAL_DAY_MAX
+ */
+int32_t grcal_bdayNext(const GRCAL_BDAY *pCal, int32_t offs);
+
+/*
+ * Find the last business day on or before a given day.
+ * 
+ * A fault occurs if the day offset is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   offs - the day offset to start from
+ * 
+ * Return:
+ * 
+ *   the day offset of the business day, or -1 if there are no business
+ *   days from day zero up to offs
+ */
+int32_t grcal_bdayPrev(const GRCAL_BDAY *pCal, int32_t offs);
+
+/*
+ * Step a number of business days away from a given day.
+ * 
+ * If n is positive, the result is the n-th business day after offs.
+ * If n is negative, it is the n-th business day before offs.  Whether
+ * offs itself is a business day does not matter.  If n is zero, offs
+ * is returned unchanged.
+ * 
+ * A fault occurs if the day offset is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pCal - the calendar
+ * 
+ *   offs - the day offset to start from
+ * 
+ *   n - the number of business days to step
+ * 
+ * Return:
+ * 
+ *   the day offset of the business day, or -1 if the range of day
+ *   offsets runs out first
+ */
+int32_t grcal_bdayAdd(const GRCAL_BDAY *pCal, int32_t offs, int32_t n);
+
+#endif
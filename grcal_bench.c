@@ -0,0 +1,227 @@
+/*
+ * grcal_bench.c
+ * =============
+ * 
+ * Benchmark the grcal library routines.
+ * 
+ * Syntax
+ * ------
+ * 
+ *   grcal_bench [rounds]
+ * 
+ * Operation
+ * ---------
+ * 
+ * Runs each of the core grcal conversions over the full range of day
+ * offsets and dates that the library supports, repeating the whole
+ * workload the given number of rounds (default 4).  The average time
+ * per call of each function is reported in nanoseconds to standard
+ * output, along with a checksum of the results so that the compiler
+ * can not discard the work.
+ * 
+ * This program is also the training workload for profile-guided
+ * builds of the library.  See the Makefile for the available library
+ * variants and the "bench" target that compares them.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Must be built with the grcal library.  Sample invocation for gcc:
+ * 
+ *   gcc -O2 -o grcal_bench grcal_bench.c grcal.c
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "grcal.h"
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The default number of rounds to run.
+ */
+#define DEFAULT_ROUNDS 4
+
+/*
+ * The maximum number of rounds that may be requested.
+ */
+#define MAX_ROUNDS 1000
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static double elapsedNs(clock_t t0, clock_t t1, double calls);
+static uint32_t benchOffsetToDate(void);
+static uint32_t benchDateToOffset(double *pCalls);
+static uint32_t benchWeekday(void);
+
+/*
+ * Compute the average time per call in nanoseconds.
+ * 
+ * Parameters:
+ * 
+ *   t0 - the clock value at the start of the measurement
+ * 
+ *   t1 - the clock value at the end of the measurement
+ * 
+ *   calls - the total number of calls made during the measurement
+ * 
+ * Return:
+ * 
+ *   the average nanoseconds per call
+ */
+static double elapsedNs(clock_t t0, clock_t t1, double calls) {
+  if (calls <= 0.0) {
+    return 0.0;
+  }
+  return (((double) (t1 - t0)) / ((double) CLOCKS_PER_SEC)) * 1.0e9
+            / calls;
+}
+
+/*
+ * Convert every valid day offset to a date.
+ * 
+ * Return:
+ * 
+ *   a checksum of the results
+ */
+static uint32_t benchOffsetToDate(void) {
+  
+  uint32_t sum = 0;
+  int32_t offs = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  for(offs = 0; offs <= GRCAL_DAY_MAX; offs++) {
+    grcal_offsetToDate(offs, &y, &m, &d);
+    sum += (uint32_t) (y + m + d);
+  }
+  
+  return sum;
+}
+
+/*
+ * Convert every year-month-day combination with a day of month in range
+ * one to 31 to a day offset, including the invalid ones.
+ * 
+ * Parameters:
+ * 
+ *   pCalls - pointer to a value that is incremented by the number of
+ *   calls made
+ * 
+ * Return:
+ * 
+ *   a checksum of the results
+ */
+static uint32_t benchDateToOffset(double *pCalls) {
+  
+  uint32_t sum = 0;
+  int32_t offs = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  for(y = 1582; y <= 9999; y++) {
+    for(m = 1; m <= 12; m++) {
+      for(d = 1; d <= 31; d++) {
+        if (grcal_dateToOffset(&offs, y, m, d)) {
+          sum += (uint32_t) offs;
+        }
+      }
+    }
+  }
+  
+  *pCalls += (double) (9999 - 1582 + 1) * 12.0 * 31.0;
+  return sum;
+}
+
+/*
+ * Compute the weekday of every valid day offset.
+ * 
+ * Return:
+ * 
+ *   a checksum of the results
+ */
+static uint32_t benchWeekday(void) {
+  
+  uint32_t sum = 0;
+  int32_t offs = 0;
+  
+  for(offs = 0; offs <= GRCAL_DAY_MAX; offs++) {
+    sum += (uint32_t) grcal_weekday(offs);
+  }
+  
+  return sum;
+}
+
+/*
+ * Program entrypoint
+ * ==================
+ */
+
+int main(int argc, char *argv[]) {
+  
+  int rounds = DEFAULT_ROUNDS;
+  int i = 0;
+  
+  uint32_t sum = 0;
+  double calls = 0.0;
+  clock_t t0 = 0;
+  clock_t t1 = 0;
+  
+  /* Get the number of rounds */
+  if (argc > 2) {
+    fprintf(stderr, "grcal_bench: Wrong number of parameters!\n");
+    return 1;
+  }
+  if (argc == 2) {
+    rounds = atoi(argv[1]);
+    if ((rounds < 1) || (rounds > MAX_ROUNDS)) {
+      fprintf(stderr, "grcal_bench: Invalid round count!\n");
+      return 1;
+    }
+  }
+  
+  /* Day offset to date */
+  t0 = clock();
+  for(i = 0; i < rounds; i++) {
+    sum += benchOffsetToDate();
+  }
+  t1 = clock();
+  printf("grcal_offsetToDate %8.2f ns/call\n",
+    elapsedNs(t0, t1, ((double) rounds) * (GRCAL_DAY_MAX + 1.0)));
+  
+  /* Date to day offset */
+  calls = 0.0;
+  t0 = clock();
+  for(i = 0; i < rounds; i++) {
+    sum += benchDateToOffset(&calls);
+  }
+  t1 = clock();
+  printf("grcal_dateToOffset %8.2f ns/call\n",
+    elapsedNs(t0, t1, calls));
+  
+  /* Weekday */
+  t0 = clock();
+  for(i = 0; i < rounds; i++) {
+    sum += benchWeekday();
+  }
+  t1 = clock();
+  printf("grcal_weekday      %8.2f ns/call\n",
+    elapsedNs(t0, t1, ((double) rounds) * (GRCAL_DAY_MAX + 1.0)));
+  
+  /* Report checksum */
+  printf("checksum %08lx\n", (unsigned long) sum);
+  return 0;
+}
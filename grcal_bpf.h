@@ -0,0 +1,214 @@
+#ifndef GRCAL_BPF_H_INCLUDED
+#define GRCAL_BPF_H_INCLUDED
+
+/*
+ * grcal_bpf.h
+ * ===========
+ * 
+ * Header-only variant of the core grcal conversions that is suitable
+ * for eBPF programs, such as programs that bucket events by calendar
+ * day or month in-kernel.
+ * 
+ * Unlike grcal.c, the functions here contain no loops and never fault.
+ * All arithmetic is performed on unsigned integers and only divides by
+ * constants, so it compiles with clang -target bpf for any BPF CPU
+ * version and passes the verifier without requiring bounded loop
+ * support.  Invalid input is reported through the return value instead
+ * of a fault.
+ * 
+ * The day offset system is the same as in grcal.h, with day zero being
+ * 1582-10-15 and GRCAL_BPF_DAY_MAX being 9999-12-31.  Results are
+ * identical to the grcal.h functions for all valid day offsets.
+ * 
+ * The header does not depend on grcal.h or on grcal.c.  When compiled
+ * for the BPF target, it uses the kernel <linux/types.h> header instead
+ * of <stdint.h>, so no C library headers are required.
+ * 
+ * The "bpf" target of the Makefile compiles test/bpf_day.c, a small
+ * socket filter that uses this header, and the "check" target compares
+ * these functions with grcal.c over every valid day offset.
+ */
+
+#if defined(__bpf__) || defined(__BPF__)
+#include <linux/types.h>
+#define GRCAL_BPF_U32 __u32
+#define GRCAL_BPF_U64 __u64
+#else
+#include <stdint.h>
+#define GRCAL_BPF_U32 uint32_t
+#define GRCAL_BPF_U64 uint64_t
+#endif
+
+/*
+ * Force inlining, so that no BPF-to-BPF calls are generated.
+ */
+#ifdef __GNUC__
+#define GRCAL_BPF_INLINE static inline __attribute__((always_inline))
+#else
+#define GRCAL_BPF_INLINE static inline
+#endif
+
+/*
+ * The maximum valid Gregorian day offset, 9999-12-31.
+ * 
+ * Same value as GRCAL_DAY_MAX in grcal.h.
+ */
+#define GRCAL_BPF_DAY_MAX 3074323u
+
+/*
+ * The day offset of the Unix epoch (January 1, 1970).
+ * 
+ * Same value as GRCAL_DAY_UNIX in grcal.h.
+ */
+#define GRCAL_BPF_DAY_UNIX 141427u
+
+/*
+ * The day index of 1582-10-15 on a proleptic Gregorian calendar where
+ * day zero is 1200-03-01.
+ * 
+ * This is the same internal base that grcal.c uses.
+ */
+#define GRCAL_BPF_DAY_OFFSET 139750u
+
+/*
+ * Convert a Gregorian day offset into the year, month, and day of
+ * month, without loops.
+ * 
+ * The month and day of month are one-indexed.  If the day offset is
+ * greater than GRCAL_BPF_DAY_MAX, the function fails, zero is
+ * returned, and nothing is written.  Otherwise, all three results are
+ * written.
+ * 
+ * Unlike grcal_offsetToDate(), none of the pointers may be NULL.  This
+ * keeps the generated code free of extra branches.
+ * 
+ * Parameters:
+ * 
+ *   offs - the Gregorian day offset to convert
+ * 
+ *   pYear - pointer to the variable to receive the Gregorian year
+ * 
+ *   pMonth - pointer to the variable to receive the Gregorian month
+ * 
+ *   pDayOfMonth - pointer to the variable to receive the Gregorian day
+ *   of the month
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the day offset is out of range
+ */
+GRCAL_BPF_INLINE int grcal_bpf_offsetToDate(
+    GRCAL_BPF_U32   offs,
+    GRCAL_BPF_U32 * pYear,
+    GRCAL_BPF_U32 * pMonth,
+    GRCAL_BPF_U32 * pDayOfMonth) {
+  
+  GRCAL_BPF_U32 z = 0;
+  GRCAL_BPF_U32 qc = 0;
+  GRCAL_BPF_U32 doe = 0;
+  GRCAL_BPF_U32 yoe = 0;
+  GRCAL_BPF_U32 doy = 0;
+  GRCAL_BPF_U32 mp = 0;
+  GRCAL_BPF_U32 month = 0;
+  
+  /* Check range */
+  if (offs > GRCAL_BPF_DAY_MAX) {
+    return 0;
+  }
+  
+  /* Adjust offset so it uses 1200-03-01 as day zero, then split off
+   * the whole quad centuries */
+  z   = offs + GRCAL_BPF_DAY_OFFSET;
+  qc  = z / 146097u;
+  doe = z - (qc * 146097u);
+  
+  /* Compute the year within the quad century; the corrections account
+   * for the leap days at the end of each quad year, century, and quad
+   * century, so that no special cases are needed */
+  yoe = (doe - (doe / 1460u) + (doe / 36524u) - (doe / 146096u)) / 365u;
+  
+  /* Get the day within the (March-based) year and the March-based
+   * month offset, using the fact that March-based month lengths repeat
+   * in a 153-day, five-month pattern */
+  doy = doe - ((365u * yoe) + (yoe / 4u) - (yoe / 100u));
+  mp  = ((5u * doy) + 2u) / 153u;
+  
+  /* Convert the March-based month offset to a one-based standard month
+   * and carry into the year for January and February */
+  month = (mp < 10u) ? (mp + 3u) : (mp - 9u);
+  
+  *pYear       = (qc * 400u) + yoe + 1200u + ((month <= 2u) ? 1u : 0u);
+  *pMonth      = month;
+  *pDayOfMonth = doy - (((153u * mp) + 2u) / 5u) + 1u;
+  
+  return 1;
+}
+
+/*
+ * Convert a Gregorian day offset into a weekday, without faulting.
+ * 
+ * The return value is one for Monday up to seven for Sunday, the same
+ * as grcal_weekday().  If the day offset is greater than
+ * GRCAL_BPF_DAY_MAX, zero is returned instead.
+ * 
+ * Parameters:
+ * 
+ *   offs - the Gregorian day offset
+ * 
+ * Return:
+ * 
+ *   the one-indexed weekday of that day where one is Monday, or zero
+ *   if the day offset is out of range
+ */
+GRCAL_BPF_INLINE GRCAL_BPF_U32 grcal_bpf_weekday(GRCAL_BPF_U32 offs) {
+  
+  /* Check range */
+  if (offs > GRCAL_BPF_DAY_MAX) {
+    return 0;
+  }
+  
+  /* Day offset zero is a Friday */
+  return ((offs + 4u) % 7u) + 1u;
+}
+
+/*
+ * Convert a count of seconds since the Unix epoch into a Gregorian day
+ * offset.
+ * 
+ * This is intended for bucketing event timestamps.  Note that Unix
+ * time is based on UTC, while bpf_ktime_get_tai_ns() counts TAI, which
+ * is ahead of UTC by the TAI-UTC offset, currently 37 seconds.  The
+ * caller must subtract that offset before dividing by one billion, or
+ * events shortly before midnight are counted on the next day.
+ * Timestamps are unsigned, so only instants at or after the Unix epoch
+ * can be represented.
+ * 
+ * If the resulting day offset would be greater than GRCAL_BPF_DAY_MAX,
+ * the function fails, zero is returned, and nothing is written.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - pointer to the variable to receive the day offset
+ * 
+ *   sec - seconds since the Unix epoch
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the timestamp is out of range
+ */
+GRCAL_BPF_INLINE int grcal_bpf_unixToOffset(
+    GRCAL_BPF_U32 * pOffs,
+    GRCAL_BPF_U64   sec) {
+  
+  GRCAL_BPF_U64 d = 0;
+  
+  d = sec / 86400u;
+  if (d > (GRCAL_BPF_U64) (GRCAL_BPF_DAY_MAX - GRCAL_BPF_DAY_UNIX)) {
+    return 0;
+  }
+  
+  *pOffs = ((GRCAL_BPF_U32) d) + GRCAL_BPF_DAY_UNIX;
+  return 1;
+}
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * grcal_clock.c
+ * 
+ * Implementation of grcal_clock.h
+ * 
+ * See the header for further information.
+ */
+
+#if !defined(_POSIX_C_SOURCE) || (_POSIX_C_SOURCE < 199309L)
+#undef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "grcal_clock.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of seconds in a day.
+ */
+#define DAY_SECONDS INT64_C(86400)
+
+/*
+ * The clock that is used for reading the current time, or undefined if
+ * the standard library time() function should be used instead.
+ */
+#if defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0)
+#ifdef CLOCK_REALTIME_COARSE
+#define CLOCK_ID CLOCK_REALTIME_COARSE
+#else
+#define CLOCK_ID CLOCK_REALTIME
+#endif
+#endif
+
+/*
+ * The storage class used for the per-thread cache, or undefined if
+ * thread-local storage is not available.
+ */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define CACHE_STORAGE static _Thread_local
+#elif defined(__GNUC__)
+#define CACHE_STORAGE static __thread
+#endif
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Per-thread cache of the most recently decomposed date.
+ */
+typedef struct {
+  
+  /*
+   * Non-zero if the rest of the cache is valid.
+   */
+  int valid;
+  
+  /*
+   * The time zone offset the cache was computed for.
+   */
+  int32_t zone;
+  
+  /*
+   * The clock reading, in seconds since the Unix epoch, that the cached
+   * time of day corresponds to.
+   */
+  int64_t last;
+  
+  /*
+   * The clock reading, in seconds since the Unix epoch, of local
+   * midnight at the start of the cached day.
+   */
+  int64_t midnight;
+  
+  /*
+   * The cached result.
+   */
+  GRCAL_NOW now;
+  
+} CLOCK_CACHE;
+
+/*
+ * Static data
+ * ===========
+ */
+
+#ifdef CACHE_STORAGE
+CACHE_STORAGE CLOCK_CACHE m_cache;
+#endif
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int readClock(int64_t *pSec);
+static int decompose(CLOCK_CACHE *pc, int64_t t, int32_t zone);
+
+/*
+ * Read the system clock.
+ * 
+ * Parameters:
+ * 
+ *   pSec - pointer to the variable to receive the number of seconds
+ *   since the Unix epoch
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the clock could not be read
+ */
+static int readClock(int64_t *pSec) {
+  
+#ifdef CLOCK_ID
+  struct timespec ts;
+  
+  if (clock_gettime(CLOCK_ID, &ts) != 0) {
+    return 0;
+  }
+  *pSec = (int64_t) ts.tv_sec;
+  
+#else
+  time_t t = 0;
+  
+  t = time(NULL);
+  if (t == (time_t) -1) {
+    return 0;
+  }
+  *pSec = (int64_t) t;
+#endif
+  
+  return 1;
+}
+
+/*
+ * Fully decompose a clock reading into the given cache.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache to update
+ * 
+ *   t - the clock reading in seconds since the Unix epoch
+ * 
+ *   zone - the time zone offset in seconds
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the reading is outside the range
+ *   of grcal day offsets
+ */
+static int decompose(CLOCK_CACHE *pc, int64_t t, int32_t zone) {
+  
+  int64_t local = 0;
+  int64_t day = 0;
+  int64_t sec = 0;
+  
+  /* Split the local time into days and seconds, rounding the day
+   * towards negative infinity */
+  local = t + zone;
+  day = local / DAY_SECONDS;
+  sec = local % DAY_SECONDS;
+  if (sec < 0) {
+    day--;
+    sec += DAY_SECONDS;
+  }
+  
+  /* Convert to a day offset and check range */
+  day += GRCAL_DAY_UNIX;
+  if ((day < 0) || (day > GRCAL_DAY_MAX)) {
+    return 0;
+  }
+  
+  /* Fill in the cache */
+  pc->now.offs = (int32_t) day;
+  grcal_offsetToDate(
+    pc->now.offs, &(pc->now.year), &(pc->now.month), &(pc->now.day));
+  pc->now.weekday = grcal_weekday(pc->now.offs);
+  pc->now.sec = (int32_t) sec;
+  
+  pc->zone = zone;
+  pc->last = t;
+  pc->midnight = t - sec;
+  pc->valid = 1;
+  
+  return 1;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_now function.
+ */
+int grcal_now(GRCAL_NOW *pNow) {
+  return grcal_nowZone(pNow, 0);
+}
+
+/*
+ * grcal_nowZone function.
+ */
+int grcal_nowZone(GRCAL_NOW *pNow, int32_t zone) {
+  
+  int64_t t = 0;
+#ifndef CACHE_STORAGE
+  CLOCK_CACHE m_cache;
+  m_cache.valid = 0;
+#endif
+  
+  /* Check parameters */
+  if ((pNow == NULL) || (zone < -GRCAL_ZONE_MAX) ||
+      (zone > GRCAL_ZONE_MAX)) {
+    abort();
+  }
+  
+  /* Read the clock */
+  if (!readClock(&t)) {
+    return 0;
+  }
+  
+  /* Use the cache if it was computed for the same zone and we are
+   * still in the same day; only refresh the time of day if the second
+   * has changed */
+  if (m_cache.valid && (m_cache.zone == zone) &&
+      (t >= m_cache.midnight) && (t - m_cache.midnight < DAY_SECONDS)) {
+    if (t != m_cache.last) {
+      m_cache.now.sec = (int32_t) (t - m_cache.midnight);
+      m_cache.last = t;
+    }
+    
+  } else {
+    if (!decompose(&m_cache, t, zone)) {
+      m_cache.valid = 0;
+      return 0;
+    }
+  }
+  
+  *pNow = m_cache.now;
+  return 1;
+}
+
+/*
+ * grcal_today function.
+ */
+int32_t grcal_today(void) {
+  return grcal_todayZone(0);
+}
+
+/*
+ * grcal_todayZone function.
+ */
+int32_t grcal_todayZone(int32_t zone) {
+  
+  GRCAL_NOW now;
+  
+  if (!grcal_nowZone(&now, zone)) {
+    return -1;
+  }
+  return now.offs;
+}
@@ -0,0 +1,140 @@
+#ifndef GRCAL_CLOCK_H_INCLUDED
+#define GRCAL_CLOCK_H_INCLUDED
+
+/*
+ * grcal_clock.h
+ * =============
+ * 
+ * Fast access to the current date and time of day as grcal values.
+ * 
+ * The system clock is read with clock_gettime() on the
+ * CLOCK_REALTIME_COARSE clock where it is available, which on Linux is
+ * serviced by the vDSO without entering the kernel.  Other POSIX
+ * systems use CLOCK_REALTIME, and non-POSIX systems fall back to the
+ * standard library time() function.  In all cases, the resolution is
+ * one second.
+ * 
+ * Each thread keeps a cache of the most recently decomposed date in
+ * thread-local storage.  When the clock is still within the same second
+ * as the cached value, the cached result is returned as-is.  When the
+ * clock is still within the same day, only the time of day is updated.
+ * The full conversion through grcal_offsetToDate() and grcal_weekday()
+ * is only performed when a day boundary is crossed or when a different
+ * time zone offset is requested.  If the compiler does not support
+ * thread-local storage, no caching is performed.
+ * 
+ * Time zones are given as a fixed offset in seconds from UTC, which is
+ * positive east of Greenwich.  For example, UTC+05:30 is 19800 and
+ * UTC-08:00 is -28800.  Daylight saving rules are the responsibility of
+ * the caller.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+
+/*
+ * The largest magnitude time zone offset that is accepted, in seconds.
+ * 
+ * This is a full day, which is more than any real time zone uses.
+ */
+#define GRCAL_ZONE_MAX INT32_C(86400)
+
+/*
+ * Structure holding a decomposed current date and time.
+ */
+typedef struct {
+  
+  /*
+   * The Gregorian day offset of the current date.
+   */
+  int32_t offs;
+  
+  /*
+   * The Gregorian year, month, and day of month of the current date.
+   * 
+   * Month and day of month are one-indexed.
+   */
+  int year;
+  int month;
+  int day;
+  
+  /*
+   * The weekday of the current date, where one is Monday and seven is
+   * Sunday.
+   */
+  int weekday;
+  
+  /*
+   * The number of seconds that have elapsed since midnight, in range
+   * zero up to and including 86399.
+   */
+  int32_t sec;
+  
+} GRCAL_NOW;
+
+/*
+ * Get the current date and time of day in UTC.
+ * 
+ * The function fails if the system clock can not be read or if it
+ * reports a date outside the range of grcal day offsets.  In that case,
+ * zero is returned and the structure is not modified.
+ * 
+ * Parameters:
+ * 
+ *   pNow - the structure to receive the current date and time
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the clock could not be read
+ */
+int grcal_now(GRCAL_NOW *pNow);
+
+/*
+ * Get the current date and time of day in a time zone with a fixed
+ * offset from UTC.
+ * 
+ * The zone offset must be in range [-GRCAL_ZONE_MAX, GRCAL_ZONE_MAX] or
+ * a fault occurs.  Otherwise, this is the same as grcal_now().
+ * 
+ * Parameters:
+ * 
+ *   pNow - the structure to receive the current date and time
+ * 
+ *   zone - the offset of the time zone from UTC in seconds
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the clock could not be read
+ */
+int grcal_nowZone(GRCAL_NOW *pNow, int32_t zone);
+
+/*
+ * Get the day offset of the current date in UTC.
+ * 
+ * Return:
+ * 
+ *   the Gregorian day offset of today, or -1 if the clock could not be
+ *   read
+ */
+int32_t grcal_today(void);
+
+/*
+ * Get the day offset of the current date in a time zone with a fixed
+ * offset from UTC.
+ * 
+ * The zone offset must be in range [-GRCAL_ZONE_MAX, GRCAL_ZONE_MAX] or
+ * a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   zone - the offset of the time zone from UTC in seconds
+ * 
+ * Return:
+ * 
+ *   the Gregorian day offset of today, or -1 if the clock could not be
+ *   read
+ */
+int32_t grcal_todayZone(int32_t zone);
+
+#endif
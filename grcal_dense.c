@@ -0,0 +1,286 @@
+/*
+ * grcal_dense.c
+ * 
+ * Implementation of grcal_dense.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_dense.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * The position of a walk along a grid.
+ */
+typedef struct {
+  
+  /*
+   * The grid and its calendar.
+   */
+  int grid;
+  const GRCAL_BDAY *pCal;
+  
+  /*
+   * The day offset of the current grid point, or -1 if the walk has run
+   * past GRCAL_DAY_MAX.
+   */
+  int32_t offs;
+  
+  /*
+   * The year and month of the current grid point, only kept for the
+   * month-end grid.
+   */
+  int y;
+  int m;
+  
+} WALK;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void checkRange(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last);
+static void walkBegin(
+          WALK       * pw,
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first);
+static void walkNext(WALK *pw);
+
+/*
+ * Fault unless a grid and range are valid.
+ * 
+ * Parameters:
+ * 
+ *   grid - the grid
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ *   first - the first day offset of the range
+ * 
+ *   last - the last day offset of the range
+ */
+static void checkRange(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last) {
+  
+  if ((grid != GRCAL_DENSE_DAY) && (grid != GRCAL_DENSE_BDAY) &&
+      (grid != GRCAL_DENSE_MONTH_END)) {
+    abort();
+  }
+  if ((grid == GRCAL_DENSE_BDAY) && (pCal == NULL)) {
+    abort();
+  }
+  if ((first < 0) || (first > GRCAL_DAY_MAX) ||
+      (last < 0) || (last > GRCAL_DAY_MAX)) {
+    abort();
+  }
+}
+
+/*
+ * Start a walk at the first grid point on or after a day.
+ * 
+ * Parameters:
+ * 
+ *   pw - the walk to start
+ * 
+ *   grid - the grid, which is valid
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ *   first - the day offset to start from, which is valid
+ */
+static void walkBegin(
+          WALK       * pw,
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first) {
+  
+  int d = 0;
+  
+  pw->grid = grid;
+  pw->pCal = pCal;
+  pw->y = 0;
+  pw->m = 0;
+  
+  if (grid == GRCAL_DENSE_DAY) {
+    pw->offs = first;
+    
+  } else if (grid == GRCAL_DENSE_BDAY) {
+    pw->offs = grcal_bdayNext(pCal, first);
+    
+  } else {
+    /* This is the only date decomposition of the walk */
+    grcal_offsetToDate(first, &(pw->y), &(pw->m), &d);
+    pw->offs = first + (grcal_privMonthDays(pw->y, pw->m) - d);
+  }
+}
+
+/*
+ * Move a walk to the next grid point.
+ * 
+ * Parameters:
+ * 
+ *   pw - the walk, which must not have run past GRCAL_DAY_MAX
+ */
+static void walkNext(WALK *pw) {
+  
+  if (pw->offs >= GRCAL_DAY_MAX) {
+    pw->offs = -1;
+    
+  } else if (pw->grid == GRCAL_DENSE_DAY) {
+    (pw->offs)++;
+    
+  } else if (pw->grid == GRCAL_DENSE_BDAY) {
+    pw->offs = grcal_bdayNext(pw->pCal, pw->offs + 1);
+    
+  } else {
+    /* The next month end is one month length further on */
+    (pw->m)++;
+    if (pw->m > 12) {
+      pw->m = 1;
+      (pw->y)++;
+    }
+    pw->offs += grcal_privMonthDays(pw->y, pw->m);
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_denseCount function.
+ */
+size_t grcal_denseCount(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last) {
+  
+  int y1 = 0;
+  int m1 = 0;
+  int d1 = 0;
+  int y2 = 0;
+  int m2 = 0;
+  int d2 = 0;
+  size_t result = 0;
+  
+  /* Check parameters */
+  checkRange(grid, pCal, first, last);
+  
+  if (last < first) {
+    return 0;
+  }
+  
+  if (grid == GRCAL_DENSE_DAY) {
+    result = (size_t) (last - first) + 1;
+    
+  } else if (grid == GRCAL_DENSE_BDAY) {
+    result = (size_t) grcal_bdayCount(pCal, first, last);
+    
+  } else {
+    /* Every month from that of first up to the month before that of
+     * last has its end in the range, and so does the month of last if
+     * last is its end */
+    grcal_offsetToDate(first, &y1, &m1, &d1);
+    grcal_offsetToDate(last, &y2, &m2, &d2);
+    result = (size_t) (((y2 * 12) + m2) - ((y1 * 12) + m1));
+    if (d2 == grcal_privMonthDays(y2, m2)) {
+      result++;
+    }
+  }
+  
+  return result;
+}
+
+/*
+ * grcal_denseFill function.
+ */
+size_t grcal_denseFill(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last,
+    const int32_t    * pOffs,
+    const double     * pVals,
+          size_t       count,
+          int          fill,
+          double       fillValue,
+          int32_t    * pOutOffs,
+          double     * pOutVals,
+          size_t       outCap) {
+  
+  WALK w;
+  double cur = 0.0;
+  size_t points = 0;
+  size_t n = 0;
+  size_t j = 0;
+  int exact = 0;
+  
+  /* Check parameters */
+  points = grcal_denseCount(grid, pCal, first, last);
+  if ((fill != GRCAL_DENSE_FFILL) && (fill != GRCAL_DENSE_CONST)) {
+    abort();
+  }
+  if (((pOffs == NULL) || (pVals == NULL)) && (count > 0)) {
+    abort();
+  }
+  if ((outCap < points) || ((pOutVals == NULL) && (points > 0))) {
+    abort();
+  }
+  for(j = 1; j < count; j++) {
+    if (pOffs[j] < pOffs[j - 1]) {
+      abort();
+    }
+  }
+  
+  if (points < 1) {
+    return 0;
+  }
+  
+  /* Walk the grid, taking in the rows up to each grid point as it is
+   * reached */
+  cur = fillValue;
+  j = 0;
+  for(walkBegin(&w, grid, pCal, first);
+      (w.offs >= 0) && (w.offs <= last);
+      walkNext(&w)) {
+    
+    exact = 0;
+    while ((j < count) && (pOffs[j] <= w.offs)) {
+      cur = pVals[j];
+      exact = (pOffs[j] == w.offs);
+      j++;
+    }
+    
+    if (pOutOffs != NULL) {
+      pOutOffs[n] = w.offs;
+    }
+    if (fill == GRCAL_DENSE_FFILL) {
+      pOutVals[n] = cur;
+    } else {
+      pOutVals[n] = exact ? cur : fillValue;
+    }
+    n++;
+  }
+  
+  return n;
+}
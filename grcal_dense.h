@@ -0,0 +1,137 @@
+#ifndef GRCAL_DENSE_H_INCLUDED
+#define GRCAL_DENSE_H_INCLUDED
+
+/*
+ * grcal_dense.h
+ * =============
+ * 
+ * Densification of sparse date-keyed series onto a calendar grid.
+ * 
+ * A sparse series is a sorted column of day offsets with a column of
+ * values, where most days have no row.  Densifying it produces one
+ * value for each point of a grid over a range of days, which is every
+ * calendar day, every business day of a grcal_bday calendar, or the
+ * last day of every month.
+ * 
+ * A grid point with no row on the same day gets either the value of
+ * the latest row before it, known as forward filling, or a constant
+ * such as zero.  Forward filling also carries rows that fall between
+ * grid points, such as weekend rows on a business-day grid or mid-month
+ * rows on a month-end grid, to the next grid point.
+ * 
+ * grcal_denseFill() generates the grid and fills it in one streaming
+ * pass, merging the rows in as it goes, so the grid is never stored on
+ * its own.  Business days are found with the bitmap search of
+ * grcal_bdayNext(), and month ends by adding month lengths from one
+ * month to the next.  The output arrays are supplied by the caller and
+ * sized with grcal_denseCount().
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_bday.h"
+#include <stddef.h>
+
+/*
+ * Grids.
+ */
+#define GRCAL_DENSE_DAY       1
+#define GRCAL_DENSE_BDAY      2
+#define GRCAL_DENSE_MONTH_END 3
+
+/*
+ * Fill methods.
+ * 
+ * GRCAL_DENSE_FFILL uses the value of the latest row on or before each
+ * grid point, or the fill value if there is none.  GRCAL_DENSE_CONST
+ * uses the value of the row on each grid point, or the fill value if
+ * there is none.
+ */
+#define GRCAL_DENSE_FFILL 1
+#define GRCAL_DENSE_CONST 2
+
+/*
+ * Count the points of a grid over a range of days.
+ * 
+ * grid must be one of the GRCAL_DENSE grids, pCal must not be NULL for
+ * GRCAL_DENSE_BDAY, and first and last must be valid day offsets, or a
+ * fault occurs.  pCal is ignored for the other grids.
+ * 
+ * Parameters:
+ * 
+ *   grid - the grid
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ *   first - the day offset of the first day of the range
+ * 
+ *   last - the day offset of the last day of the range
+ * 
+ * Return:
+ * 
+ *   the number of grid points from first up to and including last,
+ *   which is zero if last is less than first
+ */
+size_t grcal_denseCount(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last);
+
+/*
+ * Densify a sparse series onto a grid over a range of days.
+ * 
+ * grid, pCal, first, and last are as for grcal_denseCount(), fill must
+ * be one of the GRCAL_DENSE fill methods, the day offsets of the rows
+ * must be sorted in ascending order, and outCap must be at least the
+ * number of grid points.  Otherwise, a fault occurs before any output
+ * is written.  Row day offsets need not be within the range, and if
+ * several rows have the same day offset, the last of them is used.
+ * 
+ * Parameters:
+ * 
+ *   grid - the grid
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ *   first - the day offset of the first day of the range
+ * 
+ *   last - the day offset of the last day of the range
+ * 
+ *   pOffs - the day offsets of the rows
+ * 
+ *   pVals - the values of the rows
+ * 
+ *   count - the number of rows
+ * 
+ *   fill - the fill method
+ * 
+ *   fillValue - the value of grid points that get no row value
+ * 
+ *   pOutOffs - the array to receive the day offsets of the grid points,
+ *   or NULL if not required
+ * 
+ *   pOutVals - the array to receive the values of the grid points
+ * 
+ *   outCap - the number of grid points that the output arrays have room
+ *   for
+ * 
+ * Return:
+ * 
+ *   the number of grid points
+ */
+size_t grcal_denseFill(
+          int          grid,
+    const GRCAL_BDAY * pCal,
+          int32_t      first,
+          int32_t      last,
+    const int32_t    * pOffs,
+    const double     * pVals,
+          size_t       count,
+          int          fill,
+          double       fillValue,
+          int32_t    * pOutOffs,
+          double     * pOutVals,
+          size_t       outCap);
+
+#endif
@@ -0,0 +1,457 @@
+/*
+ * grcal_dict.c
+ * 
+ * Implementation of grcal_dict.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_dict.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Key kinds, which are stored in the upper half of the second key word
+ * so that a second key word of zero marks an empty entry.
+ */
+#define KIND_ISO UINT32_C(0x10000)
+#define KIND_YMD UINT32_C(0x20000)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A table entry.
+ */
+typedef struct {
+  
+  /*
+   * The first eight bytes of a date string, or a packed year, month,
+   * and day of month.
+   */
+  uint64_t a;
+  
+  /*
+   * The key kind combined with the last two bytes of a date string, or
+   * zero if the entry is empty.
+   */
+  uint32_t b;
+  
+  /*
+   * The cached day offset, or -1 for an invalid date.
+   */
+  int32_t offs;
+  
+} DICT_ENTRY;
+
+/*
+ * GRCAL_DICT structure.
+ */
+struct GRCAL_DICT_TAG {
+  
+  /*
+   * The table, its capacity, which is a power of two, and the number of
+   * entries in use.
+   */
+  DICT_ENTRY *pTable;
+  size_t cap;
+  size_t entries;
+  
+  /*
+   * Statistics since the last reset.
+   */
+  uint64_t inputs;
+  uint64_t hits;
+  
+  /*
+   * Lookups and hits in the current window.
+   */
+  uint32_t winInputs;
+  uint32_t winHits;
+  
+  /*
+   * Non-zero if in bypass mode.
+   */
+  int bypass;
+  
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static size_t hashKey(uint64_t a, uint32_t b, size_t cap);
+static int lookup(
+    GRCAL_DICT * pd,
+    uint64_t     a,
+    uint32_t     b,
+    size_t     * pSlot);
+static void insert(
+    GRCAL_DICT * pd,
+    size_t       slot,
+    uint64_t     a,
+    uint32_t     b,
+    int32_t      offs);
+static void account(GRCAL_DICT *pd, int hit);
+
+/*
+ * Hash a key into a table index.
+ * 
+ * Parameters:
+ * 
+ *   a - the first key word
+ * 
+ *   b - the second key word
+ * 
+ *   cap - the table capacity, which is a power of two
+ * 
+ * Return:
+ * 
+ *   the home index of the key
+ */
+static size_t hashKey(uint64_t a, uint32_t b, size_t cap) {
+  
+  uint64_t h = 0;
+  
+  h = a ^ (((uint64_t) b) * UINT64_C(0x9e3779b97f4a7c15));
+  h ^= h >> 33;
+  h *= UINT64_C(0xff51afd7ed558ccd);
+  h ^= h >> 33;
+  
+  return (size_t) (h & ((uint64_t) (cap - 1)));
+}
+
+/*
+ * Find a key in the table with linear probing.
+ * 
+ * If the key is found, its index is written to *pSlot.  Otherwise, the
+ * index of the empty entry where it could be inserted is written.  The
+ * table is never more than half full, so an empty entry always exists.
+ * 
+ * Parameters:
+ * 
+ *   pd - the dictionary
+ * 
+ *   a - the first key word
+ * 
+ *   b - the second key word
+ * 
+ *   pSlot - pointer to the variable to receive the index
+ * 
+ * Return:
+ * 
+ *   non-zero if the key was found, zero if not
+ */
+static int lookup(
+    GRCAL_DICT * pd,
+    uint64_t     a,
+    uint32_t     b,
+    size_t     * pSlot) {
+  
+  size_t i = 0;
+  DICT_ENTRY *pe = NULL;
+  
+  i = hashKey(a, b, pd->cap);
+  for(;;) {
+    pe = &((pd->pTable)[i]);
+    if (pe->b == 0) {
+      *pSlot = i;
+      return 0;
+    }
+    if ((pe->a == a) && (pe->b == b)) {
+      *pSlot = i;
+      return 1;
+    }
+    i = (i + 1) & (pd->cap - 1);
+  }
+}
+
+/*
+ * Insert a key into an empty entry found by lookup(), unless the table
+ * is already half full.
+ * 
+ * Parameters:
+ * 
+ *   pd - the dictionary
+ * 
+ *   slot - the empty entry index returned by lookup()
+ * 
+ *   a - the first key word
+ * 
+ *   b - the second key word
+ * 
+ *   offs - the day offset to cache
+ */
+static void insert(
+    GRCAL_DICT * pd,
+    size_t       slot,
+    uint64_t     a,
+    uint32_t     b,
+    int32_t      offs) {
+  
+  if (pd->entries < pd->cap / 2) {
+    (pd->pTable)[slot].a = a;
+    (pd->pTable)[slot].b = b;
+    (pd->pTable)[slot].offs = offs;
+    (pd->entries)++;
+  }
+}
+
+/*
+ * Record one lookup in the statistics, and switch to bypass mode at
+ * the end of a window with a low hit ratio.
+ * 
+ * Parameters:
+ * 
+ *   pd - the dictionary
+ * 
+ *   hit - non-zero if the lookup was a hit
+ */
+static void account(GRCAL_DICT *pd, int hit) {
+  
+  (pd->inputs)++;
+  (pd->winInputs)++;
+  if (hit) {
+    (pd->hits)++;
+    (pd->winHits)++;
+  }
+  
+  if (pd->winInputs >= GRCAL_DICT_WINDOW) {
+    if (pd->winHits * 2 < pd->winInputs) {
+      pd->bypass = 1;
+    }
+    pd->winInputs = 0;
+    pd->winHits = 0;
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_dictNew function.
+ */
+GRCAL_DICT *grcal_dictNew(size_t cap) {
+  
+  GRCAL_DICT *pd = NULL;
+  size_t c = 0;
+  
+  /* Check and round capacity */
+  if (cap == 0) {
+    cap = GRCAL_DICT_DEFAULT_CAP;
+  }
+  if (cap > GRCAL_DICT_MAX_CAP) {
+    abort();
+  }
+  c = 2;
+  while (c < cap) {
+    c *= 2;
+  }
+  
+  /* Allocate */
+  pd = (GRCAL_DICT *) calloc(1, sizeof(GRCAL_DICT));
+  if (pd == NULL) {
+    return NULL;
+  }
+  
+  pd->pTable = (DICT_ENTRY *) calloc(c, sizeof(DICT_ENTRY));
+  if (pd->pTable == NULL) {
+    free(pd);
+    return NULL;
+  }
+  pd->cap = c;
+  
+  return pd;
+}
+
+/*
+ * grcal_dictFree function.
+ */
+void grcal_dictFree(GRCAL_DICT *pDict) {
+  if (pDict != NULL) {
+    free(pDict->pTable);
+    free(pDict);
+  }
+}
+
+/*
+ * grcal_dictReset function.
+ */
+void grcal_dictReset(GRCAL_DICT *pDict) {
+  
+  if (pDict == NULL) {
+    abort();
+  }
+  
+  memset(pDict->pTable, 0, pDict->cap * sizeof(DICT_ENTRY));
+  pDict->entries = 0;
+  pDict->inputs = 0;
+  pDict->hits = 0;
+  pDict->winInputs = 0;
+  pDict->winHits = 0;
+  pDict->bypass = 0;
+}
+
+/*
+ * grcal_dictStats function.
+ */
+void grcal_dictStats(
+    const GRCAL_DICT       * pDict,
+          GRCAL_DICT_STATS * pStats) {
+  
+  if ((pDict == NULL) || (pStats == NULL)) {
+    abort();
+  }
+  
+  pStats->inputs = pDict->inputs;
+  pStats->hits = pDict->hits;
+  pStats->entries = pDict->entries;
+  pStats->bypass = pDict->bypass;
+}
+
+/*
+ * grcal_dictIsoToOffset function.
+ */
+size_t grcal_dictIsoToOffset(
+          GRCAL_DICT * pDict,
+    const char       * pStr,
+          size_t       stride,
+          size_t       count,
+          int32_t    * pOffs) {
+  
+  const char *pc = NULL;
+  size_t invalid = 0;
+  size_t slot = 0;
+  size_t i = 0;
+  uint64_t a = 0;
+  uint32_t b = 0;
+  uint16_t tail = 0;
+  int32_t offs = 0;
+  int hit = 0;
+  
+  /* Check parameters */
+  if ((pDict == NULL) || (stride < GRCAL_ISO_LENGTH)) {
+    abort();
+  }
+  if (((pStr == NULL) || (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    
+    /* In bypass mode, convert everything that is left directly */
+    if (pDict->bypass) {
+      pDict->inputs += (uint64_t) (count - i);
+      return invalid + grcal_isoToOffsetBatch(
+                          pStr + (i * stride), stride, count - i,
+                          pOffs + i);
+    }
+    
+    /* The key is the raw bytes of the string */
+    pc = pStr + (i * stride);
+    memcpy(&a, pc, 8);
+    memcpy(&tail, pc + 8, 2);
+    b = KIND_ISO | (uint32_t) tail;
+    
+    /* Look up the string, converting and caching it if not found */
+    hit = lookup(pDict, a, b, &slot);
+    if (hit) {
+      offs = (pDict->pTable)[slot].offs;
+    } else {
+      grcal_isoToOffsetBatch(pc, GRCAL_ISO_LENGTH, 1, &offs);
+      insert(pDict, slot, a, b, offs);
+    }
+    
+    pOffs[i] = offs;
+    if (offs < 0) {
+      invalid++;
+    }
+    account(pDict, hit);
+  }
+  
+  return invalid;
+}
+
+/*
+ * grcal_dictDateToOffset function.
+ */
+size_t grcal_dictDateToOffset(
+          GRCAL_DICT * pDict,
+    const int32_t    * pYear,
+    const int32_t    * pMonth,
+    const int32_t    * pDayOfMonth,
+          size_t       count,
+          int32_t    * pOffs) {
+  
+  size_t invalid = 0;
+  size_t slot = 0;
+  size_t i = 0;
+  uint64_t a = 0;
+  int32_t offs = 0;
+  int hit = 0;
+  
+  /* Check parameters */
+  if (pDict == NULL) {
+    abort();
+  }
+  if (((pYear == NULL) || (pMonth == NULL) || (pDayOfMonth == NULL) ||
+        (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    
+    /* In bypass mode, convert everything that is left directly */
+    if (pDict->bypass) {
+      pDict->inputs += (uint64_t) (count - i);
+      return invalid + grcal_dateToOffsetBatch(
+                          pYear + i, pMonth + i, pDayOfMonth + i,
+                          count - i, pOffs + i);
+    }
+    
+    /* Fields too large to pack can not be valid dates, so they are
+     * converted without going through the table */
+    if ((pYear[i] < 0) || (pYear[i] > 0xffff) ||
+        (pMonth[i] < 0) || (pMonth[i] > 0xff) ||
+        (pDayOfMonth[i] < 0) || (pDayOfMonth[i] > 0xff)) {
+      pOffs[i] = -1;
+      invalid++;
+      account(pDict, 0);
+      continue;
+    }
+    
+    a = (((uint64_t) pYear[i]) << 16) |
+        (((uint64_t) pMonth[i]) << 8) |
+         ((uint64_t) pDayOfMonth[i]);
+    
+    hit = lookup(pDict, a, KIND_YMD, &slot);
+    if (hit) {
+      offs = (pDict->pTable)[slot].offs;
+    } else {
+      grcal_dateToOffsetBatch(
+        pYear + i, pMonth + i, pDayOfMonth + i, 1, &offs);
+      insert(pDict, slot, a, KIND_YMD, offs);
+    }
+    
+    pOffs[i] = offs;
+    if (offs < 0) {
+      invalid++;
+    }
+    account(pDict, hit);
+  }
+  
+  return invalid;
+}
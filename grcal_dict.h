@@ -0,0 +1,194 @@
+#ifndef GRCAL_DICT_H_INCLUDED
+#define GRCAL_DICT_H_INCLUDED
+
+/*
+ * grcal_dict.h
+ * ============
+ * 
+ * Dictionary-cached conversion of date columns into day offsets.
+ * 
+ * Real date columns usually hold far fewer distinct values than rows.
+ * A GRCAL_DICT is a small open-addressing hash table that remembers the
+ * day offset of each distinct input it has seen, so that each distinct
+ * date string or year-month-day triple is only parsed, validated, and
+ * converted once.  Invalid inputs are cached too.
+ * 
+ * The table has a fixed capacity that is chosen when it is created.
+ * Once it is half full, new distinct values are still converted but no
+ * longer inserted.  Lookups are counted in windows of GRCAL_DICT_WINDOW
+ * inputs; if the hit ratio of a window falls below one half, the
+ * dictionary switches to bypass mode, in which inputs go straight to
+ * the grcal_batch.h conversions without hashing.  Bypass mode lasts
+ * until the dictionary is reset.
+ * 
+ * A dictionary may be used for both date strings and year-month-day
+ * triples; the two kinds of key are kept apart.  A dictionary may not
+ * be used from more than one thread at a time.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_batch.h"
+
+/*
+ * The number of lookups in each hit ratio window.
+ */
+#define GRCAL_DICT_WINDOW 4096
+
+/*
+ * The default and maximum table capacities, in entries.
+ */
+#define GRCAL_DICT_DEFAULT_CAP 8192
+#define GRCAL_DICT_MAX_CAP 16777216
+
+/*
+ * Statistics structure.
+ */
+typedef struct {
+  
+  /*
+   * The total number of inputs converted since the last reset,
+   * including those converted in bypass mode.
+   */
+  uint64_t inputs;
+  
+  /*
+   * The number of inputs that were found in the table.
+   */
+  uint64_t hits;
+  
+  /*
+   * The number of distinct values currently in the table.
+   */
+  size_t entries;
+  
+  /*
+   * Non-zero if the dictionary has switched to bypass mode.
+   */
+  int bypass;
+  
+} GRCAL_DICT_STATS;
+
+/*
+ * Opaque dictionary structure.
+ */
+struct GRCAL_DICT_TAG;
+typedef struct GRCAL_DICT_TAG GRCAL_DICT;
+
+/*
+ * Create a new dictionary.
+ * 
+ * The capacity is rounded up to a power of two.  Pass zero to use
+ * GRCAL_DICT_DEFAULT_CAP.  The capacity may be at most
+ * GRCAL_DICT_MAX_CAP or a fault occurs.  Up to half the capacity may be
+ * used for distinct values.
+ * 
+ * Parameters:
+ * 
+ *   cap - the table capacity in entries, or zero
+ * 
+ * Return:
+ * 
+ *   the new dictionary, or NULL if memory could not be allocated
+ */
+GRCAL_DICT *grcal_dictNew(size_t cap);
+
+/*
+ * Release a dictionary.
+ * 
+ * Does nothing if NULL is passed.
+ * 
+ * Parameters:
+ * 
+ *   pDict - the dictionary to release, or NULL
+ */
+void grcal_dictFree(GRCAL_DICT *pDict);
+
+/*
+ * Clear all entries and statistics of a dictionary, and leave bypass
+ * mode.
+ * 
+ * Parameters:
+ * 
+ *   pDict - the dictionary
+ */
+void grcal_dictReset(GRCAL_DICT *pDict);
+
+/*
+ * Get the statistics of a dictionary.
+ * 
+ * The hit ratio is hits divided by inputs.
+ * 
+ * Parameters:
+ * 
+ *   pDict - the dictionary
+ * 
+ *   pStats - the structure to receive the statistics
+ */
+void grcal_dictStats(
+    const GRCAL_DICT       * pDict,
+          GRCAL_DICT_STATS * pStats);
+
+/*
+ * Convert an array of dates in YYYY-MM-DD format into day offsets
+ * through a dictionary.
+ * 
+ * The string layout and results are the same as for
+ * grcal_isoToOffsetBatch().
+ * 
+ * Parameters:
+ * 
+ *   pDict - the dictionary
+ * 
+ *   pStr - the first date string
+ * 
+ *   stride - the distance in bytes between date strings
+ * 
+ *   count - the number of date strings
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of elements that were not valid dates
+ */
+size_t grcal_dictIsoToOffset(
+          GRCAL_DICT * pDict,
+    const char       * pStr,
+          size_t       stride,
+          size_t       count,
+          int32_t    * pOffs);
+
+/*
+ * Convert arrays of years, months, and days of month into day offsets
+ * through a dictionary.
+ * 
+ * The results are the same as for grcal_dateToOffsetBatch().
+ * 
+ * Parameters:
+ * 
+ *   pDict - the dictionary
+ * 
+ *   pYear - the years
+ * 
+ *   pMonth - the months
+ * 
+ *   pDayOfMonth - the days of the month
+ * 
+ *   count - the number of elements in each array
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of elements that were not valid dates
+ */
+size_t grcal_dictDateToOffset(
+          GRCAL_DICT * pDict,
+    const int32_t    * pYear,
+    const int32_t    * pMonth,
+    const int32_t    * pDayOfMonth,
+          size_t       count,
+          int32_t    * pOffs);
+
+#endif
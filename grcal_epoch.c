@@ -0,0 +1,476 @@
+/*
+ * grcal_epoch.c
+ * 
+ * Implementation of grcal_epoch.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_epoch.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The largest codec constant.
+ */
+#define CODEC_MAX GRCAL_EPOCH_APPLE
+
+/*
+ * The number of nanoseconds in a second.
+ */
+#define SECOND_NS INT64_C(1000000000)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Description of a codec.
+ * 
+ * NTP timestamps are not a plain count of units, so the NTP entry only
+ * uses the epoch and is otherwise handled separately.
+ */
+typedef struct {
+  
+  /*
+   * The day offset of the epoch.
+   */
+  int32_t epoch;
+  
+  /*
+   * The number of units in a day.
+   */
+  int64_t perDay;
+  
+  /*
+   * The number of nanoseconds in a unit.
+   */
+  int64_t unitNs;
+  
+} CODEC;
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The codec table, indexed by codec constant.
+ */
+static const CODEC m_codecs[CODEC_MAX + 1] = {
+  {0, 0, 0},
+  {141427, INT64_C(86400), INT64_C(1000000000)},
+  {141427, INT64_C(86400000), INT64_C(1000000)},
+  {141427, INT64_C(86400000000), INT64_C(1000)},
+  {141427, INT64_C(86400000000000), INT64_C(1)},
+  {6653, INT64_C(864000000000), INT64_C(100)},
+  {-577735, INT64_C(864000000000), INT64_C(100)},
+  {115860, INT64_C(86400), INT64_C(1000000000)},
+  {152750, INT64_C(86400), INT64_C(1000000000)}
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static const CODEC *codecOf(int codec);
+static size_t decodeRun(
+          int       codec,
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs);
+static size_t decodeNtp(
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs);
+static size_t encodeRun(
+          int       codec,
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut);
+static size_t encodeNtp(
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut);
+
+/*
+ * Look up a codec, faulting if it is not valid.
+ * 
+ * Parameters:
+ * 
+ *   codec - the codec constant
+ * 
+ * Return:
+ * 
+ *   the codec description
+ */
+static const CODEC *codecOf(int codec) {
+  if ((codec < 1) || (codec > CODEC_MAX)) {
+    abort();
+  }
+  return &(m_codecs[codec]);
+}
+
+/*
+ * Decode an array of instants in one encoding.
+ * 
+ * Parameters:
+ * 
+ *   codec - the valid codec constant
+ * 
+ *   pIn - the encoded instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pDay - the array to receive the day offsets
+ * 
+ *   pNs - the array to receive the nanoseconds since midnight
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be decoded
+ */
+static size_t decodeRun(
+          int       codec,
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs) {
+  
+  const CODEC *pc = NULL;
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t per = 0;
+  int64_t unit = 0;
+  int64_t lo = 0;
+  int64_t hi = 0;
+  int64_t q = 0;
+  int64_t r = 0;
+  int64_t neg = 0;
+  int valid = 0;
+  
+  if (codec == GRCAL_EPOCH_NTP) {
+    return decodeNtp(pIn, count, pDay, pNs);
+  }
+  
+  pc = codecOf(codec);
+  per = pc->perDay;
+  unit = pc->unitNs;
+  lo = -((int64_t) pc->epoch);
+  hi = ((int64_t) GRCAL_DAY_MAX) - pc->epoch;
+  
+  /* Floored division by the day length, without branches */
+  for(i = 0; i < count; i++) {
+    q = pIn[i] / per;
+    r = pIn[i] % per;
+    neg = (r < 0);
+    q -= neg;
+    r += per & (-neg);
+    
+    valid = (q >= lo) & (q <= hi);
+    pDay[i] = valid ? (int32_t) (q + pc->epoch) : -1;
+    pNs[i] = valid ? (r * unit) : 0;
+    bad += !valid;
+  }
+  
+  return bad;
+}
+
+/*
+ * Decode an array of NTP timestamps.
+ * 
+ * Every NTP timestamp of era zero is within the range of day offsets,
+ * so this can not fail.
+ * 
+ * Parameters:
+ * 
+ *   pIn - the encoded instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pDay - the array to receive the day offsets
+ * 
+ *   pNs - the array to receive the nanoseconds since midnight
+ * 
+ * Return:
+ * 
+ *   zero
+ */
+static size_t decodeNtp(
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs) {
+  
+  size_t i = 0;
+  uint64_t u = 0;
+  uint64_t sec = 0;
+  uint64_t frac = 0;
+  
+  for(i = 0; i < count; i++) {
+    u = (uint64_t) pIn[i];
+    sec = u >> 32;
+    frac = u & UINT64_C(0xffffffff);
+    pDay[i] = (int32_t) (sec / 86400) + m_codecs[GRCAL_EPOCH_NTP].epoch;
+    pNs[i] = (int64_t) (((sec % 86400) * SECOND_NS) +
+                ((frac * SECOND_NS) >> 32));
+  }
+  
+  return 0;
+}
+
+/*
+ * Encode an array of instants in one encoding.
+ * 
+ * Parameters:
+ * 
+ *   codec - the valid codec constant
+ * 
+ *   pDay - the day offsets
+ * 
+ *   pNs - the nanoseconds since midnight
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the encoded instants
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be encoded
+ */
+static size_t encodeRun(
+          int       codec,
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut) {
+  
+  const CODEC *pc = NULL;
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t per = 0;
+  int64_t unit = 0;
+  int64_t lo = 0;
+  int64_t hi = 0;
+  int64_t d = 0;
+  int64_t ns = 0;
+  int valid = 0;
+  
+  if (codec == GRCAL_EPOCH_NTP) {
+    return encodeNtp(pDay, pNs, count, pOut);
+  }
+  
+  pc = codecOf(codec);
+  per = pc->perDay;
+  unit = pc->unitNs;
+  
+  /* The range of days since the epoch whose units fit in 64 bits,
+   * given that the time of day adds less than a day */
+  lo = INT64_MIN / per;
+  hi = (INT64_MAX - (per - 1)) / per;
+  
+  for(i = 0; i < count; i++) {
+    d = ((int64_t) pDay[i]) - pc->epoch;
+    ns = pNs[i];
+    valid = (pDay[i] >= 0) & (pDay[i] <= GRCAL_DAY_MAX) &
+              (ns >= 0) & (ns < GRCAL_EPOCH_DAY_NS) &
+              (d >= lo) & (d <= hi);
+    
+    /* Zero out invalid inputs so the arithmetic can not overflow */
+    d = valid ? d : 0;
+    ns = valid ? ns : 0;
+    pOut[i] = valid ? ((d * per) + (ns / unit)) : GRCAL_EPOCH_INVALID;
+    bad += !valid;
+  }
+  
+  return bad;
+}
+
+/*
+ * Encode an array of instants as NTP timestamps.
+ * 
+ * Parameters:
+ * 
+ *   pDay - the day offsets
+ * 
+ *   pNs - the nanoseconds since midnight
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the encoded instants
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be encoded
+ */
+static size_t encodeNtp(
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut) {
+  
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t sec = 0;
+  int64_t ns = 0;
+  uint64_t frac = 0;
+  int valid = 0;
+  
+  for(i = 0; i < count; i++) {
+    ns = pNs[i];
+    valid = (pDay[i] >= 0) & (pDay[i] <= GRCAL_DAY_MAX) &
+              (ns >= 0) & (ns < GRCAL_EPOCH_DAY_NS);
+    ns = valid ? ns : 0;
+    
+    sec = ((((int64_t) pDay[i]) - m_codecs[GRCAL_EPOCH_NTP].epoch) *
+              86400) + (ns / SECOND_NS);
+    valid &= (sec >= 0) & (sec <= INT64_C(0xffffffff));
+    
+    /* Round the fraction up so that decoding gives back ns exactly */
+    frac = ((((uint64_t) (ns % SECOND_NS)) << 32) +
+              (SECOND_NS - 1)) / SECOND_NS;
+    pOut[i] = valid ? (int64_t) ((((uint64_t) sec) << 32) | frac)
+                : GRCAL_EPOCH_INVALID;
+    bad += !valid;
+  }
+  
+  return bad;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_epochDecode function.
+ */
+int grcal_epochDecode(
+    int       codec,
+    int64_t   v,
+    int32_t * pDay,
+    int64_t * pNs) {
+  
+  int32_t day = 0;
+  int64_t ns = 0;
+  
+  if ((pDay == NULL) || (pNs == NULL)) {
+    abort();
+  }
+  codecOf(codec);
+  
+  if (decodeRun(codec, &v, 1, &day, &ns) > 0) {
+    return 0;
+  }
+  
+  *pDay = day;
+  *pNs = ns;
+  return 1;
+}
+
+/*
+ * grcal_epochEncode function.
+ */
+int grcal_epochEncode(
+    int       codec,
+    int32_t   day,
+    int64_t   ns,
+    int64_t * pv) {
+  
+  int64_t v = 0;
+  
+  if (pv == NULL) {
+    abort();
+  }
+  codecOf(codec);
+  
+  if (encodeRun(codec, &day, &ns, 1, &v) > 0) {
+    return 0;
+  }
+  
+  *pv = v;
+  return 1;
+}
+
+/*
+ * grcal_epochDecodeBatch function.
+ */
+size_t grcal_epochDecodeBatch(
+          int       codec,
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs) {
+  
+  codecOf(codec);
+  if ((count > 0) &&
+      ((pIn == NULL) || (pDay == NULL) || (pNs == NULL))) {
+    abort();
+  }
+  
+  return decodeRun(codec, pIn, count, pDay, pNs);
+}
+
+/*
+ * grcal_epochDecodeMixed function.
+ */
+size_t grcal_epochDecodeMixed(
+    const unsigned char * pCodecs,
+    const int64_t       * pIn,
+          size_t          count,
+          int32_t       * pDay,
+          int64_t       * pNs) {
+  
+  size_t i = 0;
+  size_t j = 0;
+  size_t bad = 0;
+  
+  if ((count > 0) && ((pCodecs == NULL) || (pIn == NULL) ||
+      (pDay == NULL) || (pNs == NULL))) {
+    abort();
+  }
+  
+  /* Decode each run of rows with the same codec in one call */
+  for(i = 0; i < count; i = j) {
+    codecOf(pCodecs[i]);
+    j = i + 1;
+    while ((j < count) && (pCodecs[j] == pCodecs[i])) {
+      j++;
+    }
+    bad += decodeRun(pCodecs[i], pIn + i, j - i, pDay + i, pNs + i);
+  }
+  
+  return bad;
+}
+
+/*
+ * grcal_epochEncodeBatch function.
+ */
+size_t grcal_epochEncodeBatch(
+          int       codec,
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut) {
+  
+  codecOf(codec);
+  if ((count > 0) &&
+      ((pDay == NULL) || (pNs == NULL) || (pOut == NULL))) {
+    abort();
+  }
+  
+  return encodeRun(codec, pDay, pNs, count, pOut);
+}
@@ -0,0 +1,231 @@
+#ifndef GRCAL_EPOCH_H_INCLUDED
+#define GRCAL_EPOCH_H_INCLUDED
+
+/*
+ * grcal_epoch.h
+ * =============
+ * 
+ * Conversion between common instant encodings and grcal day offsets
+ * with a time of day in nanoseconds.
+ * 
+ * Each encoding is an integer count of units since an epoch, and is
+ * selected by one of the GRCAL_EPOCH codec constants below.  Decoding
+ * splits an instant into the day offset of its UTC date and the
+ * nanoseconds since UTC midnight.  Encoding does the reverse.  Leap
+ * seconds are not represented, the same as in all of these encodings.
+ * 
+ * The batch functions have no branches in their inner loops, so the
+ * compiler can turn the division by a constant into multiplication and
+ * vectorize where the target allows.  A column that mixes encodings
+ * can be decoded in one pass with grcal_epochDecodeMixed(), which
+ * handles each run of rows that share an encoding with the same loop.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Codecs.
+ * 
+ * GRCAL_EPOCH_UNIX, _MS, _US, and _NS count seconds, milliseconds,
+ * microseconds, and nanoseconds since 1970-01-01.  Java and JavaScript
+ * timestamps are GRCAL_EPOCH_UNIX_MS.
+ * 
+ * GRCAL_EPOCH_FILETIME counts 100-nanosecond intervals since
+ * 1601-01-01, the same as the Windows FILETIME structure taken as one
+ * 64-bit value.
+ * 
+ * GRCAL_EPOCH_DOTNET counts 100-nanosecond ticks since 0001-01-01 in
+ * the proleptic Gregorian calendar, the same as the .NET DateTime.Ticks
+ * property for UTC values.
+ * 
+ * GRCAL_EPOCH_NTP is the 64-bit NTP timestamp format of era zero, with
+ * seconds since 1900-01-01 in the high 32 bits and a binary fraction of
+ * a second in the low 32 bits.  The unsigned value is passed in an
+ * int64_t with the same bits.  The fraction is rounded down to whole
+ * nanoseconds when decoding and up when encoding, so that encoding and
+ * decoding again gives back the same nanoseconds.
+ * 
+ * GRCAL_EPOCH_APPLE counts whole seconds since 2001-01-01, the epoch of
+ * Apple absolute time.  Fractional Apple times must be rounded by the
+ * caller first.
+ */
+#define GRCAL_EPOCH_UNIX     1
+#define GRCAL_EPOCH_UNIX_MS  2
+#define GRCAL_EPOCH_UNIX_US  3
+#define GRCAL_EPOCH_UNIX_NS  4
+#define GRCAL_EPOCH_FILETIME 5
+#define GRCAL_EPOCH_DOTNET   6
+#define GRCAL_EPOCH_NTP      7
+#define GRCAL_EPOCH_APPLE    8
+
+/*
+ * The number of nanoseconds in a day.
+ */
+#define GRCAL_EPOCH_DAY_NS INT64_C(86400000000000)
+
+/*
+ * The value stored by grcal_epochEncodeBatch() for instants that could
+ * not be encoded.
+ * 
+ * For GRCAL_EPOCH_UNIX_NS, this is also the encoding of a valid
+ * instant, 1677-09-21 00:12:43.145224192 UTC, and for GRCAL_EPOCH_NTP,
+ * of a valid instant in 1968.  For those codecs, the return value
+ * should be checked to tell invalid instants apart.
+ */
+#define GRCAL_EPOCH_INVALID INT64_MIN
+
+/*
+ * Decode an instant.
+ * 
+ * codec must be one of the GRCAL_EPOCH constants, or a fault occurs.
+ * 
+ * The function fails if the UTC date of the instant is outside the
+ * range of grcal day offsets.  In that case, zero is returned and
+ * nothing is written.
+ * 
+ * Parameters:
+ * 
+ *   codec - the encoding of the instant
+ * 
+ *   v - the encoded instant
+ * 
+ *   pDay - pointer to the variable to receive the day offset
+ * 
+ *   pNs - pointer to the variable to receive the nanoseconds since
+ *   midnight
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of range
+ */
+int grcal_epochDecode(
+    int       codec,
+    int64_t   v,
+    int32_t * pDay,
+    int64_t * pNs);
+
+/*
+ * Encode an instant.
+ * 
+ * codec must be one of the GRCAL_EPOCH constants, or a fault occurs.
+ * 
+ * The function fails if the day offset is out of range, if ns is not
+ * in range zero up to but excluding GRCAL_EPOCH_DAY_NS, or if the
+ * instant can not be represented in the encoding.  In that case, zero
+ * is returned and nothing is written.  Nanoseconds finer than the unit
+ * of the encoding are dropped.
+ * 
+ * Parameters:
+ * 
+ *   codec - the encoding to use
+ * 
+ *   day - the day offset
+ * 
+ *   ns - the nanoseconds since midnight
+ * 
+ *   pv - pointer to the variable to receive the encoded instant
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of range
+ */
+int grcal_epochEncode(
+    int       codec,
+    int32_t   day,
+    int64_t   ns,
+    int64_t * pv);
+
+/*
+ * Decode an array of instants.
+ * 
+ * The results are the same as calling grcal_epochDecode() on each
+ * instant, except that a day offset of -1 and zero nanoseconds are
+ * stored for instants that could not be decoded.
+ * 
+ * Parameters:
+ * 
+ *   codec - the encoding of the instants
+ * 
+ *   pIn - the encoded instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pDay - the array to receive the day offsets
+ * 
+ *   pNs - the array to receive the nanoseconds since midnight
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be decoded
+ */
+size_t grcal_epochDecodeBatch(
+          int       codec,
+    const int64_t * pIn,
+          size_t    count,
+          int32_t * pDay,
+          int64_t * pNs);
+
+/*
+ * Decode an array of instants that each have their own encoding.
+ * 
+ * This is the same as grcal_epochDecodeBatch(), except that the codec
+ * of each instant is taken from pCodecs.  Every codec must be one of
+ * the GRCAL_EPOCH constants, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pCodecs - the encoding of each instant
+ * 
+ *   pIn - the encoded instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pDay - the array to receive the day offsets
+ * 
+ *   pNs - the array to receive the nanoseconds since midnight
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be decoded
+ */
+size_t grcal_epochDecodeMixed(
+    const unsigned char * pCodecs,
+    const int64_t       * pIn,
+          size_t          count,
+          int32_t       * pDay,
+          int64_t       * pNs);
+
+/*
+ * Encode an array of instants.
+ * 
+ * The results are the same as calling grcal_epochEncode() on each
+ * instant, except that GRCAL_EPOCH_INVALID is stored for instants that
+ * could not be encoded.
+ * 
+ * Parameters:
+ * 
+ *   codec - the encoding to use
+ * 
+ *   pDay - the day offsets
+ * 
+ *   pNs - the nanoseconds since midnight
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the encoded instants
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be encoded
+ */
+size_t grcal_epochEncodeBatch(
+          int       codec,
+    const int32_t * pDay,
+    const int64_t * pNs,
+          size_t    count,
+          int64_t * pOut);
+
+#endif
@@ -0,0 +1,926 @@
+/*
+ * grcal_expr.c
+ * 
+ * Implementation of grcal_expr.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_expr.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Operation codes.
+ * 
+ * OP_DAYS, OP_MONTHS, and OP_BDAYS move by their argument.  OP_START
+ * and OP_END move to the start or end of the period given by their
+ * argument, one of the UNIT constants.  OP_NEXT and OP_PREV move to the
+ * weekday given by their argument.
+ */
+#define OP_DAYS   1
+#define OP_MONTHS 2
+#define OP_BDAYS  3
+#define OP_START  4
+#define OP_END    5
+#define OP_NEXT   6
+#define OP_PREV   7
+
+/*
+ * Units of terms.
+ */
+#define UNIT_DAY     1
+#define UNIT_WEEK    2
+#define UNIT_MONTH   3
+#define UNIT_QUARTER 4
+#define UNIT_YEAR    5
+#define UNIT_BDAY    6
+
+/*
+ * Any move by more days or months than these goes out of range, so
+ * larger arguments are clamped to them, which keeps fused arguments
+ * from overflowing.
+ */
+#define MAX_DAYS   (GRCAL_DAY_MAX + 1)
+#define MAX_MONTHS 120000
+
+/*
+ * The number of dates that each operation is applied to at a time.
+ */
+#define EXPR_BLOCK 256
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Scanner state.
+ */
+typedef struct {
+  
+  /*
+   * The expression text.
+   */
+  const char *pText;
+  
+  /*
+   * The position after the current token.
+   */
+  size_t pos;
+  
+  /*
+   * The start and length of the current token.
+   */
+  size_t start;
+  size_t len;
+  
+} SCANNER;
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * Weekday names, starting with Monday.
+ */
+static const char *m_days[7] = {
+  "monday",
+  "tuesday",
+  "wednesday",
+  "thursday",
+  "friday",
+  "saturday",
+  "sunday"
+};
+
+/*
+ * Keyword abbreviations for the starts and ends of periods, in the
+ * order of the UNIT constants starting with UNIT_WEEK.
+ */
+static const char *m_starts[4] = {"sow", "som", "soq", "soy"};
+static const char *m_ends[4] = {"eow", "eom", "eoq", "eoy"};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int lower(int c);
+static int nextToken(SCANNER *ps);
+static int matchWord(const char *pc, size_t len, const char *pWord);
+static int tokenIs(const SCANNER *ps, const char *pWord);
+static int parseNumber(
+    const char    * pc,
+          size_t    len,
+          size_t  * pUsed,
+          int32_t * pv);
+static int unitOf(const char *pc, size_t len);
+static int periodOf(const SCANNER *ps);
+static int weekdayOf(const SCANNER *ps);
+static int addOp(GRCAL_EXPR *pe, int code, int64_t arg);
+static int parseDuration(
+    GRCAL_EXPR * pe,
+    const char * pc,
+    size_t       len,
+    int          sign);
+static int parseTerm(GRCAL_EXPR *pe, SCANNER *ps);
+static int32_t addMonths(int32_t offs, int32_t n);
+static int32_t periodBound(int32_t offs, int unit, int end);
+static void applyOp(
+    const GRCAL_EXPR_OP * po,
+    const GRCAL_BDAY    * pCal,
+          int32_t       * pb,
+          size_t          n);
+
+/*
+ * Convert an ASCII letter to lowercase.
+ * 
+ * Parameters:
+ * 
+ *   c - the character
+ * 
+ * Return:
+ * 
+ *   the lowercase letter, or the character unchanged if it is not an
+ *   uppercase letter
+ */
+static int lower(int c) {
+  if ((c >= 'A') && (c <= 'Z')) {
+    return c - 'A' + 'a';
+  }
+  return c;
+}
+
+/*
+ * Advance to the next token, which is a run of characters other than
+ * spaces, tabs, and line breaks.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scanner
+ * 
+ * Return:
+ * 
+ *   non-zero if there is a token, zero at the end of the text
+ */
+static int nextToken(SCANNER *ps) {
+  
+  const char *pc = NULL;
+  size_t i = 0;
+  
+  pc = ps->pText;
+  i = ps->pos;
+  while ((pc[i] == ' ') || (pc[i] == '\t') || (pc[i] == '\r') ||
+          (pc[i] == '\n')) {
+    i++;
+  }
+  
+  ps->start = i;
+  while ((pc[i] != 0) && (pc[i] != ' ') && (pc[i] != '\t') &&
+          (pc[i] != '\r') && (pc[i] != '\n')) {
+    i++;
+  }
+  ps->len = i - ps->start;
+  ps->pos = i;
+  
+  return (ps->len > 0);
+}
+
+/*
+ * Compare a string to a lowercase word, ignoring case.
+ * 
+ * Parameters:
+ * 
+ *   pc - the string
+ * 
+ *   len - the length of the string
+ * 
+ *   pWord - the lowercase word, nul-terminated
+ * 
+ * Return:
+ * 
+ *   non-zero if they match, zero if not
+ */
+static int matchWord(const char *pc, size_t len, const char *pWord) {
+  
+  size_t i = 0;
+  
+  for(i = 0; i < len; i++) {
+    if (lower((unsigned char) pc[i]) != pWord[i]) {
+      return 0;
+    }
+  }
+  return (pWord[len] == 0);
+}
+
+/*
+ * Compare the current token to a lowercase word, ignoring case.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scanner
+ * 
+ *   pWord - the lowercase word
+ * 
+ * Return:
+ * 
+ *   non-zero if they match, zero if not
+ */
+static int tokenIs(const SCANNER *ps, const char *pWord) {
+  return matchWord(ps->pText + ps->start, ps->len, pWord);
+}
+
+/*
+ * Parse a run of decimal digits.
+ * 
+ * Parameters:
+ * 
+ *   pc - the string
+ * 
+ *   len - the length of the string
+ * 
+ *   pUsed - pointer to the variable to receive the number of digits
+ * 
+ *   pv - pointer to the variable to receive the value
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if there are no digits or the value is
+ *   greater than GRCAL_EXPR_MAX_NUMBER
+ */
+static int parseNumber(
+    const char    * pc,
+          size_t    len,
+          size_t  * pUsed,
+          int32_t * pv) {
+  
+  size_t i = 0;
+  int32_t v = 0;
+  
+  for(i = 0; (i < len) && (pc[i] >= '0') && (pc[i] <= '9'); i++) {
+    v = (v * 10) + (pc[i] - '0');
+    if (v > GRCAL_EXPR_MAX_NUMBER) {
+      return 0;
+    }
+  }
+  
+  *pUsed = i;
+  *pv = v;
+  return (i > 0);
+}
+
+/*
+ * Get the unit named by a word.
+ * 
+ * Parameters:
+ * 
+ *   pc - the word
+ * 
+ *   len - the length of the word
+ * 
+ * Return:
+ * 
+ *   one of the UNIT constants, or zero if the word is not a unit
+ */
+static int unitOf(const char *pc, size_t len) {
+  
+  if (matchWord(pc, len, "d") || matchWord(pc, len, "day") ||
+      matchWord(pc, len, "days")) {
+    return UNIT_DAY;
+  }
+  if (matchWord(pc, len, "w") || matchWord(pc, len, "week") ||
+      matchWord(pc, len, "weeks")) {
+    return UNIT_WEEK;
+  }
+  if (matchWord(pc, len, "m") || matchWord(pc, len, "month") ||
+      matchWord(pc, len, "months")) {
+    return UNIT_MONTH;
+  }
+  if (matchWord(pc, len, "q") || matchWord(pc, len, "quarter") ||
+      matchWord(pc, len, "quarters")) {
+    return UNIT_QUARTER;
+  }
+  if (matchWord(pc, len, "y") || matchWord(pc, len, "year") ||
+      matchWord(pc, len, "years")) {
+    return UNIT_YEAR;
+  }
+  if (matchWord(pc, len, "bd")) {
+    return UNIT_BDAY;
+  }
+  return 0;
+}
+
+/*
+ * Get the period named by the current token, for "start of" and "end
+ * of" terms.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scanner
+ * 
+ * Return:
+ * 
+ *   UNIT_WEEK, UNIT_MONTH, UNIT_QUARTER, or UNIT_YEAR, or zero if the
+ *   token is not a period
+ */
+static int periodOf(const SCANNER *ps) {
+  
+  if (tokenIs(ps, "week")) {
+    return UNIT_WEEK;
+  }
+  if (tokenIs(ps, "month")) {
+    return UNIT_MONTH;
+  }
+  if (tokenIs(ps, "quarter")) {
+    return UNIT_QUARTER;
+  }
+  if (tokenIs(ps, "year")) {
+    return UNIT_YEAR;
+  }
+  return 0;
+}
+
+/*
+ * Get the weekday named by the current token, either in full or by its
+ * first three letters.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scanner
+ * 
+ * Return:
+ * 
+ *   the weekday where one is Monday, or zero if the token is not a
+ *   weekday
+ */
+static int weekdayOf(const SCANNER *ps) {
+  
+  int i = 0;
+  char abbr[4];
+  
+  for(i = 0; i < 7; i++) {
+    abbr[0] = m_days[i][0];
+    abbr[1] = m_days[i][1];
+    abbr[2] = m_days[i][2];
+    abbr[3] = 0;
+    if (tokenIs(ps, m_days[i]) || tokenIs(ps, abbr)) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Append an operation to a compiled expression.
+ * 
+ * Moves by zero are dropped, and a move by days directly after another
+ * move by days in the same direction is fused into it.
+ * 
+ * Parameters:
+ * 
+ *   pe - the expression
+ * 
+ *   code - the operation code
+ * 
+ *   arg - the operation argument
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the expression is full
+ */
+static int addOp(GRCAL_EXPR *pe, int code, int64_t arg) {
+  
+  GRCAL_EXPR_OP *pLast = NULL;
+  
+  if ((code == OP_DAYS) || (code == OP_MONTHS) || (code == OP_BDAYS)) {
+    if (arg == 0) {
+      return 1;
+    }
+  }
+  if (code == OP_BDAYS) {
+    pe->business = 1;
+  }
+  
+  /* Fuse consecutive moves by days in the same direction.  The step
+   * between them then lies between the start and the result, so it is
+   * in range whenever the fused result is.  Moves in opposite
+   * directions are kept apart, since an intermediate result that is
+   * out of range must still give -1 */
+  if (pe->count > 0) {
+    pLast = &((pe->ops)[pe->count - 1]);
+    if ((code == OP_DAYS) && (pLast->code == OP_DAYS) &&
+        ((arg > 0) == (pLast->arg > 0))) {
+      arg += pLast->arg;
+      pe->count--;
+    }
+  }
+  
+  /* Clamp arguments that go out of range anyway */
+  if (code == OP_DAYS) {
+    if (arg > MAX_DAYS) {
+      arg = MAX_DAYS;
+    } else if (arg < -MAX_DAYS) {
+      arg = -MAX_DAYS;
+    }
+  } else if (code == OP_MONTHS) {
+    if (arg > MAX_MONTHS) {
+      arg = MAX_MONTHS;
+    } else if (arg < -MAX_MONTHS) {
+      arg = -MAX_MONTHS;
+    }
+  }
+  
+  if (pe->count >= GRCAL_EXPR_MAX_OPS) {
+    return 0;
+  }
+  (pe->ops)[pe->count].code = code;
+  (pe->ops)[pe->count].arg = (int32_t) arg;
+  (pe->count)++;
+  return 1;
+}
+
+/*
+ * Parse the body of an ISO 8601 duration, after the P.
+ * 
+ * Parameters:
+ * 
+ *   pe - the expression to append to
+ * 
+ *   pc - the body
+ * 
+ *   len - the length of the body
+ * 
+ *   sign - one or minus one
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the body is not valid or the
+ *   expression is full
+ */
+static int parseDuration(
+    GRCAL_EXPR * pe,
+    const char * pc,
+    size_t       len,
+    int          sign) {
+  
+  static const char DESIGNATORS[5] = "ymwd";
+  
+  int64_t months = 0;
+  int64_t days = 0;
+  size_t used = 0;
+  int32_t v = 0;
+  int next = 0;
+  int k = 0;
+  
+  if (len < 1) {
+    return 0;
+  }
+  
+  /* Each part is a number followed by a designator, in order */
+  while (len > 0) {
+    if (!parseNumber(pc, len, &used, &v)) {
+      return 0;
+    }
+    if (used >= len) {
+      return 0;
+    }
+    for(k = next; k < 4; k++) {
+      if (lower((unsigned char) pc[used]) == DESIGNATORS[k]) {
+        break;
+      }
+    }
+    if (k >= 4) {
+      return 0;
+    }
+    
+    if (k == 0) {
+      months += ((int64_t) v) * 12;
+    } else if (k == 1) {
+      months += v;
+    } else if (k == 2) {
+      days += ((int64_t) v) * 7;
+    } else {
+      days += v;
+    }
+    
+    next = k + 1;
+    pc += used + 1;
+    len -= used + 1;
+  }
+  
+  return addOp(pe, OP_MONTHS, sign * months) &&
+          addOp(pe, OP_DAYS, sign * days);
+}
+
+/*
+ * Parse one term, starting at the current token.
+ * 
+ * Parameters:
+ * 
+ *   pe - the expression to append to
+ * 
+ *   ps - the scanner, positioned at the first token of the term
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the term is not valid or the
+ *   expression is full; in that case, the scanner is positioned at the
+ *   offending token
+ */
+static int parseTerm(GRCAL_EXPR *pe, SCANNER *ps) {
+  
+  const char *pc = NULL;
+  size_t len = 0;
+  size_t used = 0;
+  int32_t v = 0;
+  int sign = 1;
+  int unit = 0;
+  int k = 0;
+  
+  pc = ps->pText + ps->start;
+  len = ps->len;
+  
+  /* Optional sign */
+  if ((pc[0] == '+') || (pc[0] == '-')) {
+    sign = (pc[0] == '-') ? -1 : 1;
+    pc++;
+    len--;
+  }
+  
+  /* ISO 8601 duration, told apart from "previous" by the digit */
+  if ((len > 1) && (lower((unsigned char) pc[0]) == 'p') &&
+      (pc[1] >= '0') && (pc[1] <= '9')) {
+    return parseDuration(pe, pc + 1, len - 1, sign);
+  }
+  
+  /* Number followed by a unit, in the same token or the next */
+  if ((len > 0) && (pc[0] >= '0') && (pc[0] <= '9')) {
+    if (!parseNumber(pc, len, &used, &v)) {
+      return 0;
+    }
+    if (used < len) {
+      unit = unitOf(pc + used, len - used);
+    } else {
+      if (!nextToken(ps)) {
+        return 0;
+      }
+      unit = unitOf(ps->pText + ps->start, ps->len);
+      if ((unit == 0) && tokenIs(ps, "business")) {
+        if (!nextToken(ps)) {
+          return 0;
+        }
+        if (tokenIs(ps, "day") || tokenIs(ps, "days")) {
+          unit = UNIT_BDAY;
+        }
+      }
+    }
+    
+    if (unit == UNIT_DAY) {
+      return addOp(pe, OP_DAYS, sign * v);
+    } else if (unit == UNIT_WEEK) {
+      return addOp(pe, OP_DAYS, sign * ((int64_t) v) * 7);
+    } else if (unit == UNIT_MONTH) {
+      return addOp(pe, OP_MONTHS, sign * v);
+    } else if (unit == UNIT_QUARTER) {
+      return addOp(pe, OP_MONTHS, sign * ((int64_t) v) * 3);
+    } else if (unit == UNIT_YEAR) {
+      return addOp(pe, OP_MONTHS, sign * ((int64_t) v) * 12);
+    } else if (unit == UNIT_BDAY) {
+      return addOp(pe, OP_BDAYS, sign * v);
+    }
+    return 0;
+  }
+  
+  /* Everything else is a keyword, which takes no sign */
+  if (len != ps->len) {
+    return 0;
+  }
+  
+  for(k = 0; k < 4; k++) {
+    if (tokenIs(ps, m_starts[k])) {
+      return addOp(pe, OP_START, UNIT_WEEK + k);
+    }
+    if (tokenIs(ps, m_ends[k])) {
+      return addOp(pe, OP_END, UNIT_WEEK + k);
+    }
+  }
+  
+  if (tokenIs(ps, "start") || tokenIs(ps, "end")) {
+    k = tokenIs(ps, "end") ? OP_END : OP_START;
+    if ((!nextToken(ps)) || (!tokenIs(ps, "of"))) {
+      return 0;
+    }
+    if (!nextToken(ps)) {
+      return 0;
+    }
+    unit = periodOf(ps);
+    if (unit == 0) {
+      return 0;
+    }
+    return addOp(pe, k, unit);
+  }
+  
+  if (tokenIs(ps, "next") || tokenIs(ps, "previous") ||
+      tokenIs(ps, "prev")) {
+    sign = tokenIs(ps, "next") ? 1 : -1;
+    if (!nextToken(ps)) {
+      return 0;
+    }
+    if (tokenIs(ps, "bd")) {
+      return addOp(pe, OP_BDAYS, sign);
+    }
+    if (tokenIs(ps, "business")) {
+      if ((!nextToken(ps)) || (!tokenIs(ps, "day"))) {
+        return 0;
+      }
+      return addOp(pe, OP_BDAYS, sign);
+    }
+    k = weekdayOf(ps);
+    if (k == 0) {
+      return 0;
+    }
+    return addOp(pe, (sign > 0) ? OP_NEXT : OP_PREV, k);
+  }
+  
+  return 0;
+}
+
+/*
+ * Move a day offset by a number of months, clamping the day of the
+ * month.
+ * 
+ * Parameters:
+ * 
+ *   offs - the valid day offset
+ * 
+ *   n - the number of months, at most MAX_MONTHS in magnitude
+ * 
+ * Return:
+ * 
+ *   the resulting day offset, or -1 if it is out of range
+ */
+static int32_t addMonths(int32_t offs, int32_t n) {
+  
+  int32_t result = 0;
+  int32_t index = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  grcal_offsetToDate(offs, &y, &m, &d);
+  
+  index = (((int32_t) y) * 12) + (m - 1) + n;
+  if ((index < 1582 * 12) || (index > (9999 * 12) + 11)) {
+    return -1;
+  }
+  y = (int) (index / 12);
+  m = (int) (index % 12) + 1;
+  if (d > grcal_privMonthDays(y, m)) {
+    d = grcal_privMonthDays(y, m);
+  }
+  
+  if (!grcal_dateToOffset(&result, y, m, d)) {
+    return -1;
+  }
+  return result;
+}
+
+/*
+ * Move a day offset to the start or end of its week, month, quarter, or
+ * year.
+ * 
+ * Parameters:
+ * 
+ *   offs - the valid day offset
+ * 
+ *   unit - UNIT_WEEK, UNIT_MONTH, UNIT_QUARTER, or UNIT_YEAR
+ * 
+ *   end - non-zero for the end of the period, zero for the start
+ * 
+ * Return:
+ * 
+ *   the resulting day offset, or -1 if it is out of range
+ */
+static int32_t periodBound(int32_t offs, int unit, int end) {
+  
+  int32_t result = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  int w = 0;
+  
+  if (unit == UNIT_WEEK) {
+    w = grcal_weekday(offs);
+    result = end ? (offs + (7 - w)) : (offs - (w - 1));
+    if ((result < 0) || (result > GRCAL_DAY_MAX)) {
+      return -1;
+    }
+    return result;
+  }
+  
+  grcal_offsetToDate(offs, &y, &m, &d);
+  if (unit == UNIT_MONTH) {
+    d = end ? grcal_privMonthDays(y, m) : 1;
+  } else if (unit == UNIT_QUARTER) {
+    m = (((m - 1) / 3) * 3) + (end ? 3 : 1);
+    d = end ? grcal_privMonthDays(y, m) : 1;
+  } else {
+    m = end ? 12 : 1;
+    d = end ? 31 : 1;
+  }
+  
+  if (!grcal_dateToOffset(&result, y, m, d)) {
+    return -1;
+  }
+  return result;
+}
+
+/*
+ * Apply one operation to a block of day offsets in place.
+ * 
+ * Parameters:
+ * 
+ *   po - the operation
+ * 
+ *   pCal - the business-day calendar, or NULL if not needed
+ * 
+ *   pb - the block, where -1 marks an invalid entry
+ * 
+ *   n - the number of entries in the block
+ */
+static void applyOp(
+    const GRCAL_EXPR_OP * po,
+    const GRCAL_BDAY    * pCal,
+          int32_t       * pb,
+          size_t          n) {
+  
+  size_t i = 0;
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t arg = 0;
+  int w = 0;
+  
+  arg = po->arg;
+  
+  if (po->code == OP_DAYS) {
+    /* Branch-free so that it vectorizes */
+    for(i = 0; i < n; i++) {
+      x = pb[i];
+      y = x + arg;
+      pb[i] = ((x >= 0) & (y >= 0) & (y <= GRCAL_DAY_MAX)) ? y : -1;
+    }
+    
+  } else if (po->code == OP_MONTHS) {
+    for(i = 0; i < n; i++) {
+      if (pb[i] >= 0) {
+        pb[i] = addMonths(pb[i], arg);
+      }
+    }
+    
+  } else if (po->code == OP_BDAYS) {
+    for(i = 0; i < n; i++) {
+      if (pb[i] >= 0) {
+        pb[i] = grcal_bdayAdd(pCal, pb[i], arg);
+      }
+    }
+    
+  } else if ((po->code == OP_START) || (po->code == OP_END)) {
+    for(i = 0; i < n; i++) {
+      if (pb[i] >= 0) {
+        pb[i] = periodBound(pb[i], arg, (po->code == OP_END));
+      }
+    }
+    
+  } else {
+    for(i = 0; i < n; i++) {
+      x = pb[i];
+      if (x >= 0) {
+        w = grcal_weekday(x);
+        if (po->code == OP_NEXT) {
+          x += ((arg - w + 6) % 7) + 1;
+        } else {
+          x -= ((w - arg + 6) % 7) + 1;
+        }
+        pb[i] = ((x >= 0) && (x <= GRCAL_DAY_MAX)) ? x : -1;
+      }
+    }
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_exprCompile function.
+ */
+int grcal_exprCompile(
+          GRCAL_EXPR * pExpr,
+    const char       * pText,
+          size_t     * pErrPos) {
+  
+  SCANNER sc;
+  
+  if ((pExpr == NULL) || (pText == NULL)) {
+    abort();
+  }
+  
+  pExpr->count = 0;
+  pExpr->business = 0;
+  
+  sc.pText = pText;
+  sc.pos = 0;
+  sc.start = 0;
+  sc.len = 0;
+  
+  while (nextToken(&sc)) {
+    if (!parseTerm(pExpr, &sc)) {
+      if (pErrPos != NULL) {
+        *pErrPos = sc.start;
+      }
+      pExpr->count = 0;
+      pExpr->business = 0;
+      return 0;
+    }
+  }
+  
+  return 1;
+}
+
+/*
+ * grcal_exprBusiness function.
+ */
+int grcal_exprBusiness(const GRCAL_EXPR *pExpr) {
+  
+  if (pExpr == NULL) {
+    abort();
+  }
+  
+  return pExpr->business;
+}
+
+/*
+ * grcal_exprApply function.
+ */
+size_t grcal_exprApply(
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal,
+    const int32_t    * pIn,
+          size_t       count,
+          int32_t    * pOut) {
+  
+  size_t i = 0;
+  size_t j = 0;
+  size_t n = 0;
+  size_t bad = 0;
+  int32_t *pb = NULL;
+  int32_t x = 0;
+  int k = 0;
+  
+  /* Check parameters */
+  if (pExpr == NULL) {
+    abort();
+  }
+  if ((count > 0) && ((pIn == NULL) || (pOut == NULL))) {
+    abort();
+  }
+  if (pExpr->business && (pCal == NULL)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i += n) {
+    n = count - i;
+    if (n > EXPR_BLOCK) {
+      n = EXPR_BLOCK;
+    }
+    pb = pOut + i;
+    
+    /* Copy the block, marking invalid inputs */
+    for(j = 0; j < n; j++) {
+      x = pIn[i + j];
+      pb[j] = ((x >= 0) & (x <= GRCAL_DAY_MAX)) ? x : -1;
+    }
+    
+    /* Apply each operation to the whole block in turn */
+    for(k = 0; k < pExpr->count; k++) {
+      applyOp(&((pExpr->ops)[k]), pCal, pb, n);
+    }
+    
+    for(j = 0; j < n; j++) {
+      bad += (pb[j] < 0);
+    }
+  }
+  
+  return bad;
+}
@@ -0,0 +1,163 @@
+#ifndef GRCAL_EXPR_H_INCLUDED
+#define GRCAL_EXPR_H_INCLUDED
+
+/*
+ * grcal_expr.h
+ * ============
+ * 
+ * Compiled relative date expressions.
+ * 
+ * An expression such as "+3M EOM" or "P1Y2M10D previous Friday" is
+ * compiled once into a short sequence of operations, which can then be
+ * applied to whole arrays of day offsets.  Adjacent operations that
+ * only move by a fixed number of days in the same direction are fused
+ * into a single addition, and each operation is applied to a block of
+ * dates at a time so that the simple ones vectorize.
+ * 
+ * Syntax
+ * ------
+ * 
+ * An expression is a sequence of terms separated by white space, which
+ * are applied from left to right.  Keywords are not case sensitive.
+ * 
+ *   P1Y2M3W4D - an ISO 8601 duration with any of the year, month, week,
+ *   and day parts, optionally preceded by a sign; time parts are not
+ *   supported
+ * 
+ *   +3D, -2W, +3M, +1Q, -1Y - move by a number of days, weeks, months,
+ *   quarters, or years; the sign is optional, the unit may also be
+ *   separated by a space or spelled out, as in "+3 months"
+ * 
+ *   +2BD, -1 BD, +2 business days - move by a number of business days
+ * 
+ *   SOW, EOW, SOM, EOM, SOQ, EOQ, SOY, EOY - move to the start or end
+ *   of the week, month, quarter, or year; these may also be spelled
+ *   out, as in "end of month"
+ * 
+ *   next Friday, previous Mon - move to the nearest given weekday
+ *   strictly after or before the date
+ * 
+ *   next BD, previous BD - move to the nearest business day strictly
+ *   after or before the date
+ * 
+ * Weeks run from Monday to Sunday.  Moving by months, quarters, or
+ * years keeps the day of the month, clamped to the length of the
+ * resulting month, so 2024-01-31 moved by "+1M" is 2024-02-29.  The
+ * year and month parts of an ISO duration are moved together, then the
+ * week and day parts.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_bday.h"
+#include <stddef.h>
+
+/*
+ * The maximum number of operations in a compiled expression.
+ */
+#define GRCAL_EXPR_MAX_OPS 32
+
+/*
+ * The largest magnitude of a number in an expression.
+ */
+#define GRCAL_EXPR_MAX_NUMBER 9999999
+
+/*
+ * One compiled operation.
+ * 
+ * The contents are private to grcal_expr.c.
+ */
+typedef struct {
+  int code;
+  int32_t arg;
+} GRCAL_EXPR_OP;
+
+/*
+ * Compiled expression structure.
+ * 
+ * The contents are private to grcal_expr.c.  A compiled expression does
+ * not refer to the text it was compiled from, and it may be copied and
+ * applied from any number of threads at once.
+ */
+typedef struct {
+  int count;
+  int business;
+  GRCAL_EXPR_OP ops[GRCAL_EXPR_MAX_OPS];
+} GRCAL_EXPR;
+
+/*
+ * Compile a date expression.
+ * 
+ * If the text can not be compiled, zero is returned and pErrPos, if
+ * not NULL, receives the index of the character where compilation
+ * failed.  This happens on a syntax error, a number larger than
+ * GRCAL_EXPR_MAX_NUMBER, or an expression that needs more than
+ * GRCAL_EXPR_MAX_OPS operations after fusion.  An empty expression is
+ * valid and leaves dates unchanged.
+ * 
+ * Parameters:
+ * 
+ *   pExpr - the structure to receive the compiled expression
+ * 
+ *   pText - the expression text
+ * 
+ *   pErrPos - pointer to the variable to receive the error position, or
+ *   NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the text could not be compiled
+ */
+int grcal_exprCompile(
+          GRCAL_EXPR * pExpr,
+    const char       * pText,
+          size_t     * pErrPos);
+
+/*
+ * Determine whether a compiled expression uses business days.
+ * 
+ * Parameters:
+ * 
+ *   pExpr - the compiled expression
+ * 
+ * Return:
+ * 
+ *   non-zero if the expression needs a business-day calendar, zero if
+ *   not
+ */
+int grcal_exprBusiness(const GRCAL_EXPR *pExpr);
+
+/*
+ * Apply a compiled expression to an array of day offsets.
+ * 
+ * pCal is the business-day calendar.  It may be NULL if the expression
+ * does not use business days, or a fault occurs.
+ * 
+ * The result for an input that is not a valid day offset, or whose
+ * result at any step falls outside the range of day offsets, is -1.
+ * The input and output arrays may be the same array.
+ * 
+ * Parameters:
+ * 
+ *   pExpr - the compiled expression
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ *   pIn - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pOut - the array to receive the results
+ * 
+ * Return:
+ * 
+ *   the number of results that are -1
+ */
+size_t grcal_exprApply(
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal,
+    const int32_t    * pIn,
+          size_t       count,
+          int32_t    * pOut);
+
+#endif
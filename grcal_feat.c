@@ -0,0 +1,415 @@
+/*
+ * grcal_feat.c
+ * 
+ * Implementation of grcal_feat.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_feat.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of features.
+ */
+#define FEAT_COUNT 12
+
+/*
+ * Feature groups, by the work that they need beyond the decomposition
+ * into year, month, and day.
+ * 
+ * The ISO features need the weekday and the ISO week counts of three
+ * years, and the month features need the leap year flag and the month
+ * length.  The weekday on its own needs no decomposition at all.
+ */
+#define FEAT_ISO (GRCAL_FEAT_ISO_WEEK | GRCAL_FEAT_ISO_YEAR)
+
+#define FEAT_MONTH (GRCAL_FEAT_DAY_OF_YEAR | GRCAL_FEAT_IS_MONTH_END | \
+                    GRCAL_FEAT_IS_LEAP | GRCAL_FEAT_DAYS_IN_MONTH | \
+                    GRCAL_FEAT_DAYS_TO_MONTH_END)
+
+#define FEAT_DATE (GRCAL_FEAT_YEAR | GRCAL_FEAT_MONTH | \
+                    GRCAL_FEAT_DAY | GRCAL_FEAT_QUARTER)
+
+/*
+ * The number of day offsets processed at a time.
+ * 
+ * All features of a block take 12 KiB, which fits in a typical L1 data
+ * cache.
+ */
+#define FEAT_BLOCK 256
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Scratch space for the features of a block of day offsets that are
+ * computed but not selected, indexed in the same order as the feature
+ * bits.
+ */
+typedef struct {
+  int32_t f[FEAT_COUNT][FEAT_BLOCK];
+} FEAT_BLOCKS;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t *outputOf(const GRCAL_FEAT_OUT *pOut, int k);
+static int32_t isoShift(int32_t y);
+static void weekdayLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pWeekday);
+static void dateLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pQuarter);
+static void monthLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pQuarter,
+          int32_t * restrict pDayOfYear,
+          int32_t * restrict pIsMonthEnd,
+          int32_t * restrict pIsLeap,
+          int32_t * restrict pDaysInMonth,
+          int32_t * restrict pDaysToMonthEnd);
+static void fullLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pWeekday,
+          int32_t * restrict pDayOfYear,
+          int32_t * restrict pIsoWeek,
+          int32_t * restrict pIsoYear,
+          int32_t * restrict pQuarter,
+          int32_t * restrict pIsMonthEnd,
+          int32_t * restrict pIsLeap,
+          int32_t * restrict pDaysInMonth,
+          int32_t * restrict pDaysToMonthEnd);
+
+/*
+ * Get the output array of a feature.
+ * 
+ * Parameters:
+ * 
+ *   pOut - the output arrays
+ * 
+ *   k - the index of the feature bit
+ * 
+ * Return:
+ * 
+ *   the output array, which may be NULL
+ */
+static int32_t *outputOf(const GRCAL_FEAT_OUT *pOut, int k) {
+  
+  int32_t *pa = NULL;
+  
+  if (k == 0) {
+    pa = pOut->pYear;
+  } else if (k == 1) {
+    pa = pOut->pMonth;
+  } else if (k == 2) {
+    pa = pOut->pDay;
+  } else if (k == 3) {
+    pa = pOut->pWeekday;
+  } else if (k == 4) {
+    pa = pOut->pDayOfYear;
+  } else if (k == 5) {
+    pa = pOut->pIsoWeek;
+  } else if (k == 6) {
+    pa = pOut->pIsoYear;
+  } else if (k == 7) {
+    pa = pOut->pQuarter;
+  } else if (k == 8) {
+    pa = pOut->pIsMonthEnd;
+  } else if (k == 9) {
+    pa = pOut->pIsLeap;
+  } else if (k == 10) {
+    pa = pOut->pDaysInMonth;
+  } else {
+    pa = pOut->pDaysToMonthEnd;
+  }
+  
+  return pa;
+}
+
+/*
+ * Get a weekday shift for the end of a year, used to count its ISO
+ * weeks.
+ * 
+ * A year has 53 ISO weeks if its shift is 4, meaning that it ends on a
+ * Thursday, or if the shift of the year before is 3, meaning that it
+ * starts on a Thursday.
+ * 
+ * Parameters:
+ * 
+ *   y - the year, which must not be negative
+ * 
+ * Return:
+ * 
+ *   the weekday of December 31, where zero is Sunday
+ */
+static int32_t isoShift(int32_t y) {
+  return (y + (y / 4) - (y / 100) + (y / 400)) % 7;
+}
+
+/*
+ * Feature loops over a block of valid day offsets.
+ * 
+ * Each loop computes one group of features and everything that the
+ * groups below it compute, storing each feature in its own array.  The
+ * arrays are either the outputs of selected features or scratch space,
+ * and never overlap, so the loops have no branches and vectorize.
+ * 
+ * weekdayLoop computes the weekday.  dateLoop computes the year, month,
+ * day, and quarter.  monthLoop adds the FEAT_MONTH features.  fullLoop
+ * computes every feature.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   n - the number of day offsets, at most FEAT_BLOCK
+ * 
+ *   the rest - the arrays to receive the features
+ */
+static void weekdayLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pWeekday) {
+  
+  size_t i = 0;
+  
+  /* Day offset zero is a Friday */
+  for(i = 0; i < n; i++) {
+    pWeekday[i] = ((pOffs[i] + 4) % 7) + 1;
+  }
+}
+
+static void dateLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pQuarter) {
+  
+  size_t i = 0;
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t doy = 0;
+  
+  for(i = 0; i < n; i++) {
+    grcal_privSplit(pOffs[i], &year, &month, &day, &doy);
+    
+    pYear[i] = year;
+    pMonth[i] = month;
+    pDay[i] = day;
+    pQuarter[i] = ((month - 1) / 3) + 1;
+  }
+}
+
+static void monthLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pQuarter,
+          int32_t * restrict pDayOfYear,
+          int32_t * restrict pIsMonthEnd,
+          int32_t * restrict pIsLeap,
+          int32_t * restrict pDaysInMonth,
+          int32_t * restrict pDaysToMonthEnd) {
+  
+  size_t i = 0;
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t doy = 0;
+  int32_t leap = 0;
+  int32_t len = 0;
+  
+  for(i = 0; i < n; i++) {
+    grcal_privSplit(pOffs[i], &year, &month, &day, &doy);
+    
+    leap = grcal_privIsLeap(year);
+    len = grcal_privMonthDays(year, month);
+    
+    pYear[i] = year;
+    pMonth[i] = month;
+    pDay[i] = day;
+    pQuarter[i] = ((month - 1) / 3) + 1;
+    
+    /* doy counts from March 1, so January and February come last */
+    pDayOfYear[i] = (month <= 2) ? (doy - 305) : (doy + 60 + leap);
+    
+    pIsMonthEnd[i] = (day == len);
+    pIsLeap[i] = leap;
+    pDaysInMonth[i] = len;
+    pDaysToMonthEnd[i] = len - day;
+  }
+}
+
+static void fullLoop(
+    const int32_t * restrict pOffs,
+          size_t             n,
+          int32_t * restrict pYear,
+          int32_t * restrict pMonth,
+          int32_t * restrict pDay,
+          int32_t * restrict pWeekday,
+          int32_t * restrict pDayOfYear,
+          int32_t * restrict pIsoWeek,
+          int32_t * restrict pIsoYear,
+          int32_t * restrict pQuarter,
+          int32_t * restrict pIsMonthEnd,
+          int32_t * restrict pIsLeap,
+          int32_t * restrict pDaysInMonth,
+          int32_t * restrict pDaysToMonthEnd) {
+  
+  size_t i = 0;
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t day = 0;
+  int32_t doy = 0;
+  int32_t wd = 0;
+  int32_t yday = 0;
+  int32_t leap = 0;
+  int32_t len = 0;
+  int32_t week = 0;
+  int32_t weeks = 0;
+  int32_t prevWeeks = 0;
+  int32_t early = 0;
+  int32_t late = 0;
+  
+  for(i = 0; i < n; i++) {
+    grcal_privSplit(pOffs[i], &year, &month, &day, &doy);
+    
+    leap = grcal_privIsLeap(year);
+    len = grcal_privMonthDays(year, month);
+    yday = (month <= 2) ? (doy - 305) : (doy + 60 + leap);
+    wd = ((pOffs[i] + 4) % 7) + 1;
+    
+    /* ISO week, which may belong to the year before or after */
+    week = (yday - wd + 10) / 7;
+    weeks = 52 + ((isoShift(year) == 4) | (isoShift(year - 1) == 3));
+    prevWeeks = 52 + ((isoShift(year - 1) == 4) |
+                        (isoShift(year - 2) == 3));
+    early = (week < 1);
+    late = (week > weeks);
+    
+    pYear[i] = year;
+    pMonth[i] = month;
+    pDay[i] = day;
+    pWeekday[i] = wd;
+    pDayOfYear[i] = yday;
+    pIsoWeek[i] = early ? prevWeeks : (late ? 1 : week);
+    pIsoYear[i] = year - early + late;
+    pQuarter[i] = ((month - 1) / 3) + 1;
+    pIsMonthEnd[i] = (day == len);
+    pIsLeap[i] = leap;
+    pDaysInMonth[i] = len;
+    pDaysToMonthEnd[i] = len - day;
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_featExtract function.
+ */
+void grcal_featExtract(
+    const int32_t        * pOffs,
+          size_t           count,
+          unsigned         mask,
+    const GRCAL_FEAT_OUT * pOut) {
+  
+  FEAT_BLOCKS blk;
+  int32_t *pDst[FEAT_COUNT];
+  const int32_t *pb = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  int k = 0;
+  
+  /* Check parameters */
+  if ((pOut == NULL) || ((mask & ~GRCAL_FEAT_ALL) != 0)) {
+    abort();
+  }
+  if ((pOffs == NULL) && (count > 0)) {
+    abort();
+  }
+  for(k = 0; k < FEAT_COUNT; k++) {
+    if ((mask & (1u << k)) && (outputOf(pOut, k) == NULL)) {
+      abort();
+    }
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  if (mask == 0) {
+    return;
+  }
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > FEAT_BLOCK) {
+      n = FEAT_BLOCK;
+    }
+    pb = pOffs + pos;
+    
+    /* Selected features go straight to their outputs, and the others
+     * that the chosen loop computes go to scratch space */
+    for(k = 0; k < FEAT_COUNT; k++) {
+      if (mask & (1u << k)) {
+        pDst[k] = outputOf(pOut, k) + pos;
+      } else {
+        pDst[k] = (blk.f)[k];
+      }
+    }
+    
+    /* Run the cheapest loop that covers the selected features */
+    if (mask & FEAT_ISO) {
+      fullLoop(pb, n, pDst[0], pDst[1], pDst[2], pDst[3], pDst[4],
+                  pDst[5], pDst[6], pDst[7], pDst[8], pDst[9],
+                  pDst[10], pDst[11]);
+      
+    } else {
+      if (mask & FEAT_MONTH) {
+        monthLoop(pb, n, pDst[0], pDst[1], pDst[2], pDst[7], pDst[4],
+                    pDst[8], pDst[9], pDst[10], pDst[11]);
+      } else if (mask & FEAT_DATE) {
+        dateLoop(pb, n, pDst[0], pDst[1], pDst[2], pDst[7]);
+      }
+      if (mask & GRCAL_FEAT_WEEKDAY) {
+        weekdayLoop(pb, n, pDst[3]);
+      }
+    }
+  }
+}
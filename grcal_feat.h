@@ -0,0 +1,109 @@
+#ifndef GRCAL_FEAT_H_INCLUDED
+#define GRCAL_FEAT_H_INCLUDED
+
+/*
+ * grcal_feat.h
+ * ============
+ * 
+ * Calendar feature extraction for columns of day offsets.
+ * 
+ * Machine learning pipelines often derive a dozen fields from each
+ * date, such as the month, the weekday, the ISO week, and whether the
+ * date is the last day of its month.  Computing each of them with
+ * separate grcal_offsetToDate() and grcal_weekday() calls repeats the
+ * same decomposition many times over.  grcal_featExtract() instead
+ * decomposes each date once with the closed-form arithmetic of
+ * grcal_batch.h, derives the requested features from that without
+ * branches, and writes them straight to separate output arrays.
+ * 
+ * Features are selected with a bitmask of the GRCAL_FEAT constants, and
+ * only the work that the selected features need is done.  The weekday
+ * on its own needs no decomposition, and the month lengths and ISO week
+ * counts are only computed when a feature that depends on them is
+ * selected.
+ * All outputs are int32_t arrays, as in grcal_batch.h, and the flag
+ * features are zero or one.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Feature bits.
+ * 
+ * GRCAL_FEAT_WEEKDAY is one for Monday up to seven for Sunday, as in
+ * grcal_weekday().  GRCAL_FEAT_ISO_WEEK and GRCAL_FEAT_ISO_YEAR are the
+ * week number and week-numbering year of ISO 8601, where weeks start
+ * on Monday and week one is the week that holds the first Thursday of
+ * the year.  GRCAL_FEAT_DAYS_TO_MONTH_END is zero on the last day of a
+ * month.
+ */
+#define GRCAL_FEAT_YEAR              0x0001u
+#define GRCAL_FEAT_MONTH             0x0002u
+#define GRCAL_FEAT_DAY               0x0004u
+#define GRCAL_FEAT_WEEKDAY           0x0008u
+#define GRCAL_FEAT_DAY_OF_YEAR       0x0010u
+#define GRCAL_FEAT_ISO_WEEK          0x0020u
+#define GRCAL_FEAT_ISO_YEAR          0x0040u
+#define GRCAL_FEAT_QUARTER           0x0080u
+#define GRCAL_FEAT_IS_MONTH_END      0x0100u
+#define GRCAL_FEAT_IS_LEAP           0x0200u
+#define GRCAL_FEAT_DAYS_IN_MONTH     0x0400u
+#define GRCAL_FEAT_DAYS_TO_MONTH_END 0x0800u
+
+/*
+ * All feature bits.
+ */
+#define GRCAL_FEAT_ALL 0x0fffu
+
+/*
+ * Output arrays for the features, one per feature bit.
+ * 
+ * Only the arrays of selected features are used, and the others may be
+ * NULL.
+ */
+typedef struct {
+  int32_t *pYear;
+  int32_t *pMonth;
+  int32_t *pDay;
+  int32_t *pWeekday;
+  int32_t *pDayOfYear;
+  int32_t *pIsoWeek;
+  int32_t *pIsoYear;
+  int32_t *pQuarter;
+  int32_t *pIsMonthEnd;
+  int32_t *pIsLeap;
+  int32_t *pDaysInMonth;
+  int32_t *pDaysToMonthEnd;
+} GRCAL_FEAT_OUT;
+
+/*
+ * Extract calendar features from an array of day offsets.
+ * 
+ * Every day offset must be in range zero up to and including
+ * GRCAL_DAY_MAX, mask may only contain GRCAL_FEAT bits, and the output
+ * array of every selected feature must not be NULL.  Otherwise, a fault
+ * occurs before any output is written.
+ * 
+ * Each selected output array receives count values.  The output arrays
+ * must not overlap the input array or each other.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   mask - the selected features, as GRCAL_FEAT bits
+ * 
+ *   pOut - the output arrays
+ */
+void grcal_featExtract(
+    const int32_t        * pOffs,
+          size_t           count,
+          unsigned         mask,
+    const GRCAL_FEAT_OUT * pOut);
+
+#endif
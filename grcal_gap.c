@@ -0,0 +1,252 @@
+/*
+ * grcal_gap.c
+ * 
+ * Implementation of grcal_gap.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_gap.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of entries checked at a time by the adjacent-difference
+ * fast path.
+ */
+#define GAP_BLOCK 256
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * State of a scan.
+ */
+typedef struct {
+  
+  /*
+   * The business-day calendar, or NULL.
+   */
+  const GRCAL_BDAY *pCal;
+  
+  /*
+   * The output arrays and their capacities.
+   */
+  GRCAL_GAP *pGaps;
+  size_t gapCap;
+  size_t *pDups;
+  size_t dupCap;
+  
+  /*
+   * The statistics gathered so far.
+   */
+  GRCAL_GAP_STATS stats;
+  
+} GAP_SCAN;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void addGap(GAP_SCAN *ps, int32_t from, int32_t to);
+static void addDup(GAP_SCAN *ps, size_t i);
+
+/*
+ * Record a run of days that have no entry.
+ * 
+ * With a business-day calendar, the run is trimmed to the business
+ * days at each end, and nothing is recorded if it holds no business
+ * days at all.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scan state
+ * 
+ *   from - the day offset of the first day without an entry
+ * 
+ *   to - the day offset of the last day without an entry
+ */
+static void addGap(GAP_SCAN *ps, int32_t from, int32_t to) {
+  
+  GRCAL_GAP *pg = NULL;
+  int32_t days = 0;
+  
+  if (ps->pCal != NULL) {
+    days = grcal_bdayCount(ps->pCal, from, to);
+    if (days < 1) {
+      return;
+    }
+    from = grcal_bdayNext(ps->pCal, from);
+    to = grcal_bdayPrev(ps->pCal, to);
+  } else {
+    days = to - from + 1;
+  }
+  
+  if (ps->stats.gaps < ps->gapCap) {
+    pg = &((ps->pGaps)[ps->stats.gaps]);
+    pg->first = from;
+    pg->last = to;
+    pg->days = days;
+  }
+  (ps->stats.gaps)++;
+  ps->stats.missing += days;
+}
+
+/*
+ * Record a duplicate entry.
+ * 
+ * Parameters:
+ * 
+ *   ps - the scan state
+ * 
+ *   i - the index of the entry that equals the one before it
+ */
+static void addDup(GAP_SCAN *ps, size_t i) {
+  if (ps->stats.dups < ps->dupCap) {
+    (ps->pDups)[ps->stats.dups] = i;
+  }
+  (ps->stats.dups)++;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_gapScan function.
+ */
+int grcal_gapScan(
+    const int32_t         * pOffs,
+          size_t            count,
+          int32_t           first,
+          int32_t           last,
+    const GRCAL_BDAY      * pCal,
+          GRCAL_GAP       * pGaps,
+          size_t            gapCap,
+          size_t          * pDups,
+          size_t            dupCap,
+          GRCAL_GAP_STATS * pStats) {
+  
+  GAP_SCAN sc;
+  size_t i = 0;
+  size_t j = 0;
+  size_t n = 0;
+  int32_t prev = 0;
+  int32_t x = 0;
+  uint32_t acc = 0;
+  int32_t next = 0;
+  int status = 1;
+  
+  /* Check parameters */
+  if (((pOffs == NULL) && (count > 0)) ||
+      ((pGaps == NULL) && (gapCap > 0)) ||
+      ((pDups == NULL) && (dupCap > 0))) {
+    abort();
+  }
+  if ((first < 0) || (last > GRCAL_DAY_MAX) || (last < first)) {
+    abort();
+  }
+  
+  sc.pCal = pCal;
+  sc.pGaps = pGaps;
+  sc.gapCap = gapCap;
+  sc.pDups = pDups;
+  sc.dupCap = dupCap;
+  sc.stats.gaps = 0;
+  sc.stats.missing = 0;
+  sc.stats.dups = 0;
+  
+  /* prev is the latest day in the expected range that has an entry, or
+   * the day before the range if there is none yet */
+  prev = first - 1;
+  
+  for(i = 0; status && (i < count); i += n) {
+    n = count - i;
+    if (n > GAP_BLOCK) {
+      n = GAP_BLOCK;
+    }
+    
+    /* Fast path for a block that carries on from the latest entry one
+     * day at a time and stays within the expected range; the
+     * difference loop has no branches so that it vectorizes */
+    if ((pOffs[i] == prev + 1) && (pOffs[i + n - 1] <= last) &&
+        ((i == 0) || (pOffs[i - 1] < pOffs[i]))) {
+      acc = 0;
+      for(j = i + 1; j < i + n; j++) {
+        acc |= ((uint32_t) pOffs[j]) - ((uint32_t) pOffs[j - 1]) - 1u;
+      }
+      if (acc == 0) {
+        prev = pOffs[i + n - 1];
+        continue;
+      }
+    }
+    
+    /* Business-day fast path for a block that starts on the next
+     * business day after the latest entry.  If the entries are strictly
+     * ascending and all business days, and the span of the block holds
+     * no other business days, they are exactly the business days of the
+     * span.  The first check has no branches, and the span is counted
+     * a word of the bitmap at a time */
+    if ((pCal != NULL) && (prev < last)) {
+      next = grcal_bdayNext(pCal, prev + 1);
+      if ((next >= 0) && (pOffs[i] == next) &&
+          (pOffs[i + n - 1] <= last) &&
+          ((i == 0) || (pOffs[i - 1] < pOffs[i]))) {
+        acc = 0;
+        for(j = i + 1; j < i + n; j++) {
+          acc |= (uint32_t) (pOffs[j] <= pOffs[j - 1]);
+        }
+        if ((acc == 0) &&
+            (grcal_bdayCount(pCal, pOffs[i], pOffs[i + n - 1]) ==
+              (int32_t) n) &&
+            (grcal_bdayCountArray(pCal, pOffs + i, n) == n)) {
+          prev = pOffs[i + n - 1];
+          continue;
+        }
+      }
+    }
+    
+    /* Otherwise, go through the block one entry at a time */
+    for(j = i; j < i + n; j++) {
+      x = pOffs[j];
+      if (j > 0) {
+        if (x < pOffs[j - 1]) {
+          status = 0;
+          break;
+        }
+        if (x == pOffs[j - 1]) {
+          addDup(&sc, j);
+          continue;
+        }
+      }
+      if ((x < first) || (x > last)) {
+        continue;
+      }
+      if (x > prev + 1) {
+        addGap(&sc, prev + 1, x - 1);
+      }
+      prev = x;
+    }
+  }
+  
+  /* Days after the last entry are missing too */
+  if (status && (prev < last)) {
+    addGap(&sc, prev + 1, last);
+  }
+  
+  if (pStats != NULL) {
+    *pStats = sc.stats;
+  }
+  return status;
+}
@@ -0,0 +1,142 @@
+#ifndef GRCAL_GAP_H_INCLUDED
+#define GRCAL_GAP_H_INCLUDED
+
+/*
+ * grcal_gap.h
+ * ===========
+ * 
+ * Gap and duplicate detection on sorted columns of day offsets.
+ * 
+ * Daily series are expected to hold exactly one entry per calendar day
+ * or per business day over some range.  grcal_gapScan() checks a
+ * sorted column against that expectation in a single pass, reporting
+ * each run of missing days and each duplicated entry, without
+ * generating the expected series.
+ * 
+ * The scan works on blocks of entries.  A block whose entries all
+ * follow each other one day apart is recognized with a branch-free
+ * adjacent-difference loop that the compiler can vectorize, so that
+ * long complete stretches of a series are skipped quickly.  With a
+ * business-day calendar, a block is also recognized when its entries
+ * are exactly the business days of its span, which is checked by
+ * counting the business days of the span in the bitmap a word at a
+ * time and looking up the bit of every entry without branches.  Only
+ * the blocks that contain a gap or a duplicate are examined entry by
+ * entry.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_bday.h"
+#include <stddef.h>
+
+/*
+ * A run of missing days.
+ */
+typedef struct {
+  
+  /*
+   * The day offsets of the first and last missing days of the run,
+   * inclusive.
+   * 
+   * When checking against a business-day calendar, both are business
+   * days, though the run may have non-business days inside it.
+   */
+  int32_t first;
+  int32_t last;
+  
+  /*
+   * The number of missing days in the run.  When checking against a
+   * business-day calendar, only business days are counted.
+   */
+  int32_t days;
+  
+} GRCAL_GAP;
+
+/*
+ * Summary of a gap scan.
+ */
+typedef struct {
+  
+  /*
+   * The total number of gaps found, which may be more than the number
+   * of gaps stored.
+   */
+  size_t gaps;
+  
+  /*
+   * The total number of missing days over all gaps.
+   */
+  int64_t missing;
+  
+  /*
+   * The total number of duplicate entries found, which may be more than
+   * the number of duplicate indices stored.
+   */
+  size_t dups;
+  
+} GRCAL_GAP_STATS;
+
+/*
+ * Find the gaps and duplicates in a sorted column of day offsets.
+ * 
+ * The expected series covers every day from first to last inclusive,
+ * or every business day in that range if a calendar is given.  Entries
+ * outside that range do not fill any gaps but are still checked for
+ * duplicates.  If a calendar is given, entries on non-business days are
+ * tolerated and do not fill any gaps either.
+ * 
+ * Gaps are stored in ascending order in pGaps, up to gapCap of them.
+ * The index of every entry that is equal to the entry before it is
+ * stored in ascending order in pDups, up to dupCap of them.  Either
+ * array may be NULL if its capacity is zero.  The statistics count
+ * everything found, so a caller can tell whether the arrays were large
+ * enough.
+ * 
+ * The column must be sorted in ascending order.  If an entry is found
+ * to be less than the entry before it, the scan stops and zero is
+ * returned.  The outputs then describe the part of the column before
+ * that entry.
+ * 
+ * first and last must be valid day offsets, and last may not be less
+ * than first, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the sorted day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   first - the day offset of the first expected day
+ * 
+ *   last - the day offset of the last expected day
+ * 
+ *   pCal - the business-day calendar, or NULL to expect every day
+ * 
+ *   pGaps - the array to receive the gaps, or NULL
+ * 
+ *   gapCap - the number of gaps that pGaps can hold
+ * 
+ *   pDups - the array to receive the duplicate indices, or NULL
+ * 
+ *   dupCap - the number of indices that pDups can hold
+ * 
+ *   pStats - the structure to receive the statistics, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if the whole column was scanned, zero if it is not sorted
+ */
+int grcal_gapScan(
+    const int32_t         * pOffs,
+          size_t            count,
+          int32_t           first,
+          int32_t           last,
+    const GRCAL_BDAY      * pCal,
+          GRCAL_GAP       * pGaps,
+          size_t            gapCap,
+          size_t          * pDups,
+          size_t            dupCap,
+          GRCAL_GAP_STATS * pStats);
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * grcal_id.c
+ * 
+ * Implementation of grcal_id.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_id.h"
+#include "grcal_batch.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of milliseconds in a day.
+ */
+#define DAY_MS INT64_C(86400000)
+
+/*
+ * The range of milliseconds since the Unix epoch that fall within the
+ * range of day offsets, from LO_MS up to but excluding HI_MS.
+ */
+#define LO_MS (-(((int64_t) GRCAL_DAY_UNIX) * DAY_MS))
+#define HI_MS \
+    ((((int64_t) GRCAL_DAY_MAX) + 1 - GRCAL_DAY_UNIX) * DAY_MS)
+
+/*
+ * Snowflake epochs must be at most this far from the Unix epoch, which
+ * keeps the range arithmetic from overflowing.
+ */
+#define EPOCH_MAX (INT64_C(1) << 62)
+
+/*
+ * The number of identifiers converted at a time to dates.
+ */
+#define ID_BLOCK 256
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static size_t uuidRun(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pOffs,
+          int32_t       * pMs);
+static size_t snowRun(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pOffs,
+          int32_t  * pMs);
+static void toDates(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pYear,
+          int32_t * pMonth,
+          int32_t * pDayOfMonth);
+
+/*
+ * Get the day offsets of UUIDv7 or ULID identifiers.
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pMs - the array to receive the milliseconds since midnight, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+static size_t uuidRun(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pOffs,
+          int32_t       * pMs) {
+  
+  const unsigned char *pc = NULL;
+  size_t i = 0;
+  size_t bad = 0;
+  uint64_t t = 0;
+  uint64_t z = 0;
+  int valid = 0;
+  
+  for(i = 0; i < count; i++) {
+    pc = pIds + (i * GRCAL_ID_UUID_SIZE);
+    t = (((uint64_t) pc[0]) << 40) | (((uint64_t) pc[1]) << 32) |
+        (((uint64_t) pc[2]) << 24) | (((uint64_t) pc[3]) << 16) |
+        (((uint64_t) pc[4]) << 8) | ((uint64_t) pc[5]);
+    
+    /* Milliseconds since day offset zero, or zero if out of range */
+    valid = (t < (uint64_t) HI_MS);
+    z = valid ? (t - (uint64_t) LO_MS) : 0;
+    
+    pOffs[i] = valid ? (int32_t) (z / (uint64_t) DAY_MS) : -1;
+    if (pMs != NULL) {
+      pMs[i] = (int32_t) (z % (uint64_t) DAY_MS);
+    }
+    bad += !valid;
+  }
+  
+  return bad;
+}
+
+/*
+ * Get the day offsets of Snowflake identifiers.
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   epoch - the Snowflake epoch, at most EPOCH_MAX in magnitude
+ * 
+ *   shift - the number of bits below the timestamp, 0 to 63
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pMs - the array to receive the milliseconds since midnight, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+static size_t snowRun(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pOffs,
+          int32_t  * pMs) {
+  
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t lo = 0;
+  int64_t hi = 0;
+  uint64_t t = 0;
+  uint64_t z = 0;
+  int valid = 0;
+  
+  /* The range of timestamps, relative to the Snowflake epoch, that
+   * fall within the range of day offsets */
+  lo = LO_MS - epoch;
+  hi = HI_MS - epoch;
+  
+  for(i = 0; i < count; i++) {
+    t = pIds[i] >> shift;
+    valid = (hi > 0) & (t < (uint64_t) hi) &
+              ((lo <= 0) | (t >= (uint64_t) lo));
+    
+    /* Milliseconds since day offset zero, or zero if out of range */
+    z = valid ? (t - (uint64_t) lo) : 0;
+    
+    pOffs[i] = valid ? (int32_t) (z / (uint64_t) DAY_MS) : -1;
+    if (pMs != NULL) {
+      pMs[i] = (int32_t) (z % (uint64_t) DAY_MS);
+    }
+    bad += !valid;
+  }
+  
+  return bad;
+}
+
+/*
+ * Convert a block of day offsets to dates, giving zeros for offsets
+ * that are -1.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets, at most ID_BLOCK of them
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pYear - the array to receive the years, or NULL
+ * 
+ *   pMonth - the array to receive the months, or NULL
+ * 
+ *   pDayOfMonth - the array to receive the days of the month, or NULL
+ */
+static void toDates(
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pYear,
+          int32_t * pMonth,
+          int32_t * pDayOfMonth) {
+  
+  int32_t offs[ID_BLOCK];
+  size_t i = 0;
+  
+  /* grcal_offsetToDateBatch() faults on -1, so convert day zero in its
+   * place and clear the result afterwards */
+  for(i = 0; i < count; i++) {
+    offs[i] = (pOffs[i] < 0) ? 0 : pOffs[i];
+  }
+  grcal_offsetToDateBatch(offs, count, pYear, pMonth, pDayOfMonth);
+  
+  for(i = 0; i < count; i++) {
+    if (pOffs[i] < 0) {
+      if (pYear != NULL) {
+        pYear[i] = 0;
+      }
+      if (pMonth != NULL) {
+        pMonth[i] = 0;
+      }
+      if (pDayOfMonth != NULL) {
+        pDayOfMonth[i] = 0;
+      }
+    }
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_idUuid7ToOffsetBatch function.
+ */
+size_t grcal_idUuid7ToOffsetBatch(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pOffs,
+          int32_t       * pMs) {
+  
+  if ((count > 0) && ((pIds == NULL) || (pOffs == NULL))) {
+    abort();
+  }
+  
+  return uuidRun(pIds, count, pOffs, pMs);
+}
+
+/*
+ * grcal_idUuid7ToDateBatch function.
+ */
+size_t grcal_idUuid7ToDateBatch(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pYear,
+          int32_t       * pMonth,
+          int32_t       * pDayOfMonth) {
+  
+  int32_t offs[ID_BLOCK];
+  size_t i = 0;
+  size_t n = 0;
+  size_t bad = 0;
+  
+  if ((count > 0) && (pIds == NULL)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i += n) {
+    n = count - i;
+    if (n > ID_BLOCK) {
+      n = ID_BLOCK;
+    }
+    bad += uuidRun(pIds + (i * GRCAL_ID_UUID_SIZE), n, offs, NULL);
+    toDates(offs, n,
+              (pYear == NULL) ? NULL : (pYear + i),
+              (pMonth == NULL) ? NULL : (pMonth + i),
+              (pDayOfMonth == NULL) ? NULL : (pDayOfMonth + i));
+  }
+  
+  return bad;
+}
+
+/*
+ * grcal_idSnowflakeToOffsetBatch function.
+ */
+size_t grcal_idSnowflakeToOffsetBatch(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pOffs,
+          int32_t  * pMs) {
+  
+  if ((count > 0) && ((pIds == NULL) || (pOffs == NULL))) {
+    abort();
+  }
+  if ((shift < 0) || (shift > 63) ||
+      (epoch > EPOCH_MAX) || (epoch < -EPOCH_MAX)) {
+    abort();
+  }
+  
+  return snowRun(pIds, count, epoch, shift, pOffs, pMs);
+}
+
+/*
+ * grcal_idSnowflakeToDateBatch function.
+ */
+size_t grcal_idSnowflakeToDateBatch(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pYear,
+          int32_t  * pMonth,
+          int32_t  * pDayOfMonth) {
+  
+  int32_t offs[ID_BLOCK];
+  size_t i = 0;
+  size_t n = 0;
+  size_t bad = 0;
+  
+  if ((count > 0) && (pIds == NULL)) {
+    abort();
+  }
+  if ((shift < 0) || (shift > 63) ||
+      (epoch > EPOCH_MAX) || (epoch < -EPOCH_MAX)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i += n) {
+    n = count - i;
+    if (n > ID_BLOCK) {
+      n = ID_BLOCK;
+    }
+    bad += snowRun(pIds + i, n, epoch, shift, offs, NULL);
+    toDates(offs, n,
+              (pYear == NULL) ? NULL : (pYear + i),
+              (pMonth == NULL) ? NULL : (pMonth + i),
+              (pDayOfMonth == NULL) ? NULL : (pDayOfMonth + i));
+  }
+  
+  return bad;
+}
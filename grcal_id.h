@@ -0,0 +1,186 @@
+#ifndef GRCAL_ID_H_INCLUDED
+#define GRCAL_ID_H_INCLUDED
+
+/*
+ * grcal_id.h
+ * ==========
+ * 
+ * Extraction of creation dates from time-ordered identifiers.
+ * 
+ * UUID version 7 and ULID identifiers are 128 bits long and begin with
+ * a 48-bit big-endian count of milliseconds since the Unix epoch.  Both
+ * are handled by the Uuid7 functions below, which take the binary form
+ * of the identifiers as 16 bytes each, in network byte order.  The
+ * version and variant bits of a UUID are not checked.
+ * 
+ * Snowflake identifiers are 64 bits long, with a count of milliseconds
+ * since a custom epoch in the bits above a fixed number of sequence and
+ * worker bits.  The epoch and the number of low bits are parameters,
+ * and the values used by Twitter and Discord are given below.
+ * 
+ * Each function decodes the embedded time and converts it to the UTC
+ * date in the same loop, so there is no intermediate array of
+ * timestamps.  The conversion to a day offset is a division by a
+ * constant with no branches, which the compiler can vectorize.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * The size in bytes of a UUID or ULID in binary form.
+ */
+#define GRCAL_ID_UUID_SIZE 16
+
+/*
+ * The number of low bits below the timestamp in Twitter and Discord
+ * Snowflake identifiers.
+ */
+#define GRCAL_ID_SNOWFLAKE_SHIFT 22
+
+/*
+ * The Snowflake epochs used by Twitter and Discord, in milliseconds
+ * since the Unix epoch.
+ */
+#define GRCAL_ID_TWITTER_EPOCH INT64_C(1288834974657)
+#define GRCAL_ID_DISCORD_EPOCH INT64_C(1420070400000)
+
+/*
+ * Get the creation day offsets of an array of UUIDv7 or ULID
+ * identifiers.
+ * 
+ * pIds holds count identifiers of GRCAL_ID_UUID_SIZE bytes each.  If
+ * pMs is not NULL, it receives the milliseconds since UTC midnight of
+ * each creation time.
+ * 
+ * Identifiers whose time is after the range of grcal day offsets get a
+ * day offset of -1 and zero milliseconds.
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pMs - the array to receive the milliseconds since midnight, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+size_t grcal_idUuid7ToOffsetBatch(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pOffs,
+          int32_t       * pMs);
+
+/*
+ * Get the creation dates of an array of UUIDv7 or ULID identifiers as
+ * years, months, and days of month.
+ * 
+ * Any of the output arrays may be NULL if not required.  Identifiers
+ * that are out of range get zero in all of them.
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   pYear - the array to receive the years, or NULL
+ * 
+ *   pMonth - the array to receive the months, or NULL
+ * 
+ *   pDayOfMonth - the array to receive the days of the month, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+size_t grcal_idUuid7ToDateBatch(
+    const unsigned char * pIds,
+          size_t          count,
+          int32_t       * pYear,
+          int32_t       * pMonth,
+          int32_t       * pDayOfMonth);
+
+/*
+ * Get the creation day offsets of an array of Snowflake identifiers.
+ * 
+ * The identifiers are taken as unsigned 64-bit values.  The timestamp
+ * is the identifier shifted right by shift bits, in milliseconds since
+ * epoch, which is itself in milliseconds since the Unix epoch.  shift
+ * must be in range 0 to 63, and epoch must be at most 2^62 in
+ * magnitude, or a fault occurs.
+ * 
+ * If pMs is not NULL, it receives the milliseconds since UTC midnight.
+ * Identifiers whose time is outside the range of grcal day offsets get
+ * a day offset of -1 and zero milliseconds.
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   epoch - the Snowflake epoch
+ * 
+ *   shift - the number of bits below the timestamp
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ *   pMs - the array to receive the milliseconds since midnight, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+size_t grcal_idSnowflakeToOffsetBatch(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pOffs,
+          int32_t  * pMs);
+
+/*
+ * Get the creation dates of an array of Snowflake identifiers as
+ * years, months, and days of month.
+ * 
+ * The parameters are as for grcal_idSnowflakeToOffsetBatch(), and the
+ * date outputs are as for grcal_idUuid7ToDateBatch().
+ * 
+ * Parameters:
+ * 
+ *   pIds - the identifiers
+ * 
+ *   count - the number of identifiers
+ * 
+ *   epoch - the Snowflake epoch
+ * 
+ *   shift - the number of bits below the timestamp
+ * 
+ *   pYear - the array to receive the years, or NULL
+ * 
+ *   pMonth - the array to receive the months, or NULL
+ * 
+ *   pDayOfMonth - the array to receive the days of the month, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of identifiers that were out of range
+ */
+size_t grcal_idSnowflakeToDateBatch(
+    const uint64_t * pIds,
+          size_t     count,
+          int64_t    epoch,
+          int        shift,
+          int32_t  * pYear,
+          int32_t  * pMonth,
+          int32_t  * pDayOfMonth);
+
+#endif
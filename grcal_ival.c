@@ -0,0 +1,334 @@
+/*
+ * grcal_ival.c
+ * 
+ * Implementation of grcal_ival.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_ival.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of bits of the start sorted by each radix pass, and the
+ * number of buckets of each pass.
+ * 
+ * Two passes cover the 22 bits of a day offset.
+ */
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void checkList(const GRCAL_IVAL *pList, size_t count, int norm);
+static void radixPass(
+    const GRCAL_IVAL * pSrc,
+          size_t       count,
+          int          shift,
+          size_t     * pHist,
+          GRCAL_IVAL * pDst);
+
+/*
+ * Fault unless every interval of a list is valid.
+ * 
+ * Parameters:
+ * 
+ *   pList - the intervals
+ * 
+ *   count - the number of intervals
+ * 
+ *   norm - non-zero to also require the list to be normalized
+ */
+static void checkList(const GRCAL_IVAL *pList, size_t count, int norm) {
+  
+  size_t i = 0;
+  int bad = 0;
+  
+  if ((pList == NULL) && (count > 0)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    bad |= (pList[i].start < 0) | (pList[i].start > GRCAL_DAY_MAX) |
+            (pList[i].end < pList[i].start) |
+            (pList[i].end > GRCAL_DAY_MAX + 1);
+  }
+  if (norm) {
+    for(i = 0; i < count; i++) {
+      bad |= (pList[i].end == pList[i].start);
+      if (i > 0) {
+        bad |= (pList[i].start <= pList[i - 1].end);
+      }
+    }
+  }
+  
+  if (bad) {
+    abort();
+  }
+}
+
+/*
+ * Scatter a list of intervals into buckets by one digit of their
+ * start.
+ * 
+ * Parameters:
+ * 
+ *   pSrc - the intervals
+ * 
+ *   count - the number of intervals
+ * 
+ *   shift - the position of the digit
+ * 
+ *   pHist - the number of intervals with each digit, which is turned
+ *   into the bucket positions
+ * 
+ *   pDst - the array to receive the intervals
+ */
+static void radixPass(
+    const GRCAL_IVAL * pSrc,
+          size_t       count,
+          int          shift,
+          size_t     * pHist,
+          GRCAL_IVAL * pDst) {
+  
+  size_t sum = 0;
+  size_t n = 0;
+  size_t i = 0;
+  int k = 0;
+  
+  for(k = 0; k < RADIX_SIZE; k++) {
+    n = pHist[k];
+    pHist[k] = sum;
+    sum += n;
+  }
+  
+  for(i = 0; i < count; i++) {
+    k = (int) ((pSrc[i].start >> shift) & RADIX_MASK);
+    pDst[pHist[k]] = pSrc[i];
+    (pHist[k])++;
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_ivalSort function.
+ */
+void grcal_ivalSort(GRCAL_IVAL *pList, size_t count, GRCAL_IVAL *pTmp) {
+  
+  size_t lowHist[RADIX_SIZE];
+  size_t highHist[RADIX_SIZE];
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkList(pList, count, 0);
+  if ((pTmp == NULL) && (count > 0)) {
+    abort();
+  }
+  
+  if (count < 2) {
+    return;
+  }
+  
+  /* Count both digits in one pass */
+  memset(lowHist, 0, sizeof(lowHist));
+  memset(highHist, 0, sizeof(highHist));
+  for(i = 0; i < count; i++) {
+    (lowHist[pList[i].start & RADIX_MASK])++;
+    (highHist[(pList[i].start >> RADIX_BITS) & RADIX_MASK])++;
+  }
+  
+  /* Each pass is stable, so sorting by the low digit and then by the
+   * high digit sorts by the whole start */
+  radixPass(pList, count, 0, lowHist, pTmp);
+  radixPass(pTmp, count, RADIX_BITS, highHist, pList);
+}
+
+/*
+ * grcal_ivalMerge function.
+ */
+size_t grcal_ivalMerge(GRCAL_IVAL *pList, size_t count) {
+  
+  size_t out = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkList(pList, count, 0);
+  for(i = 1; i < count; i++) {
+    if (pList[i].start < pList[i - 1].start) {
+      abort();
+    }
+  }
+  
+  for(i = 0; i < count; i++) {
+    if (pList[i].end == pList[i].start) {
+      continue;
+    }
+    
+    /* Extend the last output interval if this one overlaps or touches
+     * it; sorting guarantees that it does not start before it */
+    if ((out > 0) && (pList[i].start <= pList[out - 1].end)) {
+      if (pList[i].end > pList[out - 1].end) {
+        pList[out - 1].end = pList[i].end;
+      }
+    } else {
+      pList[out] = pList[i];
+      out++;
+    }
+  }
+  
+  return out;
+}
+
+/*
+ * grcal_ivalComplement function.
+ */
+size_t grcal_ivalComplement(
+    const GRCAL_IVAL * pList,
+          size_t       count,
+          int32_t      first,
+          int32_t      end,
+          GRCAL_IVAL * pOut) {
+  
+  int32_t pos = 0;
+  size_t out = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkList(pList, count, 1);
+  if ((first < 0) || (first > GRCAL_DAY_MAX) ||
+      (end < first) || (end > GRCAL_DAY_MAX + 1) || (pOut == NULL)) {
+    abort();
+  }
+  
+  /* pos is the first day of the window not yet covered */
+  pos = first;
+  for(i = 0; (i < count) && (pos < end); i++) {
+    if (pList[i].end <= pos) {
+      continue;
+    }
+    if (pList[i].start > pos) {
+      pOut[out].start = pos;
+      pOut[out].end = (pList[i].start < end) ? pList[i].start : end;
+      out++;
+    }
+    pos = pList[i].end;
+  }
+  
+  if (pos < end) {
+    pOut[out].start = pos;
+    pOut[out].end = end;
+    out++;
+  }
+  
+  return out;
+}
+
+/*
+ * grcal_ivalIntersect function.
+ */
+size_t grcal_ivalIntersect(
+    const GRCAL_IVAL * pA,
+          size_t       countA,
+    const GRCAL_IVAL * pB,
+          size_t       countB,
+          GRCAL_IVAL * pOut) {
+  
+  int32_t lo = 0;
+  int32_t hi = 0;
+  size_t out = 0;
+  size_t i = 0;
+  size_t j = 0;
+  
+  /* Check parameters */
+  checkList(pA, countA, 1);
+  checkList(pB, countB, 1);
+  if ((pOut == NULL) && (countA > 0) && (countB > 0)) {
+    abort();
+  }
+  
+  /* Advance past whichever interval ends first, since it cannot
+   * intersect anything further along the other list */
+  while ((i < countA) && (j < countB)) {
+    lo = (pA[i].start > pB[j].start) ? pA[i].start : pB[j].start;
+    hi = (pA[i].end < pB[j].end) ? pA[i].end : pB[j].end;
+    if (lo < hi) {
+      pOut[out].start = lo;
+      pOut[out].end = hi;
+      out++;
+    }
+    if (pA[i].end < pB[j].end) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+  
+  return out;
+}
+
+/*
+ * grcal_ivalClipBusiness function.
+ */
+size_t grcal_ivalClipBusiness(
+    const GRCAL_IVAL * pList,
+          size_t       count,
+    const GRCAL_BDAY * pCal,
+          GRCAL_IVAL * pOut,
+          size_t       outCap) {
+  
+  int32_t x = 0;
+  int32_t y = 0;
+  size_t out = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkList(pList, count, 0);
+  if ((pCal == NULL) || ((pOut == NULL) && (outCap > 0))) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    x = pList[i].start;
+    while (x < pList[i].end) {
+      
+      /* Skip to the start of the next run of business days */
+      x = grcal_bdayNext(pCal, x);
+      if ((x < 0) || (x >= pList[i].end)) {
+        break;
+      }
+      
+      /* Find the end of the run */
+      for(y = x + 1; y < pList[i].end; y++) {
+        if (!grcal_bdayIs(pCal, y)) {
+          break;
+        }
+      }
+      
+      if (out < outCap) {
+        pOut[out].start = x;
+        pOut[out].end = y;
+      }
+      out++;
+      x = y;
+    }
+  }
+  
+  return out;
+}
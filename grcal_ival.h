@@ -0,0 +1,182 @@
+#ifndef GRCAL_IVAL_H_INCLUDED
+#define GRCAL_IVAL_H_INCLUDED
+
+/*
+ * grcal_ival.h
+ * ============
+ * 
+ * Interval lists of day offsets, for availability, coverage, and
+ * blackout windows.
+ * 
+ * An interval is a half-open range [start, end) of day offsets, so it
+ * holds the days from start up to but not including end.  start is in
+ * range zero up to and including GRCAL_DAY_MAX, and end is in range
+ * start up to and including GRCAL_DAY_MAX plus one.  An interval where
+ * start equals end is empty.
+ * 
+ * A list of intervals is normalized if it has no empty intervals, is
+ * sorted by start, and each interval starts after the end of the one
+ * before it, so that intervals neither overlap nor touch.  Raw lists
+ * are normalized by sorting them with grcal_ivalSort() and then
+ * coalescing them with grcal_ivalMerge().  The set operations take and
+ * produce normalized lists in a single linear pass.
+ * 
+ * Sorting is a stable radix sort on the start of each interval.  Day
+ * offsets fit in 22 bits, so the sort takes two passes over the list
+ * with 11 bits each, however long the list is.
+ * 
+ * The functions never allocate memory.  Outputs are arrays of interval
+ * structures supplied by the caller, and the sizes they need are given
+ * below.  The start or end fields of such an array can be passed
+ * straight to the record functions of grcal_batch.h, or to
+ * grcal_pipeRun() with a stride of sizeof(GRCAL_IVAL), to format them
+ * without copying them out first.
+ * 
+ * A fault occurs if any function is given an interval that is not
+ * valid, or a list that should be normalized but is not.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_bday.h"
+#include <stddef.h>
+
+/*
+ * A half-open interval of day offsets.
+ */
+typedef struct {
+  int32_t start;
+  int32_t end;
+} GRCAL_IVAL;
+
+/*
+ * Sort a list of intervals by start.
+ * 
+ * Intervals with the same start keep their order.  The scratch array
+ * must have room for count intervals and must not overlap the list.
+ * 
+ * Parameters:
+ * 
+ *   pList - the intervals to sort
+ * 
+ *   count - the number of intervals
+ * 
+ *   pTmp - the scratch array
+ */
+void grcal_ivalSort(GRCAL_IVAL *pList, size_t count, GRCAL_IVAL *pTmp);
+
+/*
+ * Normalize a list of intervals that is sorted by start, in place.
+ * 
+ * Empty intervals are removed, and intervals that overlap or touch are
+ * coalesced into one.  A fault occurs if the list is not sorted by
+ * start.
+ * 
+ * Parameters:
+ * 
+ *   pList - the intervals
+ * 
+ *   count - the number of intervals
+ * 
+ * Return:
+ * 
+ *   the number of intervals in the normalized list
+ */
+size_t grcal_ivalMerge(GRCAL_IVAL *pList, size_t count);
+
+/*
+ * Get the complement of a normalized list within a window.
+ * 
+ * The output is the normalized list of the days in [first, end) that
+ * are not in any interval of the input.  It needs room for count plus
+ * one intervals, and it must not overlap the input.
+ * 
+ * Parameters:
+ * 
+ *   pList - the normalized intervals
+ * 
+ *   count - the number of intervals
+ * 
+ *   first - the start of the window
+ * 
+ *   end - the end of the window, which is not part of it
+ * 
+ *   pOut - the array to receive the complement
+ * 
+ * Return:
+ * 
+ *   the number of intervals in the complement
+ */
+size_t grcal_ivalComplement(
+    const GRCAL_IVAL * pList,
+          size_t       count,
+          int32_t      first,
+          int32_t      end,
+          GRCAL_IVAL * pOut);
+
+/*
+ * Get the intersection of two normalized lists.
+ * 
+ * The output is the normalized list of the days that are in both
+ * lists.  It needs room for countA plus countB intervals, and it must
+ * not overlap either input.
+ * 
+ * Parameters:
+ * 
+ *   pA - the first normalized list
+ * 
+ *   countA - the number of intervals in the first list
+ * 
+ *   pB - the second normalized list
+ * 
+ *   countB - the number of intervals in the second list
+ * 
+ *   pOut - the array to receive the intersection
+ * 
+ * Return:
+ * 
+ *   the number of intervals in the intersection
+ */
+size_t grcal_ivalIntersect(
+    const GRCAL_IVAL * pA,
+          size_t       countA,
+    const GRCAL_IVAL * pB,
+          size_t       countB,
+          GRCAL_IVAL * pOut);
+
+/*
+ * Clip a list of intervals to business days.
+ * 
+ * Each interval is split into the runs of consecutive business days
+ * within it, in order.  The input need not be normalized, but if it is,
+ * so is the output.
+ * 
+ * Up to outCap intervals are written to pOut, which may be NULL if
+ * outCap is zero and must not overlap the input.  The total number of
+ * intervals is returned even if it is greater than outCap, so a caller
+ * can size the array with a first call.
+ * 
+ * Parameters:
+ * 
+ *   pList - the intervals
+ * 
+ *   count - the number of intervals
+ * 
+ *   pCal - the business-day calendar
+ * 
+ *   pOut - the array to receive the business-day intervals, or NULL
+ * 
+ *   outCap - the number of intervals that pOut has room for
+ * 
+ * Return:
+ * 
+ *   the total number of business-day intervals
+ */
+size_t grcal_ivalClipBusiness(
+    const GRCAL_IVAL * pList,
+          size_t       count,
+    const GRCAL_BDAY * pCal,
+          GRCAL_IVAL * pOut,
+          size_t       outCap);
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * grcal_memo.c
+ * 
+ * Implementation of grcal_memo.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_memo.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The range of years in the table.
+ * 
+ * The table starts in October 1582, the month of day offset zero, so
+ * the first year only has three entries.
+ */
+#define FIRST_YEAR  1582
+#define FIRST_MONTH 10
+#define LAST_YEAR   9999
+
+/*
+ * The month index, twelve times the year plus the zero-based month, of
+ * the first entry in the table.
+ */
+#define FIRST_INDEX ((FIRST_YEAR * 12) + (FIRST_MONTH - 1))
+
+/*
+ * The number of entries in the table.
+ */
+#define TABLE_SIZE (((LAST_YEAR * 12) + 11) - FIRST_INDEX + 1)
+
+/*
+ * The layout of a table entry.
+ * 
+ * The low 24 bits hold the first day offset plus FIRST_BIAS, which
+ * keeps the negative first day offset of October 1582 positive.  The
+ * next eight bits hold the number of days, the next eight bits hold the
+ * weekday, and the top bit is set in every entry that has been filled
+ * in, so that an empty entry is zero.
+ */
+#define FIRST_BIAS  INT32_C(32)
+#define FIRST_MASK  UINT64_C(0xffffff)
+#define DAYS_SHIFT  24
+#define WD_SHIFT    32
+#define BYTE_MASK   UINT64_C(0xff)
+#define ENTRY_VALID (UINT64_C(1) << 63)
+
+/*
+ * Atomic access to table entries, which needs the atomic builtins of
+ * GCC and Clang.
+ * 
+ * Each entry carries all of its data in one word, so no other memory
+ * needs to be ordered with it, and relaxed loads and stores suffice.
+ * 
+ * Without the builtins, every load finds an empty entry and stores do
+ * nothing, so the table is never touched.  Define MEMO_NO_ATOMIC to
+ * force this.
+ */
+#if defined(__GNUC__) && !defined(MEMO_NO_ATOMIC)
+#define ENTRY_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define ENTRY_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+#define ENTRY_LOAD(p) ((void) (p), UINT64_C(0))
+#define ENTRY_STORE(p, v) ((void) (p), (void) (v))
+#endif
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The table of month descriptors, indexed by the month index less
+ * FIRST_INDEX.
+ */
+static uint64_t m_table[TABLE_SIZE];
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void computeYear(int32_t y, uint64_t *pEntries);
+static void unpack(uint64_t entry, GRCAL_MONTH_INFO *pInfo);
+
+/*
+ * Compute the table entries of every month of a year.
+ * 
+ * The entries of the months of FIRST_YEAR before FIRST_MONTH are
+ * computed but do not fit in a table entry, so they must not be
+ * stored.
+ * 
+ * Parameters:
+ * 
+ *   y - the year, in range FIRST_YEAR up to LAST_YEAR
+ * 
+ *   pEntries - the array to receive the twelve entries
+ */
+static void computeYear(int32_t y, uint64_t *pEntries) {
+  
+  int32_t first = 0;
+  int32_t days = 0;
+  int32_t wd = 0;
+  int m = 0;
+  
+  /* January belongs to the March-based year that starts in the year
+   * before, as its eleventh month */
+  first = grcal_privMarchFirst((y - 1) - GRCAL_PRIV_BASE_YEAR, 10);
+  
+  for(m = 1; m <= 12; m++) {
+    days = grcal_privMonthDays(y, m);
+    
+    /* Day offset zero is a Friday, and first may be negative */
+    wd = ((((first % 7) + 7) + 4) % 7) + 1;
+    
+    pEntries[m - 1] = ENTRY_VALID |
+      ((uint64_t) (first + FIRST_BIAS)) |
+      (((uint64_t) days) << DAYS_SHIFT) |
+      (((uint64_t) wd) << WD_SHIFT);
+    
+    first += days;
+  }
+}
+
+/*
+ * Unpack a table entry into a month descriptor.
+ * 
+ * Parameters:
+ * 
+ *   entry - the table entry, which is filled in
+ * 
+ *   pInfo - the structure to receive the descriptor
+ */
+static void unpack(uint64_t entry, GRCAL_MONTH_INFO *pInfo) {
+  pInfo->first = ((int32_t) (entry & FIRST_MASK)) - FIRST_BIAS;
+  pInfo->days = (int32_t) ((entry >> DAYS_SHIFT) & BYTE_MASK);
+  pInfo->weekday = (int32_t) ((entry >> WD_SHIFT) & BYTE_MASK);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_memoMonth function.
+ */
+int grcal_memoMonth(int32_t y, int32_t m, GRCAL_MONTH_INFO *pInfo) {
+  
+  uint64_t entries[12];
+  uint64_t entry = 0;
+  int32_t base = 0;
+  int first = 0;
+  int i = 0;
+  
+  /* Check parameters */
+  if (pInfo == NULL) {
+    abort();
+  }
+  
+  if ((y < FIRST_YEAR) || (y > LAST_YEAR) || (m < 1) || (m > 12)) {
+    return 0;
+  }
+  if ((y == FIRST_YEAR) && (m < FIRST_MONTH)) {
+    return 0;
+  }
+  
+  /* base is the table index of January of the year, which is negative
+   * for FIRST_YEAR */
+  base = (y * 12) - FIRST_INDEX;
+  entry = ENTRY_LOAD(&(m_table[base + (m - 1)]));
+  
+  /* On the first touch of the year, fill in all of its months that
+   * are in the table */
+  if (entry == 0) {
+    computeYear(y, entries);
+    first = (y == FIRST_YEAR) ? (FIRST_MONTH - 1) : 0;
+    for(i = first; i < 12; i++) {
+      ENTRY_STORE(&(m_table[base + i]), entries[i]);
+    }
+    entry = entries[m - 1];
+  }
+  
+  unpack(entry, pInfo);
+  return 1;
+}
+
+/*
+ * grcal_memoMonthOf function.
+ */
+void grcal_memoMonthOf(int32_t offs, GRCAL_MONTH_INFO *pInfo) {
+  
+  int32_t y = 0;
+  int32_t m = 0;
+  int32_t d = 0;
+  int32_t doy = 0;
+  
+  /* Check parameters */
+  if ((offs < 0) || (offs > GRCAL_DAY_MAX) || (pInfo == NULL)) {
+    abort();
+  }
+  
+  grcal_privSplit(offs, &y, &m, &d, &doy);
+  grcal_memoMonth(y, m, pInfo);
+}
@@ -0,0 +1,94 @@
+#ifndef GRCAL_MEMO_H_INCLUDED
+#define GRCAL_MEMO_H_INCLUDED
+
+/*
+ * grcal_memo.h
+ * ============
+ * 
+ * Shared memo of month descriptors, for code that often needs the first
+ * day offset, the length, and the first weekday of a month.
+ * 
+ * The memo is a static table with one entry for every month from
+ * October 1582 up to December 9999, about a hundred thousand in all,
+ * that starts out empty.  The first lookup of any month of a year
+ * computes the descriptors of all the months of that year and
+ * publishes them to the table, and later lookups in that year read
+ * them back with a single load.
+ * 
+ * The table needs no initialization, and it is safe to use from any
+ * number of threads at once without locks.  Each entry is one 64-bit
+ * word that holds a whole descriptor, and it is written and read with
+ * atomic operations, so a reader sees either an empty entry or a
+ * complete one.  Threads that touch a new year at the same time may
+ * each compute it, but they store identical values, so the race is
+ * harmless.
+ * 
+ * The atomic operations are the __atomic builtins of GCC and Clang.
+ * With other compilers, the memo is left empty and every lookup
+ * computes its descriptor, with the same results.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+
+/*
+ * Month descriptor.
+ */
+typedef struct {
+  
+  /*
+   * The day offset of the first day of the month.
+   * 
+   * This is negative for October 1582, whose first fourteen days come
+   * before day offset zero, so that first plus the day of the month
+   * minus one is always the day offset of a day of the month.
+   */
+  int32_t first;
+  
+  /*
+   * The number of days in the month.
+   */
+  int32_t days;
+  
+  /*
+   * The weekday of the first day of the month, one for Monday up to
+   * seven for Sunday, as in grcal_weekday().
+   */
+  int32_t weekday;
+  
+} GRCAL_MONTH_INFO;
+
+/*
+ * Look up the descriptor of a month.
+ * 
+ * Parameters:
+ * 
+ *   y - the year
+ * 
+ *   m - the month
+ * 
+ *   pInfo - the structure to receive the descriptor
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the month is before October 1582
+ *   or after December 9999, in which case pInfo is not changed
+ */
+int grcal_memoMonth(int32_t y, int32_t m, GRCAL_MONTH_INFO *pInfo);
+
+/*
+ * Look up the descriptor of the month holding a day offset.
+ * 
+ * offs must be in range zero up to and including GRCAL_DAY_MAX, or a
+ * fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   offs - the day offset
+ * 
+ *   pInfo - the structure to receive the descriptor
+ */
+void grcal_memoMonthOf(int32_t offs, GRCAL_MONTH_INFO *pInfo);
+
+#endif
@@ -0,0 +1,337 @@
+/*
+ * grcal_ord.c
+ * 
+ * Implementation of grcal_ord.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_ord.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The month ordinal of 1200-03, the month of internal day zero.
+ */
+#define BASE_MONTH INT32_C(14402)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t spanOf(int kind);
+static int32_t minOf(int kind);
+static int32_t maxOf(int kind);
+static int32_t monthOf(int32_t offs);
+static int32_t monthFirst(int32_t mo);
+static size_t bounds(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int       last,
+          int32_t * pOffs);
+
+/*
+ * Get the number of months in a period.
+ * 
+ * Faults if the kind is not one of the GRCAL_ORD kinds.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ * Return:
+ * 
+ *   the number of months
+ */
+static int32_t spanOf(int kind) {
+  
+  int32_t span = 0;
+  
+  if (kind == GRCAL_ORD_MONTH) {
+    span = 1;
+  } else if (kind == GRCAL_ORD_QUARTER) {
+    span = 3;
+  } else if (kind == GRCAL_ORD_YEAR) {
+    span = 12;
+  } else {
+    abort();
+  }
+  
+  return span;
+}
+
+/*
+ * Get the minimum valid ordinal of a valid kind.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ * Return:
+ * 
+ *   the minimum ordinal
+ */
+static int32_t minOf(int kind) {
+  
+  int32_t result = 0;
+  
+  if (kind == GRCAL_ORD_MONTH) {
+    result = GRCAL_ORD_MONTH_MIN;
+  } else if (kind == GRCAL_ORD_QUARTER) {
+    result = GRCAL_ORD_QUARTER_MIN;
+  } else {
+    result = GRCAL_ORD_YEAR_MIN;
+  }
+  
+  return result;
+}
+
+/*
+ * Get the maximum valid ordinal of a valid kind.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ * Return:
+ * 
+ *   the maximum ordinal
+ */
+static int32_t maxOf(int kind) {
+  
+  int32_t result = 0;
+  
+  if (kind == GRCAL_ORD_MONTH) {
+    result = GRCAL_ORD_MONTH_MAX;
+  } else if (kind == GRCAL_ORD_QUARTER) {
+    result = GRCAL_ORD_QUARTER_MAX;
+  } else {
+    result = GRCAL_ORD_YEAR_MAX;
+  }
+  
+  return result;
+}
+
+/*
+ * Get the month ordinal of a valid day offset.
+ * 
+ * Parameters:
+ * 
+ *   offs - the day offset
+ * 
+ * Return:
+ * 
+ *   the month ordinal
+ */
+static int32_t monthOf(int32_t offs) {
+  
+  int32_t years = 0;
+  int32_t mp = 0;
+  int32_t doy = 0;
+  
+  /* Months start in March, so mp counts months within a March-based
+   * year */
+  grcal_privMarch(offs, &years, &mp, &doy);
+  return BASE_MONTH + (years * 12) + mp;
+}
+
+/*
+ * Get the day offset of the first day of a month.
+ * 
+ * The result is not clipped, so it is negative for October 1582, and
+ * the month after December 9999 gives GRCAL_DAY_MAX plus one.
+ * 
+ * Parameters:
+ * 
+ *   mo - the month ordinal, at least that of 1200-03
+ * 
+ * Return:
+ * 
+ *   the day offset
+ */
+static int32_t monthFirst(int32_t mo) {
+  
+  int32_t mm = 0;
+  int32_t yy = 0;
+  
+  /* Split into March-based years and months, where February is the
+   * last month of a year, so leap days never fall within one */
+  mm = mo - BASE_MONTH;
+  yy = mm / 12;
+  return grcal_privMarchFirst(yy, mm - (yy * 12));
+}
+
+/*
+ * Get the first or last days of an array of periods.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal, which is checked
+ * 
+ *   pOrds - the ordinals
+ * 
+ *   count - the number of ordinals
+ * 
+ *   last - non-zero for the last days, zero for the first days
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of ordinals that were out of range
+ */
+static size_t bounds(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int       last,
+          int32_t * pOffs) {
+  
+  int32_t span = 0;
+  int32_t lo = 0;
+  int32_t hi = 0;
+  int32_t ord = 0;
+  int32_t offs = 0;
+  int32_t adj = 0;
+  size_t bad = 0;
+  size_t i = 0;
+  int valid = 0;
+  
+  /* Check parameters */
+  span = spanOf(kind);
+  if (((pOrds == NULL) || (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  lo = minOf(kind);
+  hi = maxOf(kind);
+  
+  /* The last day of a period is the day before the first day of the
+   * next one */
+  adj = last ? 1 : 0;
+  
+  /* Out-of-range ordinals are replaced with the minimum so that the
+   * arithmetic stays in range, and the loop has no branches */
+  for(i = 0; i < count; i++) {
+    valid = (pOrds[i] >= lo) & (pOrds[i] <= hi);
+    ord = valid ? pOrds[i] : lo;
+    
+    offs = monthFirst((ord + adj) * span) - adj;
+    offs = (offs < 0) ? 0 : offs;
+    
+    pOffs[i] = valid ? offs : -1;
+    bad += (size_t) (1 - valid);
+  }
+  
+  return bad;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_ordFromOffset function.
+ */
+int32_t grcal_ordFromOffset(int kind, int32_t offs) {
+  
+  int32_t result = 0;
+  
+  grcal_ordFromOffsetBatch(kind, &offs, 1, &result);
+  return result;
+}
+
+/*
+ * grcal_ordFirst function.
+ */
+int32_t grcal_ordFirst(int kind, int32_t ord) {
+  
+  int32_t result = 0;
+  
+  bounds(kind, &ord, 1, 0, &result);
+  return result;
+}
+
+/*
+ * grcal_ordLast function.
+ */
+int32_t grcal_ordLast(int kind, int32_t ord) {
+  
+  int32_t result = 0;
+  
+  bounds(kind, &ord, 1, 1, &result);
+  return result;
+}
+
+/*
+ * grcal_ordFromOffsetBatch function.
+ */
+void grcal_ordFromOffsetBatch(
+          int       kind,
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pOrds) {
+  
+  int32_t mo = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  spanOf(kind);
+  if (((pOffs == NULL) || (pOrds == NULL)) && (count > 0)) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  /* Separate loops keep each divisor constant, so that the divisions
+   * become multiplications that vectorize */
+  if (kind == GRCAL_ORD_MONTH) {
+    for(i = 0; i < count; i++) {
+      pOrds[i] = monthOf(pOffs[i]);
+    }
+  } else if (kind == GRCAL_ORD_QUARTER) {
+    for(i = 0; i < count; i++) {
+      mo = monthOf(pOffs[i]);
+      pOrds[i] = mo / 3;
+    }
+  } else {
+    for(i = 0; i < count; i++) {
+      mo = monthOf(pOffs[i]);
+      pOrds[i] = mo / 12;
+    }
+  }
+}
+
+/*
+ * grcal_ordFirstBatch function.
+ */
+size_t grcal_ordFirstBatch(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int32_t * pOffs) {
+  return bounds(kind, pOrds, count, 0, pOffs);
+}
+
+/*
+ * grcal_ordLastBatch function.
+ */
+size_t grcal_ordLastBatch(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int32_t * pOffs) {
+  return bounds(kind, pOrds, count, 1, pOffs);
+}
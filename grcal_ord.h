@@ -0,0 +1,187 @@
+#ifndef GRCAL_ORD_H_INCLUDED
+#define GRCAL_ORD_H_INCLUDED
+
+/*
+ * grcal_ord.h
+ * ===========
+ * 
+ * Month, quarter, and year ordinals, for keying aggregates by calendar
+ * period.
+ * 
+ * An ordinal numbers the periods of one kind consecutively, so that
+ * the difference between two ordinals is the number of periods between
+ * them:
+ * 
+ *   - The month ordinal of a date is (year * 12) + (month - 1), so
+ *     that dividing by 12 gives the year and the remainder gives the
+ *     zero-based month.  This is the same as the month partition ID of
+ *     grcal_part.h.
+ * 
+ *   - The quarter ordinal is (year * 4) + (quarter - 1), where the
+ *     quarter is one for January up to March.
+ * 
+ *   - The year ordinal is the year.
+ * 
+ * Ordinals are valid from the period holding day offset zero up to the
+ * period holding GRCAL_DAY_MAX, as given by the constants below.  The
+ * first day of the first period of each kind is before day offset
+ * zero, so it is clipped to day offset zero.
+ * 
+ * Every conversion is a fixed sequence of arithmetic without loops or
+ * table lookups.  The batch functions run branch-free loops that the
+ * compiler can vectorize, in the same way as grcal_batch.h.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Ordinal kinds.
+ */
+#define GRCAL_ORD_MONTH   1
+#define GRCAL_ORD_QUARTER 2
+#define GRCAL_ORD_YEAR    3
+
+/*
+ * The valid range of each kind of ordinal, from October 1582 up to
+ * December 9999.
+ */
+#define GRCAL_ORD_MONTH_MIN   INT32_C(18993)
+#define GRCAL_ORD_MONTH_MAX   INT32_C(119999)
+#define GRCAL_ORD_QUARTER_MIN INT32_C(6331)
+#define GRCAL_ORD_QUARTER_MAX INT32_C(39999)
+#define GRCAL_ORD_YEAR_MIN    INT32_C(1582)
+#define GRCAL_ORD_YEAR_MAX    INT32_C(9999)
+
+/*
+ * Get the ordinal of the period holding a day offset.
+ * 
+ * kind must be one of the GRCAL_ORD kinds, and offs must be in range
+ * zero up to and including GRCAL_DAY_MAX, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   offs - the day offset
+ * 
+ * Return:
+ * 
+ *   the ordinal
+ */
+int32_t grcal_ordFromOffset(int kind, int32_t offs);
+
+/*
+ * Get the day offset of the first day of a period.
+ * 
+ * kind must be one of the GRCAL_ORD kinds, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   ord - the ordinal
+ * 
+ * Return:
+ * 
+ *   the day offset, clipped to zero for the first period, or -1 if the
+ *   ordinal is out of range
+ */
+int32_t grcal_ordFirst(int kind, int32_t ord);
+
+/*
+ * Get the day offset of the last day of a period.
+ * 
+ * kind must be one of the GRCAL_ORD kinds, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   ord - the ordinal
+ * 
+ * Return:
+ * 
+ *   the day offset, or -1 if the ordinal is out of range
+ */
+int32_t grcal_ordLast(int kind, int32_t ord);
+
+/*
+ * Get the ordinals of the periods holding an array of day offsets.
+ * 
+ * kind must be one of the GRCAL_ORD kinds, and every day offset must
+ * be valid, or a fault occurs before any output is written.  The
+ * output array may be the same as the input array.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   pOrds - the array to receive the ordinals
+ */
+void grcal_ordFromOffsetBatch(
+          int       kind,
+    const int32_t * pOffs,
+          size_t    count,
+          int32_t * pOrds);
+
+/*
+ * Get the day offsets of the first days of an array of periods.
+ * 
+ * kind must be one of the GRCAL_ORD kinds, or a fault occurs.  Each
+ * ordinal that is out of range gets a day offset of -1.  The output
+ * array may be the same as the input array.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   pOrds - the ordinals
+ * 
+ *   count - the number of ordinals
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of ordinals that were out of range
+ */
+size_t grcal_ordFirstBatch(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int32_t * pOffs);
+
+/*
+ * Get the day offsets of the last days of an array of periods.
+ * 
+ * The same as grcal_ordFirstBatch(), except that the last day of each
+ * period is returned.
+ * 
+ * Parameters:
+ * 
+ *   kind - the kind of ordinal
+ * 
+ *   pOrds - the ordinals
+ * 
+ *   count - the number of ordinals
+ * 
+ *   pOffs - the array to receive the day offsets
+ * 
+ * Return:
+ * 
+ *   the number of ordinals that were out of range
+ */
+size_t grcal_ordLastBatch(
+          int       kind,
+    const int32_t * pOrds,
+          size_t    count,
+          int32_t * pOffs);
+
+#endif
@@ -0,0 +1,717 @@
+/*
+ * grcal_par.c
+ * 
+ * Implementation of grcal_par.h
+ * 
+ * See the header for further information.
+ */
+
+#if !defined(_POSIX_C_SOURCE) || (_POSIX_C_SOURCE < 200112L)
+#undef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "grcal_par.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * The range of chunks currently owned by a lane.
+ */
+typedef struct {
+  
+  /*
+   * Lock protecting the range.
+   */
+  pthread_mutex_t lock;
+  
+  /*
+   * The next chunk index the owning lane will take.
+   */
+  size_t next;
+  
+  /*
+   * One past the last chunk index owned by the lane.  Thieves take
+   * chunks from this end.
+   */
+  size_t end;
+  
+} LANE_SLOT;
+
+/*
+ * A parallel-for job.
+ */
+typedef struct {
+  
+  /*
+   * The number of array elements and the elements per chunk.
+   */
+  size_t count;
+  size_t chunk;
+  
+  /*
+   * The range function and its client data.
+   */
+  GRCAL_RANGE_FUNC pFunc;
+  void *pArg;
+  
+  /*
+   * The number of lanes and their chunk ranges.
+   */
+  int lanes;
+  LANE_SLOT *pSlot;
+  
+} PAR_JOB;
+
+/*
+ * A worker thread of a pool.
+ */
+typedef struct {
+  
+  /*
+   * The pool that the worker belongs to.
+   */
+  GRCAL_POOL *pPool;
+  
+  /*
+   * The lane index that the worker runs.
+   */
+  int lane;
+  
+  /*
+   * The generation of the last job the worker has seen.
+   * 
+   * This is set to the generation of the pool before the thread is
+   * created, not read by the thread once it runs, since a job may
+   * already have been started by then.
+   */
+  unsigned long gen;
+  
+  /*
+   * The thread handle.
+   */
+  pthread_t thread;
+  
+} POOL_WORKER;
+
+/*
+ * GRCAL_POOL structure.
+ */
+struct GRCAL_POOL_TAG {
+  
+  /*
+   * Lock protecting the fields below, and the conditions that signal
+   * the start of a new job and the completion of all workers.
+   */
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  
+  /*
+   * Incremented each time a new job is started.
+   */
+  unsigned long gen;
+  
+  /*
+   * The number of workers that have not yet finished the current job.
+   */
+  int pending;
+  
+  /*
+   * Non-zero if the workers should exit.
+   */
+  int stop;
+  
+  /*
+   * The lane function and job of the current job.
+   */
+  GRCAL_LANE_FUNC pLane;
+  void *pJob;
+  
+  /*
+   * The number of lanes, and the workers for lanes one and up.
+   */
+  int lanes;
+  POOL_WORKER *pWorker;
+  
+};
+
+/*
+ * Argument structures for the conversion range functions.
+ */
+typedef struct {
+  const int32_t *pOffs;
+  int32_t *pYear;
+  int32_t *pMonth;
+  int32_t *pDayOfMonth;
+} OFFSET_ARGS;
+
+typedef struct {
+  const int32_t *pYear;
+  const int32_t *pMonth;
+  const int32_t *pDayOfMonth;
+  int32_t *pOffs;
+  pthread_mutex_t lock;
+  size_t invalid;
+} DATE_ARGS;
+
+typedef struct {
+  const int32_t *pOffs;
+  int32_t *pWeekday;
+} WEEKDAY_ARGS;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int takeChunk(PAR_JOB *pj, int lane, size_t *pChunk);
+static void runLane(void *pJob, int lane);
+static void *workerMain(void *pv);
+static void poolRun(
+    void            * pCustom,
+    int               lanes,
+    GRCAL_LANE_FUNC   pLane,
+    void            * pJob);
+
+static void offsetRange(void *pArg, size_t first, size_t count);
+static void dateRange(void *pArg, size_t first, size_t count);
+static void weekdayRange(void *pArg, size_t first, size_t count);
+
+/*
+ * Take the next chunk for a lane, stealing from another lane if the
+ * lane has run out of its own chunks.
+ * 
+ * Only one slot lock is ever held at a time, so lanes can not deadlock
+ * against each other.
+ * 
+ * Parameters:
+ * 
+ *   pj - the job
+ * 
+ *   lane - the lane that wants a chunk
+ * 
+ *   pChunk - pointer to the variable to receive the chunk index
+ * 
+ * Return:
+ * 
+ *   non-zero if a chunk was taken, zero if no work is left
+ */
+static int takeChunk(PAR_JOB *pj, int lane, size_t *pChunk) {
+  
+  LANE_SLOT *ps = NULL;
+  LANE_SLOT *pv = NULL;
+  int i = 0;
+  size_t take = 0;
+  size_t first = 0;
+  size_t last = 0;
+  
+  ps = &((pj->pSlot)[lane]);
+  
+  /* Take from the front of our own range if possible */
+  pthread_mutex_lock(&(ps->lock));
+  if (ps->next < ps->end) {
+    *pChunk = ps->next;
+    (ps->next)++;
+    pthread_mutex_unlock(&(ps->lock));
+    return 1;
+  }
+  pthread_mutex_unlock(&(ps->lock));
+  
+  /* Our range is empty, so look for a victim, starting with the next
+   * lane so that thieves spread out */
+  for(i = 1; i < pj->lanes; i++) {
+    pv = &((pj->pSlot)[(lane + i) % pj->lanes]);
+    
+    /* Steal the back half of the victim's range, rounding up so that a
+     * single remaining chunk can be stolen */
+    pthread_mutex_lock(&(pv->lock));
+    take = (pv->end - pv->next + 1) / 2;
+    if (take > 0) {
+      last = pv->end;
+      first = last - take;
+      pv->end = first;
+    }
+    pthread_mutex_unlock(&(pv->lock));
+    
+    /* Keep the first stolen chunk and publish the rest in our own
+     * range, where other thieves can find them */
+    if (take > 0) {
+      pthread_mutex_lock(&(ps->lock));
+      ps->next = first + 1;
+      ps->end = last;
+      pthread_mutex_unlock(&(ps->lock));
+      
+      *pChunk = first;
+      return 1;
+    }
+  }
+  
+  return 0;
+}
+
+/*
+ * Lane function for parallel-for jobs.
+ * 
+ * Parameters:
+ * 
+ *   pJob - the PAR_JOB
+ * 
+ *   lane - the lane index
+ */
+static void runLane(void *pJob, int lane) {
+  
+  PAR_JOB *pj = NULL;
+  size_t c = 0;
+  size_t first = 0;
+  size_t count = 0;
+  
+  pj = (PAR_JOB *) pJob;
+  if ((lane < 0) || (lane >= pj->lanes)) {
+    abort();
+  }
+  
+  while (takeChunk(pj, lane, &c)) {
+    first = c * pj->chunk;
+    count = pj->count - first;
+    if (count > pj->chunk) {
+      count = pj->chunk;
+    }
+    pj->pFunc(pj->pArg, first, count);
+  }
+}
+
+/*
+ * Thread function for pool workers.
+ * 
+ * Parameters:
+ * 
+ *   pv - the POOL_WORKER
+ * 
+ * Return:
+ * 
+ *   NULL
+ */
+static void *workerMain(void *pv) {
+  
+  POOL_WORKER *pw = NULL;
+  GRCAL_POOL *pp = NULL;
+  unsigned long seen = 0;
+  GRCAL_LANE_FUNC pLane = NULL;
+  void *pJob = NULL;
+  
+  pw = (POOL_WORKER *) pv;
+  pp = pw->pPool;
+  
+  seen = pw->gen;
+  pthread_mutex_lock(&(pp->lock));
+  for(;;) {
+    /* Wait for a new job or a stop request */
+    while ((pp->gen == seen) && (!(pp->stop))) {
+      pthread_cond_wait(&(pp->start), &(pp->lock));
+    }
+    if (pp->stop) {
+      break;
+    }
+    seen = pp->gen;
+    pLane = pp->pLane;
+    pJob = pp->pJob;
+    pthread_mutex_unlock(&(pp->lock));
+    
+    /* Run our lane */
+    pLane(pJob, pw->lane);
+    
+    /* Report completion */
+    pthread_mutex_lock(&(pp->lock));
+    (pp->pending)--;
+    if (pp->pending < 1) {
+      pthread_cond_signal(&(pp->done));
+    }
+  }
+  pthread_mutex_unlock(&(pp->lock));
+  
+  return NULL;
+}
+
+/*
+ * Executor run function for thread pools.
+ * 
+ * The calling thread runs lane zero.
+ * 
+ * Parameters:
+ * 
+ *   pCustom - the GRCAL_POOL
+ * 
+ *   lanes - the number of lanes, which must match the pool
+ * 
+ *   pLane - the lane function
+ * 
+ *   pJob - the job passed to the lane function
+ */
+static void poolRun(
+    void            * pCustom,
+    int               lanes,
+    GRCAL_LANE_FUNC   pLane,
+    void            * pJob) {
+  
+  GRCAL_POOL *pp = NULL;
+  
+  pp = (GRCAL_POOL *) pCustom;
+  if ((pp == NULL) || (lanes != pp->lanes) || (pLane == NULL)) {
+    abort();
+  }
+  
+  /* Start the workers */
+  if (lanes > 1) {
+    pthread_mutex_lock(&(pp->lock));
+    pp->pLane = pLane;
+    pp->pJob = pJob;
+    pp->pending = lanes - 1;
+    (pp->gen)++;
+    pthread_cond_broadcast(&(pp->start));
+    pthread_mutex_unlock(&(pp->lock));
+  }
+  
+  /* Run lane zero ourselves */
+  pLane(pJob, 0);
+  
+  /* Wait for the workers */
+  if (lanes > 1) {
+    pthread_mutex_lock(&(pp->lock));
+    while (pp->pending > 0) {
+      pthread_cond_wait(&(pp->done), &(pp->lock));
+    }
+    pthread_mutex_unlock(&(pp->lock));
+  }
+}
+
+/*
+ * Range functions for the conversions.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the argument structure for the conversion
+ * 
+ *   first - the first element to convert
+ * 
+ *   count - the number of elements to convert
+ */
+static void offsetRange(void *pArg, size_t first, size_t count) {
+  
+  OFFSET_ARGS *pa = (OFFSET_ARGS *) pArg;
+  
+  grcal_offsetToDateBatch(
+    pa->pOffs + first,
+    count,
+    (pa->pYear       != NULL) ? pa->pYear       + first : NULL,
+    (pa->pMonth      != NULL) ? pa->pMonth      + first : NULL,
+    (pa->pDayOfMonth != NULL) ? pa->pDayOfMonth + first : NULL);
+}
+
+static void dateRange(void *pArg, size_t first, size_t count) {
+  
+  DATE_ARGS *pa = (DATE_ARGS *) pArg;
+  size_t invalid = 0;
+  
+  invalid = grcal_dateToOffsetBatch(
+              pa->pYear + first,
+              pa->pMonth + first,
+              pa->pDayOfMonth + first,
+              count,
+              pa->pOffs + first);
+  
+  if (invalid > 0) {
+    pthread_mutex_lock(&(pa->lock));
+    pa->invalid += invalid;
+    pthread_mutex_unlock(&(pa->lock));
+  }
+}
+
+static void weekdayRange(void *pArg, size_t first, size_t count) {
+  
+  WEEKDAY_ARGS *pa = (WEEKDAY_ARGS *) pArg;
+  
+  grcal_weekdayBatch(pa->pOffs + first, count, pa->pWeekday + first);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_poolNew function.
+ */
+GRCAL_POOL *grcal_poolNew(int lanes) {
+  
+  GRCAL_POOL *pp = NULL;
+  long ncpu = 0;
+  int started = 0;
+  int i = 0;
+  
+  /* Determine lane count */
+  if (lanes == 0) {
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) {
+      ncpu = 1;
+    } else if (ncpu > GRCAL_PAR_MAX_LANES) {
+      ncpu = GRCAL_PAR_MAX_LANES;
+    }
+    lanes = (int) ncpu;
+  }
+  if ((lanes < 1) || (lanes > GRCAL_PAR_MAX_LANES)) {
+    abort();
+  }
+  
+  /* Allocate pool and workers */
+  pp = (GRCAL_POOL *) calloc(1, sizeof(GRCAL_POOL));
+  if (pp == NULL) {
+    return NULL;
+  }
+  pp->lanes = lanes;
+  
+  if (lanes > 1) {
+    pp->pWorker = (POOL_WORKER *) calloc(
+                    (size_t) (lanes - 1), sizeof(POOL_WORKER));
+    if (pp->pWorker == NULL) {
+      free(pp);
+      return NULL;
+    }
+  }
+  
+  if (pthread_mutex_init(&(pp->lock), NULL) ||
+      pthread_cond_init(&(pp->start), NULL) ||
+      pthread_cond_init(&(pp->done), NULL)) {
+    abort();
+  }
+  
+  /* Start the workers; if any fail to start, stop the ones that did */
+  for(i = 1; i < lanes; i++) {
+    (pp->pWorker)[i - 1].pPool = pp;
+    (pp->pWorker)[i - 1].lane = i;
+    (pp->pWorker)[i - 1].gen = pp->gen;
+    if (pthread_create(
+          &((pp->pWorker)[i - 1].thread),
+          NULL,
+          &workerMain,
+          &((pp->pWorker)[i - 1]))) {
+      break;
+    }
+    started++;
+  }
+  
+  if (started < lanes - 1) {
+    pp->lanes = started + 1;
+    grcal_poolFree(pp);
+    pp = NULL;
+  }
+  
+  return pp;
+}
+
+/*
+ * grcal_poolFree function.
+ */
+void grcal_poolFree(GRCAL_POOL *pPool) {
+  
+  int i = 0;
+  
+  if (pPool == NULL) {
+    return;
+  }
+  
+  /* Stop and join all workers */
+  pthread_mutex_lock(&(pPool->lock));
+  pPool->stop = 1;
+  pthread_cond_broadcast(&(pPool->start));
+  pthread_mutex_unlock(&(pPool->lock));
+  
+  for(i = 1; i < pPool->lanes; i++) {
+    pthread_join((pPool->pWorker)[i - 1].thread, NULL);
+  }
+  
+  pthread_cond_destroy(&(pPool->done));
+  pthread_cond_destroy(&(pPool->start));
+  pthread_mutex_destroy(&(pPool->lock));
+  
+  free(pPool->pWorker);
+  free(pPool);
+}
+
+/*
+ * grcal_poolExecutor function.
+ */
+void grcal_poolExecutor(GRCAL_POOL *pPool, GRCAL_EXECUTOR *pExec) {
+  
+  if ((pPool == NULL) || (pExec == NULL)) {
+    abort();
+  }
+  
+  pExec->lanes = pPool->lanes;
+  pExec->run = &poolRun;
+  pExec->pCustom = pPool;
+}
+
+/*
+ * grcal_parFor function.
+ */
+void grcal_parFor(
+    const GRCAL_EXECUTOR   * pExec,
+          size_t             count,
+          size_t             chunk,
+          GRCAL_RANGE_FUNC   pFunc,
+          void             * pArg) {
+  
+  PAR_JOB job;
+  LANE_SLOT slot[GRCAL_PAR_MAX_LANES];
+  size_t chunks = 0;
+  size_t per = 0;
+  size_t extra = 0;
+  size_t pos = 0;
+  int lanes = 0;
+  int i = 0;
+  
+  /* Check parameters */
+  if (pFunc == NULL) {
+    abort();
+  }
+  if (pExec != NULL) {
+    if ((pExec->lanes < 1) || (pExec->lanes > GRCAL_PAR_MAX_LANES) ||
+        (pExec->run == NULL)) {
+      abort();
+    }
+  }
+  
+  if (chunk == 0) {
+    chunk = GRCAL_PAR_CHUNK;
+  }
+  if (count == 0) {
+    return;
+  }
+  chunks = ((count - 1) / chunk) + 1;
+  
+  /* Use the calling thread directly if there is no executor or if
+   * there is only a single chunk */
+  if ((pExec == NULL) || (chunks < 2)) {
+    for(pos = 0; pos < count; pos += chunk) {
+      pFunc(pArg, pos, (count - pos < chunk) ? (count - pos) : chunk);
+    }
+    return;
+  }
+  
+  /* Deal the chunks out evenly to the lanes */
+  lanes = pExec->lanes;
+  per = chunks / (size_t) lanes;
+  extra = chunks % (size_t) lanes;
+  pos = 0;
+  for(i = 0; i < lanes; i++) {
+    if (pthread_mutex_init(&(slot[i].lock), NULL)) {
+      abort();
+    }
+    slot[i].next = pos;
+    pos += per + (((size_t) i < extra) ? 1 : 0);
+    slot[i].end = pos;
+  }
+  
+  job.count = count;
+  job.chunk = chunk;
+  job.pFunc = pFunc;
+  job.pArg = pArg;
+  job.lanes = lanes;
+  job.pSlot = slot;
+  
+  /* Run the lanes */
+  pExec->run(pExec->pCustom, lanes, &runLane, &job);
+  
+  for(i = 0; i < lanes; i++) {
+    pthread_mutex_destroy(&(slot[i].lock));
+  }
+}
+
+/*
+ * grcal_offsetToDatePar function.
+ */
+void grcal_offsetToDatePar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pOffs,
+          size_t           count,
+          int32_t        * pYear,
+          int32_t        * pMonth,
+          int32_t        * pDayOfMonth) {
+  
+  OFFSET_ARGS a;
+  
+  if ((pOffs == NULL) && (count > 0)) {
+    abort();
+  }
+  
+  a.pOffs = pOffs;
+  a.pYear = pYear;
+  a.pMonth = pMonth;
+  a.pDayOfMonth = pDayOfMonth;
+  
+  grcal_parFor(pExec, count, 0, &offsetRange, &a);
+}
+
+/*
+ * grcal_dateToOffsetPar function.
+ */
+size_t grcal_dateToOffsetPar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pYear,
+    const int32_t        * pMonth,
+    const int32_t        * pDayOfMonth,
+          size_t           count,
+          int32_t        * pOffs) {
+  
+  DATE_ARGS a;
+  
+  if (((pYear == NULL) || (pMonth == NULL) || (pDayOfMonth == NULL) ||
+        (pOffs == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  a.pYear = pYear;
+  a.pMonth = pMonth;
+  a.pDayOfMonth = pDayOfMonth;
+  a.pOffs = pOffs;
+  a.invalid = 0;
+  if (pthread_mutex_init(&(a.lock), NULL)) {
+    abort();
+  }
+  
+  grcal_parFor(pExec, count, 0, &dateRange, &a);
+  
+  pthread_mutex_destroy(&(a.lock));
+  return a.invalid;
+}
+
+/*
+ * grcal_weekdayPar function.
+ */
+void grcal_weekdayPar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pOffs,
+          size_t           count,
+          int32_t        * pWeekday) {
+  
+  WEEKDAY_ARGS a;
+  
+  if (((pOffs == NULL) || (pWeekday == NULL)) && (count > 0)) {
+    abort();
+  }
+  
+  a.pOffs = pOffs;
+  a.pWeekday = pWeekday;
+  
+  grcal_parFor(pExec, count, 0, &weekdayRange, &a);
+}
@@ -0,0 +1,213 @@
+#ifndef GRCAL_PAR_H_INCLUDED
+#define GRCAL_PAR_H_INCLUDED
+
+/*
+ * grcal_par.h
+ * ===========
+ * 
+ * Parallel versions of the grcal_batch.h conversions for very large
+ * arrays.
+ * 
+ * Work is divided into chunks of GRCAL_PAR_CHUNK elements, which are
+ * small enough that the inputs and outputs of a chunk stay in the
+ * per-core caches.  The chunks are initially dealt out evenly to a set
+ * of lanes.  Each lane works through its own chunks from the front, and
+ * when it runs out, it steals the back half of the remaining chunks of
+ * another lane.  This keeps all lanes busy even when some of them are
+ * delayed.
+ * 
+ * Lanes are run by an executor.  The library includes a lightweight
+ * pthreads thread pool that can serve as an executor, but clients may
+ * instead provide their own executor to integrate with an existing
+ * scheduler.  See GRCAL_EXECUTOR.
+ * 
+ * This module requires POSIX threads and is not available in the
+ * freestanding configuration.
+ */
+
+#include "grcal_batch.h"
+
+/*
+ * The number of array elements in each chunk of work.
+ */
+#define GRCAL_PAR_CHUNK 8192
+
+/*
+ * The maximum number of lanes in an executor.
+ */
+#define GRCAL_PAR_MAX_LANES 256
+
+/*
+ * Function type for lanes of work.
+ * 
+ * An executor must call this function exactly once for each lane index
+ * in range [0, lanes), passing the given pJob pointer through.
+ */
+typedef void (*GRCAL_LANE_FUNC)(void *pJob, int lane);
+
+/*
+ * Function type for processing a range of array elements.
+ * 
+ * The function is called for disjoint ranges that together cover the
+ * whole array.  It may be called concurrently from different threads.
+ */
+typedef void (*GRCAL_RANGE_FUNC)(
+    void   * pArg,
+    size_t   first,
+    size_t   count);
+
+/*
+ * Executor structure.
+ * 
+ * The run function must call pLane once for each lane index in range
+ * [0, lanes) and must not return until all of those calls have
+ * returned.  The calls may be made concurrently on different threads,
+ * or one after another on the calling thread; results are correct
+ * either way, since any lane that runs finishes the work left over by
+ * lanes that have not run yet.
+ */
+typedef struct {
+  
+  /*
+   * The number of lanes, in range [1, GRCAL_PAR_MAX_LANES].
+   */
+  int lanes;
+  
+  /*
+   * The function that runs all of the lanes.
+   * 
+   * pCustom is passed through from the structure below.
+   */
+  void (*run)(
+      void            * pCustom,
+      int               lanes,
+      GRCAL_LANE_FUNC   pLane,
+      void            * pJob);
+  
+  /*
+   * Client data passed to the run function.
+   */
+  void *pCustom;
+  
+} GRCAL_EXECUTOR;
+
+/*
+ * Opaque thread pool structure.
+ */
+struct GRCAL_POOL_TAG;
+typedef struct GRCAL_POOL_TAG GRCAL_POOL;
+
+/*
+ * Create a new thread pool.
+ * 
+ * The pool uses the calling thread as one of its lanes, so the number
+ * of threads that are started is one less than the given lane count.
+ * The lane count must be in range [1, GRCAL_PAR_MAX_LANES] or a fault
+ * occurs.  Pass zero to use the number of online processors.
+ * 
+ * The pool may only run one job at a time.  Concurrent use of the same
+ * pool from different threads is not allowed.
+ * 
+ * Parameters:
+ * 
+ *   lanes - the number of lanes, or zero to use the processor count
+ * 
+ * Return:
+ * 
+ *   the new thread pool, or NULL if the threads could not be started
+ */
+GRCAL_POOL *grcal_poolNew(int lanes);
+
+/*
+ * Stop the threads of a thread pool and release it.
+ * 
+ * Does nothing if NULL is passed.
+ * 
+ * Parameters:
+ * 
+ *   pPool - the thread pool to release, or NULL
+ */
+void grcal_poolFree(GRCAL_POOL *pPool);
+
+/*
+ * Initialize an executor structure that runs lanes on a thread pool.
+ * 
+ * The executor is only valid while the pool is.
+ * 
+ * Parameters:
+ * 
+ *   pPool - the thread pool
+ * 
+ *   pExec - the executor structure to initialize
+ */
+void grcal_poolExecutor(GRCAL_POOL *pPool, GRCAL_EXECUTOR *pExec);
+
+/*
+ * Process an array in parallel chunks with work stealing.
+ * 
+ * The array is divided into chunks of chunk elements, or
+ * GRCAL_PAR_CHUNK elements if chunk is zero.  pFunc is called on each
+ * chunk exactly once, from the lanes of the given executor.  If pExec
+ * is NULL, all chunks are processed on the calling thread.
+ * 
+ * Parameters:
+ * 
+ *   pExec - the executor, or NULL
+ * 
+ *   count - the number of elements in the array
+ * 
+ *   chunk - the number of elements in each chunk, or zero
+ * 
+ *   pFunc - the function that processes a range of elements
+ * 
+ *   pArg - client data passed through to pFunc
+ */
+void grcal_parFor(
+    const GRCAL_EXECUTOR   * pExec,
+          size_t             count,
+          size_t             chunk,
+          GRCAL_RANGE_FUNC   pFunc,
+          void             * pArg);
+
+/*
+ * Parallel version of grcal_offsetToDateBatch().
+ * 
+ * Parameters are the same as for the batch function, with the executor
+ * added at the start.  pExec may be NULL to run on the calling thread.
+ */
+void grcal_offsetToDatePar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pOffs,
+          size_t           count,
+          int32_t        * pYear,
+          int32_t        * pMonth,
+          int32_t        * pDayOfMonth);
+
+/*
+ * Parallel version of grcal_dateToOffsetBatch().
+ * 
+ * Parameters and return value are the same as for the batch function,
+ * with the executor added at the start.  pExec may be NULL to run on
+ * the calling thread.
+ */
+size_t grcal_dateToOffsetPar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pYear,
+    const int32_t        * pMonth,
+    const int32_t        * pDayOfMonth,
+          size_t           count,
+          int32_t        * pOffs);
+
+/*
+ * Parallel version of grcal_weekdayBatch().
+ * 
+ * Parameters are the same as for the batch function, with the executor
+ * added at the start.  pExec may be NULL to run on the calling thread.
+ */
+void grcal_weekdayPar(
+    const GRCAL_EXECUTOR * pExec,
+    const int32_t        * pOffs,
+          size_t           count,
+          int32_t        * pWeekday);
+
+#endif
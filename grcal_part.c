@@ -0,0 +1,464 @@
+/*
+ * grcal_part.c
+ * 
+ * Implementation of grcal_part.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_part.h"
+#include "grcal_priv.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Positions of the year, month, and day digits within a path.
+ */
+#define POS_YEAR  5
+#define POS_MONTH 16
+#define POS_DAY   23
+
+/*
+ * Path lengths of each granularity.
+ */
+#define LEN_YEAR  9
+#define LEN_MONTH 18
+#define LEN_DAY   25
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void checkGran(int gran);
+static void putDigits(char *p, int v, int width);
+static size_t formatPath(int gran, int y, int m, int d, char *pBuf);
+static int32_t partOf(
+    int32_t   offs,
+    int       gran,
+    int32_t * pLo,
+    int32_t * pHi);
+static void advance(GRCAL_PART_ITER *pIter);
+
+/*
+ * Fault unless a granularity is one of the GRCAL_PART granularities.
+ * 
+ * Parameters:
+ * 
+ *   gran - the granularity to check
+ */
+static void checkGran(int gran) {
+  if ((gran != GRCAL_PART_YEAR) && (gran != GRCAL_PART_MONTH) &&
+      (gran != GRCAL_PART_DAY)) {
+    abort();
+  }
+}
+
+/*
+ * Write a non-negative value as a fixed number of decimal digits.
+ * 
+ * Parameters:
+ * 
+ *   p - the first character to write
+ * 
+ *   v - the value, which must fit in the number of digits
+ * 
+ *   width - the number of digits
+ */
+static void putDigits(char *p, int v, int width) {
+  for(width--; width >= 0; width--) {
+    p[width] = (char) ('0' + (v % 10));
+    v /= 10;
+  }
+}
+
+/*
+ * Format a whole partition path.
+ * 
+ * Parameters:
+ * 
+ *   gran - the granularity
+ * 
+ *   y - the year
+ * 
+ *   m - the month, ignored for year partitions
+ * 
+ *   d - the day, ignored for year and month partitions
+ * 
+ *   pBuf - the buffer, with room for GRCAL_PART_PATH_MAX characters
+ * 
+ * Return:
+ * 
+ *   the length of the path
+ */
+static size_t formatPath(int gran, int y, int m, int d, char *pBuf) {
+  
+  size_t len = 0;
+  
+  memcpy(pBuf, "year=0000/month=00/day=00", LEN_DAY);
+  putDigits(pBuf + POS_YEAR, y, 4);
+  putDigits(pBuf + POS_MONTH, m, 2);
+  putDigits(pBuf + POS_DAY, d, 2);
+  
+  if (gran == GRCAL_PART_YEAR) {
+    len = LEN_YEAR;
+  } else if (gran == GRCAL_PART_MONTH) {
+    len = LEN_MONTH;
+  } else {
+    len = LEN_DAY;
+  }
+  pBuf[len] = '\0';
+  
+  return len;
+}
+
+/*
+ * Find the partition of a valid day offset.
+ * 
+ * Parameters:
+ * 
+ *   offs - the day offset
+ * 
+ *   gran - the granularity
+ * 
+ *   pLo - receives the first day offset of the partition
+ * 
+ *   pHi - receives the last day offset of the partition
+ * 
+ * Return:
+ * 
+ *   the partition ID
+ */
+static int32_t partOf(
+    int32_t   offs,
+    int       gran,
+    int32_t * pLo,
+    int32_t * pHi) {
+  
+  int32_t id = 0;
+  int32_t base = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  if (gran == GRCAL_PART_DAY) {
+    *pLo = offs;
+    *pHi = offs;
+    return offs;
+  }
+  
+  grcal_offsetToDate(offs, &y, &m, &d);
+  
+  if (gran == GRCAL_PART_MONTH) {
+    *pLo = offs - (d - 1);
+    *pHi = *pLo + (grcal_privMonthDays(y, m) - 1);
+    id = (int32_t) ((y * 12) + (m - 1));
+    
+  } else {
+    /* The partition of 1582 starts before the first day offset, so its
+     * first day offset is clamped to zero */
+    if (grcal_dateToOffset(&base, y, 1, 1)) {
+      *pLo = base;
+    } else {
+      *pLo = 0;
+    }
+    *pHi = offs;
+    if (grcal_dateToOffset(&base, y, 12, 31)) {
+      *pHi = base;
+    }
+    id = (int32_t) y;
+  }
+  
+  return id;
+}
+
+/*
+ * Move an iterator to the first day of the partition after its current
+ * one, by carrying days into months and months into years.
+ * 
+ * Only the digits of the path that change are rewritten.
+ * 
+ * Parameters:
+ * 
+ *   pIter - the iterator
+ */
+static void advance(GRCAL_PART_ITER *pIter) {
+  
+  int carry = 0;
+  
+  if (pIter->gran == GRCAL_PART_DAY) {
+    (pIter->d)++;
+    if (pIter->d > grcal_privMonthDays(pIter->y, pIter->m)) {
+      pIter->d = 1;
+      carry = 1;
+    }
+    putDigits((pIter->path) + POS_DAY, pIter->d, 2);
+  } else {
+    carry = 1;
+  }
+  
+  if (carry && (pIter->gran != GRCAL_PART_YEAR)) {
+    (pIter->m)++;
+    carry = 0;
+    if (pIter->m > 12) {
+      pIter->m = 1;
+      carry = 1;
+    }
+    putDigits((pIter->path) + POS_MONTH, pIter->m, 2);
+  }
+  
+  if (carry) {
+    (pIter->y)++;
+    putDigits((pIter->path) + POS_YEAR, pIter->y, 4);
+  }
+  
+  /* Coarser partitions always start on the first of a month */
+  if (pIter->gran != GRCAL_PART_DAY) {
+    pIter->d = 1;
+  }
+  if (pIter->gran == GRCAL_PART_YEAR) {
+    pIter->m = 1;
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_partBegin function.
+ */
+void grcal_partBegin(
+    GRCAL_PART_ITER * pIter,
+    int               gran,
+    int32_t           first,
+    int32_t           last) {
+  
+  /* Check parameters */
+  if (pIter == NULL) {
+    abort();
+  }
+  checkGran(gran);
+  if ((first < 0) || (first > GRCAL_DAY_MAX) ||
+      (last < 0) || (last > GRCAL_DAY_MAX)) {
+    abort();
+  }
+  
+  memset(pIter, 0, sizeof(GRCAL_PART_ITER));
+  pIter->gran = gran;
+  pIter->next = first;
+  pIter->last = last;
+  
+  /* This is the only full decomposition of the iteration */
+  grcal_offsetToDate(first, &(pIter->y), &(pIter->m), &(pIter->d));
+  formatPath(gran, pIter->y, pIter->m, pIter->d, pIter->path);
+}
+
+/*
+ * grcal_partNext function.
+ */
+const char *grcal_partNext(
+    GRCAL_PART_ITER * pIter,
+    int32_t         * pFirst,
+    int32_t         * pLast) {
+  
+  int32_t lo = 0;
+  int32_t hi = 0;
+  
+  /* Check parameters */
+  if (pIter == NULL) {
+    abort();
+  }
+  
+  if (pIter->next > pIter->last) {
+    return NULL;
+  }
+  
+  /* Step from the partition returned by the previous call to the one
+   * that starts at the next day offset */
+  if (pIter->started) {
+    advance(pIter);
+  }
+  pIter->started = 1;
+  
+  /* Find the end of the current partition from its first day, and
+   * clip it to the range */
+  lo = pIter->next;
+  if (pIter->gran == GRCAL_PART_DAY) {
+    hi = lo;
+  } else if (pIter->gran == GRCAL_PART_MONTH) {
+    hi = lo + (grcal_privMonthDays(pIter->y, pIter->m) - pIter->d);
+  } else {
+    if (!grcal_dateToOffset(&hi, pIter->y, 12, 31)) {
+      hi = GRCAL_DAY_MAX;
+    }
+  }
+  if (hi > pIter->last) {
+    hi = pIter->last;
+  }
+  
+  if (pFirst != NULL) {
+    *pFirst = lo;
+  }
+  if (pLast != NULL) {
+    *pLast = hi;
+  }
+  pIter->next = hi + 1;
+  
+  return pIter->path;
+}
+
+/*
+ * grcal_partPath function.
+ */
+size_t grcal_partPath(int gran, int32_t id, char *pBuf) {
+  
+  int32_t lo = 0;
+  int32_t hi = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  /* Check parameters */
+  if (pBuf == NULL) {
+    abort();
+  }
+  checkGran(gran);
+  
+  if (gran == GRCAL_PART_DAY) {
+    if ((id < 0) || (id > GRCAL_DAY_MAX)) {
+      abort();
+    }
+    grcal_offsetToDate(id, &y, &m, &d);
+    
+  } else {
+    /* Check the ID against the partitions of the first and last valid
+     * day offsets */
+    if ((id < partOf(0, gran, &lo, &hi)) ||
+        (id > partOf(GRCAL_DAY_MAX, gran, &lo, &hi))) {
+      abort();
+    }
+    if (gran == GRCAL_PART_MONTH) {
+      y = (int) (id / 12);
+      m = (int) (id % 12) + 1;
+    } else {
+      y = (int) id;
+      m = 1;
+    }
+    d = 1;
+  }
+  
+  return formatPath(gran, y, m, d, pBuf);
+}
+
+/*
+ * grcal_partIds function.
+ */
+void grcal_partIds(
+    const int32_t * pOffs,
+          size_t    count,
+          int       gran,
+          int32_t * pIds) {
+  
+  int32_t lo = 1;
+  int32_t hi = 0;
+  int32_t id = 0;
+  int32_t x = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkGran(gran);
+  if (((pOffs == NULL) || (pIds == NULL)) && (count > 0)) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  
+  if (gran == GRCAL_PART_DAY) {
+    if (pIds != pOffs) {
+      memmove(pIds, pOffs, count * sizeof(int32_t));
+    }
+    return;
+  }
+  
+  /* A row within the bounds of the partition of the row before it
+   * reuses that partition ID; the bounds start out empty */
+  for(i = 0; i < count; i++) {
+    x = pOffs[i];
+    if ((x < lo) || (x > hi)) {
+      id = partOf(x, gran, &lo, &hi);
+    }
+    pIds[i] = id;
+  }
+}
+
+/*
+ * grcal_partRuns function.
+ */
+size_t grcal_partRuns(
+    const int32_t        * pOffs,
+          size_t           count,
+          int              gran,
+          GRCAL_PART_RUN * pRuns,
+          size_t           runCap) {
+  
+  int32_t lo = 1;
+  int32_t hi = 0;
+  int32_t id = 0;
+  int32_t x = 0;
+  size_t runs = 0;
+  size_t start = 0;
+  size_t i = 0;
+  
+  /* Check parameters */
+  checkGran(gran);
+  if ((pOffs == NULL) && (count > 0)) {
+    abort();
+  }
+  if (grcal_privBadOffsets(pOffs, count)) {
+    abort();
+  }
+  if ((pRuns == NULL) && (runCap > 0)) {
+    abort();
+  }
+  
+  for(i = 0; i < count; i++) {
+    x = pOffs[i];
+    if ((x >= lo) && (x <= hi)) {
+      continue;
+    }
+    
+    /* Close the run before this row and open a new one */
+    if (i > 0) {
+      if (runs < runCap) {
+        pRuns[runs].id = id;
+        pRuns[runs].start = start;
+        pRuns[runs].count = i - start;
+      }
+      runs++;
+    }
+    id = partOf(x, gran, &lo, &hi);
+    start = i;
+  }
+  
+  if (count > 0) {
+    if (runs < runCap) {
+      pRuns[runs].id = id;
+      pRuns[runs].start = start;
+      pRuns[runs].count = count - start;
+    }
+    runs++;
+  }
+  
+  return runs;
+}
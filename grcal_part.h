@@ -0,0 +1,215 @@
+#ifndef GRCAL_PART_H_INCLUDED
+#define GRCAL_PART_H_INCLUDED
+
+/*
+ * grcal_part.h
+ * ============
+ * 
+ * Date partitioning in the Hive layout used by data lakes, where a
+ * partition is a directory path such as year=2024/month=03/day=05.
+ * 
+ * Partitions have a granularity of a year, a month, or a day, and the
+ * path of a partition has the year=YYYY, month=MM, and day=DD parts
+ * down to that granularity.
+ * 
+ * A query planner turns a range of day offsets into the list of
+ * partitions that it covers with the iterator below.  The iterator
+ * only decomposes the first date of the range.  After that, it steps
+ * from one partition to the next by carrying days into months and
+ * months into years, and it rewrites only the digits of the path that
+ * change.
+ * 
+ * A writer turns the date of each row into a partition ID with
+ * grcal_partIds(), or splits a column into runs of rows that share a
+ * partition with grcal_partRuns().  A partition ID is the day offset
+ * for day partitions, the month ordinal (year * 12 + month - 1) for
+ * month partitions, and the year for year partitions.  When the input
+ * is sorted, most rows fall into the same partition as the row before
+ * them, which is detected with two comparisons and needs no date
+ * conversion.  grcal_partPath() formats the path of a partition ID.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Partition granularities.
+ */
+#define GRCAL_PART_YEAR  1
+#define GRCAL_PART_MONTH 2
+#define GRCAL_PART_DAY   3
+
+/*
+ * The size of a buffer that can hold any partition path, including the
+ * terminating nul.
+ */
+#define GRCAL_PART_PATH_MAX 26
+
+/*
+ * Partition iterator structure.
+ * 
+ * The contents are private to grcal_part.c.
+ */
+typedef struct {
+  int gran;
+  int started;
+  int32_t next;
+  int32_t last;
+  int y;
+  int m;
+  int d;
+  char path[GRCAL_PART_PATH_MAX];
+} GRCAL_PART_ITER;
+
+/*
+ * A run of consecutive rows in the same partition.
+ */
+typedef struct {
+  
+  /*
+   * The partition ID.
+   */
+  int32_t id;
+  
+  /*
+   * The index of the first row of the run.
+   */
+  size_t start;
+  
+  /*
+   * The number of rows in the run.
+   */
+  size_t count;
+  
+} GRCAL_PART_RUN;
+
+/*
+ * Start iterating over the partitions of a range of day offsets.
+ * 
+ * gran must be one of the GRCAL_PART granularities, and first and last
+ * must be valid day offsets, or a fault occurs.  If last is less than
+ * first, the range is empty.
+ * 
+ * Parameters:
+ * 
+ *   pIter - the iterator to initialize
+ * 
+ *   gran - the partition granularity
+ * 
+ *   first - the first day offset of the range
+ * 
+ *   last - the last day offset of the range
+ */
+void grcal_partBegin(
+    GRCAL_PART_ITER * pIter,
+    int               gran,
+    int32_t           first,
+    int32_t           last);
+
+/*
+ * Get the next partition of a range.
+ * 
+ * The returned path points into the iterator, and it is only valid
+ * until the next call.  The first and last day offsets of the part of
+ * the partition that lies within the range are written to pFirst and
+ * pLast, each of which may be NULL if not required.
+ * 
+ * Parameters:
+ * 
+ *   pIter - the iterator
+ * 
+ *   pFirst - pointer to the variable to receive the first day offset,
+ *   or NULL
+ * 
+ *   pLast - pointer to the variable to receive the last day offset, or
+ *   NULL
+ * 
+ * Return:
+ * 
+ *   the nul-terminated partition path, or NULL if there are no more
+ *   partitions
+ */
+const char *grcal_partNext(
+    GRCAL_PART_ITER * pIter,
+    int32_t         * pFirst,
+    int32_t         * pLast);
+
+/*
+ * Format the path of a partition.
+ * 
+ * gran must be one of the GRCAL_PART granularities, and id must be the
+ * ID of a partition that holds valid day offsets, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   gran - the partition granularity
+ * 
+ *   id - the partition ID
+ * 
+ *   pBuf - the buffer to receive the nul-terminated path, which must
+ *   have room for GRCAL_PART_PATH_MAX characters
+ * 
+ * Return:
+ * 
+ *   the length of the path, not including the terminating nul
+ */
+size_t grcal_partPath(int gran, int32_t id, char *pBuf);
+
+/*
+ * Map an array of day offsets to partition IDs.
+ * 
+ * gran must be one of the GRCAL_PART granularities, and every day
+ * offset must be valid, or a fault occurs before any output is
+ * written.  The output array may be the same as the input array.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   gran - the partition granularity
+ * 
+ *   pIds - the array to receive the partition IDs
+ */
+void grcal_partIds(
+    const int32_t * pOffs,
+          size_t    count,
+          int       gran,
+          int32_t * pIds);
+
+/*
+ * Split an array of day offsets into runs of consecutive rows in the
+ * same partition.
+ * 
+ * gran and the day offsets are checked as for grcal_partIds().  Up to
+ * runCap runs are written to pRuns, which may be NULL if runCap is
+ * zero.  The total number of runs is returned even if it is greater
+ * than runCap, so a caller can size the array with a first call.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets
+ * 
+ *   count - the number of day offsets
+ * 
+ *   gran - the partition granularity
+ * 
+ *   pRuns - the array to receive the runs, or NULL
+ * 
+ *   runCap - the number of runs that pRuns has room for
+ * 
+ * Return:
+ * 
+ *   the total number of runs
+ */
+size_t grcal_partRuns(
+    const int32_t        * pOffs,
+          size_t           count,
+          int              gran,
+          GRCAL_PART_RUN * pRuns,
+          size_t           runCap);
+
+#endif
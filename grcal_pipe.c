@@ -0,0 +1,525 @@
+/*
+ * grcal_pipe.c
+ * 
+ * Implementation of grcal_pipe.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_pipe.h"
+#include "grcal_priv.h"
+#include "grcal_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Stage kinds.
+ */
+#define STAGE_DAYS     1
+#define STAGE_MONTHS   2
+#define STAGE_TRUNCATE 3
+#define STAGE_EXPR     4
+
+/*
+ * Any move by more days or months than these goes out of range, so
+ * larger arguments are clamped to them.
+ */
+#define MAX_DAYS   (GRCAL_DAY_MAX + 1)
+#define MAX_MONTHS 120000
+
+/*
+ * The number of rows that each stage processes at a time.
+ * 
+ * The block buffers of a run take five int32_t values per row, so this
+ * keeps them well within a typical 32 KiB L1 data cache.
+ */
+#define PIPE_BLOCK 256
+
+/*
+ * The first and last months that can hold valid dates, counted from
+ * year zero.
+ */
+#define FIRST_MONTH (1582 * 12)
+#define LAST_MONTH  ((9999 * 12) + 11)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * Block buffers of a run.
+ */
+typedef struct {
+  
+  /*
+   * The day offsets of the block, with -1 for invalid rows.
+   */
+  int32_t offs[PIPE_BLOCK];
+  
+  /*
+   * Scratch space for stages that work on years, months, and days.
+   */
+  int32_t y[PIPE_BLOCK];
+  int32_t m[PIPE_BLOCK];
+  int32_t d[PIPE_BLOCK];
+  int32_t v[PIPE_BLOCK];
+  
+} PIPE_BLOCKS;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int addStage(
+          GRCAL_PIPE * pPipe,
+          int          kind,
+          int32_t      arg,
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal);
+static void toDates(PIPE_BLOCKS *pb, size_t n);
+static void runDays(PIPE_BLOCKS *pb, size_t n, int32_t arg);
+static void runMonths(PIPE_BLOCKS *pb, size_t n, int32_t arg);
+static void runTruncate(PIPE_BLOCKS *pb, size_t n, int unit);
+static void loadBlock(
+          PIPE_BLOCKS   * pb,
+          size_t          n,
+          int             format,
+    const unsigned char * pIn,
+          size_t          stride);
+static void storeBlock(
+          PIPE_BLOCKS   * pb,
+          size_t          n,
+          int             format,
+          unsigned char * pOut,
+          size_t          stride);
+
+/*
+ * Append a stage to a pipeline.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   kind - the stage kind
+ * 
+ *   arg - the stage argument
+ * 
+ *   pExpr - the compiled expression, or NULL
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the pipeline is full
+ */
+static int addStage(
+          GRCAL_PIPE * pPipe,
+          int          kind,
+          int32_t      arg,
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal) {
+  
+  GRCAL_PIPE_STAGE *ps = NULL;
+  
+  if (pPipe->count >= GRCAL_PIPE_MAX_STAGES) {
+    return 0;
+  }
+  
+  ps = &((pPipe->stages)[pPipe->count]);
+  ps->kind = kind;
+  ps->arg = arg;
+  ps->pExpr = pExpr;
+  ps->pCal = pCal;
+  (pPipe->count)++;
+  
+  return 1;
+}
+
+/*
+ * Split the day offsets of a block into years, months, and days.
+ * 
+ * Invalid rows are converted as day zero, so the results for them are
+ * meaningless but harmless.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ */
+static void toDates(PIPE_BLOCKS *pb, size_t n) {
+  
+  size_t i = 0;
+  
+  for(i = 0; i < n; i++) {
+    (pb->v)[i] = ((pb->offs)[i] < 0) ? 0 : (pb->offs)[i];
+  }
+  grcal_offsetToDateBatch(pb->v, n, pb->y, pb->m, pb->d);
+}
+
+/*
+ * Move the dates of a block by a number of days.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ * 
+ *   arg - the number of days, at most MAX_DAYS in magnitude
+ */
+static void runDays(PIPE_BLOCKS *pb, size_t n, int32_t arg) {
+  
+  size_t i = 0;
+  int32_t x = 0;
+  int32_t r = 0;
+  
+  for(i = 0; i < n; i++) {
+    x = (pb->offs)[i];
+    r = x + arg;
+    (pb->offs)[i] =
+        ((x >= 0) & (r >= 0) & (r <= GRCAL_DAY_MAX)) ? r : -1;
+  }
+}
+
+/*
+ * Move the dates of a block by a number of months, clamping the day of
+ * the month.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ * 
+ *   arg - the number of months, at most MAX_MONTHS in magnitude
+ */
+static void runMonths(PIPE_BLOCKS *pb, size_t n, int32_t arg) {
+  
+  size_t i = 0;
+  int32_t idx = 0;
+  int32_t year = 0;
+  int32_t month = 0;
+  int32_t len = 0;
+  int valid = 0;
+  
+  toDates(pb, n);
+  
+  /* Move the month and clamp the day without branches */
+  for(i = 0; i < n; i++) {
+    idx = ((pb->y)[i] * 12) + ((pb->m)[i] - 1) + arg;
+    valid = ((pb->offs)[i] >= 0) &
+              (idx >= FIRST_MONTH) & (idx <= LAST_MONTH);
+    idx = valid ? idx : FIRST_MONTH;
+    
+    year = idx / 12;
+    month = (idx % 12) + 1;
+    len = grcal_privMonthDays(year, month);
+    
+    (pb->y)[i] = valid ? year : 0;
+    (pb->m)[i] = month;
+    (pb->d)[i] = ((pb->d)[i] > len) ? len : (pb->d)[i];
+  }
+  
+  /* Year zero makes the invalid rows fail the conversion back */
+  grcal_dateToOffsetBatch(pb->y, pb->m, pb->d, n, pb->offs);
+}
+
+/*
+ * Truncate the dates of a block to the start of their week, month,
+ * quarter, or year.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ * 
+ *   unit - the GRCAL_PIPE truncation unit
+ */
+static void runTruncate(PIPE_BLOCKS *pb, size_t n, int unit) {
+  
+  size_t i = 0;
+  int32_t x = 0;
+  int32_t r = 0;
+  
+  if (unit == GRCAL_PIPE_WEEK) {
+    /* Day offset zero is a Friday, four days after a Monday */
+    for(i = 0; i < n; i++) {
+      x = (pb->offs)[i];
+      r = x - ((x + 4) % 7);
+      (pb->offs)[i] = ((x >= 0) & (r >= 0)) ? r : -1;
+    }
+    return;
+  }
+  
+  toDates(pb, n);
+  for(i = 0; i < n; i++) {
+    if (unit == GRCAL_PIPE_QUARTER) {
+      (pb->m)[i] = ((((pb->m)[i] - 1) / 3) * 3) + 1;
+    } else if (unit == GRCAL_PIPE_YEAR) {
+      (pb->m)[i] = 1;
+    }
+    (pb->d)[i] = 1;
+    (pb->y)[i] = ((pb->offs)[i] < 0) ? 0 : (pb->y)[i];
+  }
+  grcal_dateToOffsetBatch(pb->y, pb->m, pb->d, n, pb->offs);
+}
+
+/*
+ * Read a block of input elements into day offsets.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ * 
+ *   format - the GRCAL_PIPE input format
+ * 
+ *   pIn - the first input element of the block
+ * 
+ *   stride - the distance in bytes between input elements
+ */
+static void loadBlock(
+          PIPE_BLOCKS   * pb,
+          size_t          n,
+          int             format,
+    const unsigned char * pIn,
+          size_t          stride) {
+  
+  size_t i = 0;
+  int32_t x = 0;
+  
+  if (format == GRCAL_PIPE_ISO) {
+    grcal_isoToOffsetBatch((const char *) pIn, stride, n, pb->offs);
+    return;
+  }
+  
+  for(i = 0; i < n; i++) {
+    memcpy(&x, pIn + (i * stride), sizeof(int32_t));
+    (pb->offs)[i] = ((x >= 0) & (x <= GRCAL_DAY_MAX)) ? x : -1;
+  }
+}
+
+/*
+ * Write a block of day offsets as output elements.
+ * 
+ * Parameters:
+ * 
+ *   pb - the block buffers
+ * 
+ *   n - the number of rows
+ * 
+ *   format - the GRCAL_PIPE output format
+ * 
+ *   pOut - the first output element of the block
+ * 
+ *   stride - the distance in bytes between output elements
+ */
+static void storeBlock(
+          PIPE_BLOCKS   * pb,
+          size_t          n,
+          int             format,
+          unsigned char * pOut,
+          size_t          stride) {
+  
+  size_t i = 0;
+  
+  if (format == GRCAL_PIPE_OFFSET) {
+    for(i = 0; i < n; i++) {
+      memcpy(pOut + (i * stride), &((pb->offs)[i]), sizeof(int32_t));
+    }
+    return;
+  }
+  
+  /* Format invalid rows as day zero, then overwrite them */
+  for(i = 0; i < n; i++) {
+    (pb->v)[i] = ((pb->offs)[i] < 0) ? 0 : (pb->offs)[i];
+  }
+  grcal_offsetToIsoBatch(pb->v, n, (char *) pOut, stride);
+  for(i = 0; i < n; i++) {
+    if ((pb->offs)[i] < 0) {
+      memcpy(pOut + (i * stride), "0000-00-00", GRCAL_ISO_LENGTH);
+    }
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_pipeInit function.
+ */
+void grcal_pipeInit(GRCAL_PIPE *pPipe) {
+  
+  if (pPipe == NULL) {
+    abort();
+  }
+  
+  pPipe->count = 0;
+}
+
+/*
+ * grcal_pipeAddDays function.
+ */
+int grcal_pipeAddDays(GRCAL_PIPE *pPipe, int32_t n) {
+  
+  if (pPipe == NULL) {
+    abort();
+  }
+  
+  if (n > MAX_DAYS) {
+    n = MAX_DAYS;
+  } else if (n < -MAX_DAYS) {
+    n = -MAX_DAYS;
+  }
+  return addStage(pPipe, STAGE_DAYS, n, NULL, NULL);
+}
+
+/*
+ * grcal_pipeAddMonths function.
+ */
+int grcal_pipeAddMonths(GRCAL_PIPE *pPipe, int32_t n) {
+  
+  if (pPipe == NULL) {
+    abort();
+  }
+  
+  if (n > MAX_MONTHS) {
+    n = MAX_MONTHS;
+  } else if (n < -MAX_MONTHS) {
+    n = -MAX_MONTHS;
+  }
+  return addStage(pPipe, STAGE_MONTHS, n, NULL, NULL);
+}
+
+/*
+ * grcal_pipeTruncate function.
+ */
+int grcal_pipeTruncate(GRCAL_PIPE *pPipe, int unit) {
+  
+  if ((pPipe == NULL) ||
+      (unit < GRCAL_PIPE_WEEK) || (unit > GRCAL_PIPE_YEAR)) {
+    abort();
+  }
+  
+  return addStage(pPipe, STAGE_TRUNCATE, unit, NULL, NULL);
+}
+
+/*
+ * grcal_pipeExpr function.
+ */
+int grcal_pipeExpr(
+          GRCAL_PIPE * pPipe,
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal) {
+  
+  if ((pPipe == NULL) || (pExpr == NULL)) {
+    abort();
+  }
+  if (grcal_exprBusiness(pExpr) && (pCal == NULL)) {
+    abort();
+  }
+  
+  return addStage(pPipe, STAGE_EXPR, 0, pExpr, pCal);
+}
+
+/*
+ * grcal_pipeRun function.
+ */
+size_t grcal_pipeRun(
+    const GRCAL_PIPE * pPipe,
+          int          inFormat,
+    const void       * pIn,
+          size_t       inStride,
+          int          outFormat,
+          void       * pOut,
+          size_t       outStride,
+          size_t       count) {
+  
+  PIPE_BLOCKS blk;
+  const GRCAL_PIPE_STAGE *ps = NULL;
+  const unsigned char *pi = NULL;
+  unsigned char *po = NULL;
+  size_t pos = 0;
+  size_t n = 0;
+  size_t i = 0;
+  size_t bad = 0;
+  int k = 0;
+  
+  /* Check parameters */
+  if (pPipe == NULL) {
+    abort();
+  }
+  if ((count > 0) && ((pIn == NULL) || (pOut == NULL))) {
+    abort();
+  }
+  if (inFormat == GRCAL_PIPE_OFFSET) {
+    if (inStride < sizeof(int32_t)) {
+      abort();
+    }
+  } else if (inFormat == GRCAL_PIPE_ISO) {
+    if (inStride < GRCAL_ISO_LENGTH) {
+      abort();
+    }
+  } else {
+    abort();
+  }
+  if (outFormat == GRCAL_PIPE_OFFSET) {
+    if (outStride < sizeof(int32_t)) {
+      abort();
+    }
+  } else if (outFormat == GRCAL_PIPE_ISO) {
+    if (outStride < GRCAL_ISO_LENGTH) {
+      abort();
+    }
+  } else {
+    abort();
+  }
+  
+  pi = (const unsigned char *) pIn;
+  po = (unsigned char *) pOut;
+  
+  for(pos = 0; pos < count; pos += n) {
+    n = count - pos;
+    if (n > PIPE_BLOCK) {
+      n = PIPE_BLOCK;
+    }
+    
+    loadBlock(&blk, n, inFormat, pi + (pos * inStride), inStride);
+    
+    /* Run every stage over the block while it is in cache */
+    for(k = 0; k < pPipe->count; k++) {
+      ps = &((pPipe->stages)[k]);
+      if (ps->kind == STAGE_DAYS) {
+        runDays(&blk, n, ps->arg);
+      } else if (ps->kind == STAGE_MONTHS) {
+        runMonths(&blk, n, ps->arg);
+      } else if (ps->kind == STAGE_TRUNCATE) {
+        runTruncate(&blk, n, (int) ps->arg);
+      } else {
+        grcal_exprApply(ps->pExpr, ps->pCal, blk.offs, n, blk.offs);
+      }
+    }
+    
+    for(i = 0; i < n; i++) {
+      bad += ((blk.offs)[i] < 0);
+    }
+    storeBlock(&blk, n, outFormat, po + (pos * outStride), outStride);
+  }
+  
+  return bad;
+}
@@ -0,0 +1,219 @@
+#ifndef GRCAL_PIPE_H_INCLUDED
+#define GRCAL_PIPE_H_INCLUDED
+
+/*
+ * grcal_pipe.h
+ * ============
+ * 
+ * Fused conversion pipelines over columns of dates.
+ * 
+ * Chaining whole-column passes, such as parsing a column of strings,
+ * then adding months to every date, then truncating every date to its
+ * week, then formatting the column again, moves every intermediate
+ * column through memory.  A pipeline instead declares the sequence of
+ * transforms once and runs every stage over one small block of rows
+ * before moving on to the next block.  The intermediates of a block
+ * stay in buffers on the stack that fit in the L1 cache, and running a
+ * pipeline never allocates memory.
+ * 
+ * A pipeline reads either day offsets or YYYY-MM-DD strings, applies
+ * its stages in order, and writes either day offsets or YYYY-MM-DD
+ * strings.  The formats are chosen when the pipeline is run, so the
+ * same pipeline can serve several kinds of column.  Input and output
+ * elements are given by a pointer to the first element and a stride in
+ * bytes, so they may also be fields inside arrays of records, as in the
+ * record functions of grcal_batch.h.
+ * 
+ * The pipeline structure is declared by the caller and filled in by
+ * the functions below.  It holds no resources, and it may be run from
+ * any number of threads at once.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_expr.h"
+#include <stddef.h>
+
+/*
+ * The maximum number of stages in a pipeline.
+ */
+#define GRCAL_PIPE_MAX_STAGES 16
+
+/*
+ * Input and output formats.
+ * 
+ * GRCAL_PIPE_OFFSET elements are int32_t day offsets, which need not be
+ * aligned.  GRCAL_PIPE_ISO elements are GRCAL_ISO_LENGTH characters in
+ * YYYY-MM-DD format with no terminating nul.
+ */
+#define GRCAL_PIPE_OFFSET 1
+#define GRCAL_PIPE_ISO    2
+
+/*
+ * Truncation units.
+ * 
+ * Weeks start on Monday.
+ */
+#define GRCAL_PIPE_WEEK    1
+#define GRCAL_PIPE_MONTH   2
+#define GRCAL_PIPE_QUARTER 3
+#define GRCAL_PIPE_YEAR    4
+
+/*
+ * One pipeline stage.
+ * 
+ * The contents are private to grcal_pipe.c.
+ */
+typedef struct {
+  int kind;
+  int32_t arg;
+  const GRCAL_EXPR *pExpr;
+  const GRCAL_BDAY *pCal;
+} GRCAL_PIPE_STAGE;
+
+/*
+ * Pipeline structure.
+ * 
+ * The contents are private to grcal_pipe.c.
+ */
+typedef struct {
+  int count;
+  GRCAL_PIPE_STAGE stages[GRCAL_PIPE_MAX_STAGES];
+} GRCAL_PIPE;
+
+/*
+ * Initialize a pipeline with no stages.
+ * 
+ * A pipeline with no stages converts between formats only.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline to initialize
+ */
+void grcal_pipeInit(GRCAL_PIPE *pPipe);
+
+/*
+ * Append a stage that moves each date by a number of days.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   n - the number of days, which may be negative
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the pipeline is full
+ */
+int grcal_pipeAddDays(GRCAL_PIPE *pPipe, int32_t n);
+
+/*
+ * Append a stage that moves each date by a number of months.
+ * 
+ * The day of the month is clamped to the length of the resulting
+ * month, so 2024-01-31 moved by one month is 2024-02-29.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   n - the number of months, which may be negative
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the pipeline is full
+ */
+int grcal_pipeAddMonths(GRCAL_PIPE *pPipe, int32_t n);
+
+/*
+ * Append a stage that truncates each date to the first day of its
+ * week, month, quarter, or year.
+ * 
+ * unit must be one of the GRCAL_PIPE truncation units, or a fault
+ * occurs.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   unit - the truncation unit
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the pipeline is full
+ */
+int grcal_pipeTruncate(GRCAL_PIPE *pPipe, int unit);
+
+/*
+ * Append a stage that applies a compiled date expression.
+ * 
+ * The expression and the calendar are not copied, so they must remain
+ * valid for as long as the pipeline is used.  pCal may only be NULL if
+ * the expression does not use business days, or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   pExpr - the compiled expression
+ * 
+ *   pCal - the business-day calendar, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the pipeline is full
+ */
+int grcal_pipeExpr(
+          GRCAL_PIPE * pPipe,
+    const GRCAL_EXPR * pExpr,
+    const GRCAL_BDAY * pCal);
+
+/*
+ * Run a pipeline over a column of dates.
+ * 
+ * inFormat and outFormat must each be one of the GRCAL_PIPE formats.
+ * The strides must be at least the size of an element in the
+ * corresponding format.  Otherwise, a fault occurs.
+ * 
+ * Input elements that are not valid day offsets or valid YYYY-MM-DD
+ * dates, and dates that leave the range of day offsets at any stage,
+ * are invalid.  Invalid elements are written as a day offset of -1, or
+ * as the string 0000-00-00.
+ * 
+ * The input and output may be the same buffer if they also have the
+ * same format and stride, in which case the column is converted in
+ * place.  Otherwise, they must not overlap.
+ * 
+ * Parameters:
+ * 
+ *   pPipe - the pipeline
+ * 
+ *   inFormat - the format of the input elements
+ * 
+ *   pIn - the first input element
+ * 
+ *   inStride - the distance in bytes between input elements
+ * 
+ *   outFormat - the format of the output elements
+ * 
+ *   pOut - the first output element
+ * 
+ *   outStride - the distance in bytes between output elements
+ * 
+ *   count - the number of elements
+ * 
+ * Return:
+ * 
+ *   the number of invalid elements
+ */
+size_t grcal_pipeRun(
+    const GRCAL_PIPE * pPipe,
+          int          inFormat,
+    const void       * pIn,
+          size_t       inStride,
+          int          outFormat,
+          void       * pOut,
+          size_t       outStride,
+          size_t       count);
+
+#endif
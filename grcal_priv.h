@@ -0,0 +1,279 @@
+#ifndef GRCAL_PRIV_H_INCLUDED
+#define GRCAL_PRIV_H_INCLUDED
+
+/*
+ * grcal_priv.h
+ * ============
+ * 
+ * Private helpers shared by the optional modules.  This header is not
+ * part of the public interface, and clients should not include it.
+ * 
+ * It holds the closed-form arithmetic that converts between day
+ * offsets and dates without walking a month table, the month length
+ * and leap year rules, and the range check for arrays of day offsets.
+ * The helpers are inline and have no branches, so that the loops that
+ * call them still vectorize.
+ * 
+ * grcal.c keeps its own table-based arithmetic, so that the core
+ * library stays a single source file, and grcal_bpf.h keeps its own
+ * copy, so that it stays usable on its own in eBPF programs.
+ * 
+ * Closed-form arithmetic
+ * ----------------------
+ * 
+ * Internally, days are counted from 1200-03-01, the start of a quad
+ * century (400 years).  Years are counted from March, so that the leap
+ * day is the last day of a year, and the months of a March-based year
+ * run from zero for March up to eleven for February.
+ * 
+ * A day count splits into whole quad centuries of GRCAL_PRIV_QC_DAYS
+ * days and the day within the quad century.  The year within the quad
+ * century is found by dividing by 365 after taking off the leap days
+ * that come before it, which are one every 1460 days, less one every
+ * 36524 days, plus one every 146096 days, so that no special cases are
+ * needed.
+ * 
+ * March-based month lengths repeat in a 153-day, five-month pattern,
+ * so the month within the year and the first day of a month are each
+ * one division by a constant.
+ */
+
+#include "grcal.h"
+#include <stddef.h>
+
+/*
+ * Force inlining, so that the loops calling these helpers vectorize.
+ */
+#ifdef __GNUC__
+#define GRCAL_PRIV_INLINE static inline __attribute__((always_inline))
+#else
+#define GRCAL_PRIV_INLINE static inline
+#endif
+
+/*
+ * The internal day count of 1582-10-15, which is day offset zero.
+ */
+#define GRCAL_PRIV_DAY_OFFSET INT32_C(139750)
+
+/*
+ * The number of days in an aligned quad century (400 years).
+ */
+#define GRCAL_PRIV_QC_DAYS INT32_C(146097)
+
+/*
+ * The year in which internal day zero happened.
+ */
+#define GRCAL_PRIV_BASE_YEAR 1200
+
+/*
+ * Split a valid day offset into March-based components.
+ * 
+ * Parameters:
+ * 
+ *   offs - the day offset, which must be valid
+ * 
+ *   pYears - receives the number of whole March-based years since
+ *   1200-03-01
+ * 
+ *   pMp - receives the month of the March-based year, zero for March
+ *   up to eleven for February
+ * 
+ *   pDoy - receives the zero-based day of the March-based year
+ */
+GRCAL_PRIV_INLINE void grcal_privMarch(
+    int32_t   offs,
+    int32_t * pYears,
+    int32_t * pMp,
+    int32_t * pDoy) {
+  
+  uint32_t z = 0;
+  uint32_t qc = 0;
+  uint32_t doe = 0;
+  uint32_t yoe = 0;
+  uint32_t doy = 0;
+  
+  z   = ((uint32_t) offs) + (uint32_t) GRCAL_PRIV_DAY_OFFSET;
+  qc  = z / (uint32_t) GRCAL_PRIV_QC_DAYS;
+  doe = z - (qc * (uint32_t) GRCAL_PRIV_QC_DAYS);
+  yoe = (doe - (doe / 1460u) + (doe / 36524u) - (doe / 146096u))
+          / 365u;
+  doy = doe - ((365u * yoe) + (yoe / 4u) - (yoe / 100u));
+  
+  *pYears = (int32_t) ((qc * 400u) + yoe);
+  *pMp = (int32_t) (((5u * doy) + 2u) / 153u);
+  *pDoy = (int32_t) doy;
+}
+
+/*
+ * Get the day offset of the first day of a March-based month.
+ * 
+ * The result is not range checked, so it is negative for months before
+ * October 1582 and greater than GRCAL_DAY_MAX after December 9999.
+ * 
+ * Parameters:
+ * 
+ *   years - the number of whole March-based years since 1200-03-01,
+ *   which must not be negative
+ * 
+ *   mp - the month of the March-based year, zero for March up to eleven
+ *   for February
+ * 
+ * Return:
+ * 
+ *   the day offset
+ */
+GRCAL_PRIV_INLINE int32_t grcal_privMarchFirst(
+    int32_t years,
+    int32_t mp) {
+  
+  uint32_t qc = 0;
+  uint32_t yoe = 0;
+  
+  qc  = ((uint32_t) years) / 400u;
+  yoe = ((uint32_t) years) - (qc * 400u);
+  
+  return (int32_t) ((qc * (uint32_t) GRCAL_PRIV_QC_DAYS) +
+                      (365u * yoe) + (yoe / 4u) - (yoe / 100u) +
+                      (((153u * (uint32_t) mp) + 2u) / 5u)) -
+            GRCAL_PRIV_DAY_OFFSET;
+}
+
+/*
+ * Split a valid day offset into the year, month, and day of month.
+ * 
+ * Parameters:
+ * 
+ *   offs - the day offset, which must be valid
+ * 
+ *   pYear - receives the year
+ * 
+ *   pMonth - receives the month, one for January
+ * 
+ *   pDay - receives the day of the month, one for the first
+ * 
+ *   pDoy - receives the zero-based day of the March-based year, as for
+ *   grcal_privMarch()
+ */
+GRCAL_PRIV_INLINE void grcal_privSplit(
+    int32_t   offs,
+    int32_t * pYear,
+    int32_t * pMonth,
+    int32_t * pDay,
+    int32_t * pDoy) {
+  
+  int32_t years = 0;
+  int32_t mp = 0;
+  int32_t doy = 0;
+  int32_t month = 0;
+  
+  grcal_privMarch(offs, &years, &mp, &doy);
+  month = (mp < 10) ? (mp + 3) : (mp - 9);
+  
+  *pYear = years + GRCAL_PRIV_BASE_YEAR + (month <= 2);
+  *pMonth = month;
+  *pDay = doy - (int32_t) (((153u * (uint32_t) mp) + 2u) / 5u) + 1;
+  *pDoy = doy;
+}
+
+/*
+ * Get the day offset of a date, without range checks.
+ * 
+ * The year must be after GRCAL_PRIV_BASE_YEAR, the month in range one
+ * to twelve, and the day at least one.  The result is not checked, so
+ * it is outside the range of day offsets for dates before 1582-10-15
+ * or after 9999-12-31.
+ * 
+ * Parameters:
+ * 
+ *   year - the year
+ * 
+ *   month - the month
+ * 
+ *   day - the day of the month
+ * 
+ * Return:
+ * 
+ *   the day offset
+ */
+GRCAL_PRIV_INLINE int32_t grcal_privCompose(
+    int32_t year,
+    int32_t month,
+    int32_t day) {
+  
+  int32_t years = 0;
+  int32_t mp = 0;
+  
+  years = year - (month <= 2) - GRCAL_PRIV_BASE_YEAR;
+  mp = (month > 2) ? (month - 3) : (month + 9);
+  
+  return grcal_privMarchFirst(years, mp) + (day - 1);
+}
+
+/*
+ * Determine whether a year is a leap year.
+ * 
+ * Parameters:
+ * 
+ *   y - the year, which must not be negative
+ * 
+ * Return:
+ * 
+ *   one if the year is a leap year, zero if not
+ */
+GRCAL_PRIV_INLINE int32_t grcal_privIsLeap(int32_t y) {
+  return ((y % 4) == 0) & (((y % 100) != 0) | ((y % 400) == 0));
+}
+
+/*
+ * Get the number of days in a month.
+ * 
+ * For months other than February, the expression gives 31 for January,
+ * March, May, July, August, October, and December, and 30 otherwise.
+ * 
+ * Parameters:
+ * 
+ *   y - the year, which must not be negative
+ * 
+ *   m - the month, in range one to twelve
+ * 
+ * Return:
+ * 
+ *   the number of days in the month
+ */
+GRCAL_PRIV_INLINE int32_t grcal_privMonthDays(int32_t y, int32_t m) {
+  return (m == 2) ? (28 + grcal_privIsLeap(y))
+                  : (30 + ((m + (m >> 3)) & 1));
+}
+
+/*
+ * Check whether any day offset in an array is out of range.
+ * 
+ * The scan does not branch, so that it vectorizes.  Callers fault or
+ * report an error when the result is non-zero, before writing any
+ * output.
+ * 
+ * Parameters:
+ * 
+ *   pOffs - the day offsets, which may be NULL if count is zero
+ * 
+ *   count - the number of day offsets
+ * 
+ * Return:
+ * 
+ *   non-zero if any day offset is out of range, zero if not
+ */
+GRCAL_PRIV_INLINE int grcal_privBadOffsets(
+    const int32_t * pOffs,
+          size_t    count) {
+  
+  size_t i = 0;
+  int bad = 0;
+  
+  for(i = 0; i < count; i++) {
+    bad |= ((pOffs[i] < 0) | (pOffs[i] > GRCAL_DAY_MAX));
+  }
+  
+  return bad;
+}
+
+#endif
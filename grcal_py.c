@@ -0,0 +1,562 @@
+/*
+ * grcal_py.c
+ * ==========
+ * 
+ * CPython extension module that runs the grcal batch conversions over
+ * whole arrays.
+ * 
+ * Calling grcal once per date through ctypes spends far more time in
+ * the call than in the conversion.  This module instead takes whole
+ * arrays as buffer-protocol objects, such as array.array, memoryview,
+ * bytearray, and NumPy arrays, and converts them with one call to the
+ * functions of grcal_batch.h.  No Python object is created per element,
+ * and the global interpreter lock is released while the conversion
+ * runs, so other threads keep running.
+ * 
+ * Functions
+ * ---------
+ * 
+ *   offset_to_date(offsets, years, months, days)
+ *   date_to_offset(years, months, days, offsets) -> invalid count
+ *   weekday(offsets, weekdays)
+ *   iso_to_offset(strings, offsets) -> invalid count
+ *   offset_to_iso(offsets, strings)
+ * 
+ * Day offsets, years, months, days, and weekdays are C-contiguous
+ * buffers of 32-bit signed integers in native byte order, such as
+ * array.array('i') or a NumPy array of dtype int32.  Outputs must be
+ * writable and allocated by the caller with the same number of
+ * elements as the inputs, and they are filled in place.  Any of the
+ * outputs of offset_to_date may be None if not required.
+ * 
+ * Strings are C-contiguous buffers of bytes that hold one YYYY-MM-DD
+ * date every ten bytes, with no separators, such as a bytearray or a
+ * NumPy array of dtype S10.
+ * 
+ * Day offsets that are out of range raise ValueError, with no output
+ * written.  Dates and strings that are not valid are converted to a day
+ * offset of -1, and the number of them is returned, as in
+ * grcal_batch.h.  Buffers of the wrong type raise TypeError, outputs
+ * that are not writable raise BufferError, and buffers of the wrong
+ * size raise ValueError.
+ * 
+ * The module also defines DAY_MAX, the greatest valid day offset, and
+ * ISO_LENGTH, the number of bytes in a date string.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Only the CPython headers are needed, and not NumPy.  Sample
+ * invocation for gcc on Linux, which builds a module named grcal in the
+ * current directory:
+ * 
+ *   gcc -O2 -shared -fPIC $(python3-config --includes) \
+ *     -o grcal$(python3-config --extension-suffix) \
+ *     grcal_py.c grcal.c grcal_batch.c
+ * 
+ * The module is not built by the Makefile, since it depends on the
+ * Python installation.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "grcal_batch.h"
+#include "grcal_priv.h"
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int isInt32(const Py_buffer *pView);
+static int getInt32(
+    PyObject   * pObj,
+    int          writable,
+    const char * pName,
+    Py_buffer  * pView);
+static int getBytes(PyObject *pObj, int writable, Py_buffer *pView);
+static size_t countOf(const Py_buffer *pView);
+static int checkCount(
+    const Py_buffer * pView,
+          size_t      count,
+    const char      * pName);
+static void releaseAll(Py_buffer *pViews, int count);
+
+static PyObject *py_offsetToDate(PyObject *pSelf, PyObject *pArgs);
+static PyObject *py_dateToOffset(PyObject *pSelf, PyObject *pArgs);
+static PyObject *py_weekday(PyObject *pSelf, PyObject *pArgs);
+static PyObject *py_isoToOffset(PyObject *pSelf, PyObject *pArgs);
+static PyObject *py_offsetToIso(PyObject *pSelf, PyObject *pArgs);
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The methods of the module.
+ */
+static PyMethodDef m_methods[] = {
+  {"offset_to_date", py_offsetToDate, METH_VARARGS,
+    "offset_to_date(offsets, years, months, days)\n\n"
+    "Convert day offsets into years, months, and days of month."},
+  {"date_to_offset", py_dateToOffset, METH_VARARGS,
+    "date_to_offset(years, months, days, offsets) -> int\n\n"
+    "Convert dates into day offsets, returning the number of invalid "
+    "dates."},
+  {"weekday", py_weekday, METH_VARARGS,
+    "weekday(offsets, weekdays)\n\n"
+    "Get the weekdays of day offsets, one for Monday up to seven for "
+    "Sunday."},
+  {"iso_to_offset", py_isoToOffset, METH_VARARGS,
+    "iso_to_offset(strings, offsets) -> int\n\n"
+    "Convert YYYY-MM-DD strings into day offsets, returning the number "
+    "of invalid strings."},
+  {"offset_to_iso", py_offsetToIso, METH_VARARGS,
+    "offset_to_iso(offsets, strings)\n\n"
+    "Convert day offsets into YYYY-MM-DD strings."},
+  {NULL, NULL, 0, NULL}
+};
+
+/*
+ * The module definition.
+ */
+static struct PyModuleDef m_module = {
+  PyModuleDef_HEAD_INIT,
+  "grcal",
+  "Gregorian calendar conversions over buffer-protocol arrays.",
+  -1,
+  m_methods,
+  NULL,
+  NULL,
+  NULL,
+  NULL
+};
+
+/*
+ * Check whether a buffer holds native 32-bit signed integers.
+ * 
+ * Parameters:
+ * 
+ *   pView - the buffer, acquired with its format
+ * 
+ * Return:
+ * 
+ *   non-zero if the buffer holds native 32-bit signed integers, zero if
+ *   not
+ */
+static int isInt32(const Py_buffer *pView) {
+  
+  const uint16_t one = 1;
+  const char *pf = NULL;
+  int little = 0;
+  
+  if ((pView->itemsize != 4) || (pView->format == NULL)) {
+    return 0;
+  }
+  little = (*((const unsigned char *) &one) == 1);
+  
+  /* Skip a byte order prefix that matches the native order; the
+   * standard sizes of i and l are both four bytes */
+  pf = pView->format;
+  if ((*pf == '@') || (*pf == '=') ||
+      ((*pf == '<') && little) ||
+      (((*pf == '>') || (*pf == '!')) && (!little))) {
+    pf++;
+  }
+  
+  return ((strcmp(pf, "i") == 0) || (strcmp(pf, "l") == 0));
+}
+
+/*
+ * Acquire a buffer of 32-bit signed integers.
+ * 
+ * Parameters:
+ * 
+ *   pObj - the object that exports the buffer
+ * 
+ *   writable - non-zero if the buffer will be written
+ * 
+ *   pName - the name of the argument, for error messages
+ * 
+ *   pView - the view to fill in
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero with an exception set if not
+ */
+static int getInt32(
+    PyObject   * pObj,
+    int          writable,
+    const char * pName,
+    Py_buffer  * pView) {
+  
+  int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;
+  
+  if (writable) {
+    flags |= PyBUF_WRITABLE;
+  }
+  if (PyObject_GetBuffer(pObj, pView, flags) != 0) {
+    return 0;
+  }
+  if (!isInt32(pView)) {
+    PyBuffer_Release(pView);
+    PyErr_Format(PyExc_TypeError,
+      "%s must be a contiguous buffer of int32", pName);
+    return 0;
+  }
+  
+  return 1;
+}
+
+/*
+ * Acquire a buffer of bytes.
+ * 
+ * Parameters:
+ * 
+ *   pObj - the object that exports the buffer
+ * 
+ *   writable - non-zero if the buffer will be written
+ * 
+ *   pView - the view to fill in
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero with an exception set if not
+ */
+static int getBytes(PyObject *pObj, int writable, Py_buffer *pView) {
+  
+  int flags = PyBUF_C_CONTIGUOUS;
+  
+  if (writable) {
+    flags |= PyBUF_WRITABLE;
+  }
+  return (PyObject_GetBuffer(pObj, pView, flags) == 0);
+}
+
+/*
+ * Get the number of 32-bit elements in a buffer.
+ * 
+ * Parameters:
+ * 
+ *   pView - the buffer
+ * 
+ * Return:
+ * 
+ *   the number of elements
+ */
+static size_t countOf(const Py_buffer *pView) {
+  return ((size_t) pView->len) / 4;
+}
+
+/*
+ * Check that a buffer of 32-bit elements has a given number of them.
+ * 
+ * Parameters:
+ * 
+ *   pView - the buffer
+ * 
+ *   count - the required number of elements
+ * 
+ *   pName - the name of the argument, for error messages
+ * 
+ * Return:
+ * 
+ *   non-zero if so, zero with an exception set if not
+ */
+static int checkCount(
+    const Py_buffer * pView,
+          size_t      count,
+    const char      * pName) {
+  
+  if (countOf(pView) != count) {
+    PyErr_Format(PyExc_ValueError,
+      "%s must have %zu elements", pName, count);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * Release an array of buffer views.
+ * 
+ * Views that were never acquired must be zero-filled.
+ * 
+ * Parameters:
+ * 
+ *   pViews - the views
+ * 
+ *   count - the number of views
+ */
+static void releaseAll(Py_buffer *pViews, int count) {
+  
+  int i = 0;
+  
+  for(i = 0; i < count; i++) {
+    if (pViews[i].obj != NULL) {
+      PyBuffer_Release(&(pViews[i]));
+    }
+  }
+}
+
+/*
+ * offset_to_date(offsets, years, months, days)
+ */
+static PyObject *py_offsetToDate(PyObject *pSelf, PyObject *pArgs) {
+  
+  static const char *names[4] = {"offsets", "years", "months", "days"};
+  PyObject *pObj[4] = {NULL, NULL, NULL, NULL};
+  Py_buffer views[4];
+  int32_t *pOut[3] = {NULL, NULL, NULL};
+  size_t count = 0;
+  int bad = 0;
+  int i = 0;
+  
+  (void) pSelf;
+  memset(views, 0, sizeof(views));
+  
+  if (!PyArg_ParseTuple(pArgs, "OOOO:offset_to_date",
+          &(pObj[0]), &(pObj[1]), &(pObj[2]), &(pObj[3]))) {
+    return NULL;
+  }
+  
+  if (!getInt32(pObj[0], 0, names[0], &(views[0]))) {
+    return NULL;
+  }
+  count = countOf(&(views[0]));
+  
+  for(i = 1; i < 4; i++) {
+    if (pObj[i] == Py_None) {
+      continue;
+    }
+    if ((!getInt32(pObj[i], 1, names[i], &(views[i]))) ||
+        (!checkCount(&(views[i]), count, names[i]))) {
+      releaseAll(views, 4);
+      return NULL;
+    }
+    pOut[i - 1] = (int32_t *) views[i].buf;
+  }
+  
+  Py_BEGIN_ALLOW_THREADS
+  bad = grcal_privBadOffsets((const int32_t *) views[0].buf, count);
+  if (!bad) {
+    grcal_offsetToDateBatch((const int32_t *) views[0].buf, count,
+      pOut[0], pOut[1], pOut[2]);
+  }
+  Py_END_ALLOW_THREADS
+  
+  releaseAll(views, 4);
+  if (bad) {
+    PyErr_SetString(PyExc_ValueError, "day offset out of range");
+    return NULL;
+  }
+  
+  Py_RETURN_NONE;
+}
+
+/*
+ * date_to_offset(years, months, days, offsets) -> invalid count
+ */
+static PyObject *py_dateToOffset(PyObject *pSelf, PyObject *pArgs) {
+  
+  static const char *names[4] = {"years", "months", "days", "offsets"};
+  PyObject *pObj[4] = {NULL, NULL, NULL, NULL};
+  Py_buffer views[4];
+  size_t count = 0;
+  size_t invalid = 0;
+  int i = 0;
+  
+  (void) pSelf;
+  memset(views, 0, sizeof(views));
+  
+  if (!PyArg_ParseTuple(pArgs, "OOOO:date_to_offset",
+          &(pObj[0]), &(pObj[1]), &(pObj[2]), &(pObj[3]))) {
+    return NULL;
+  }
+  
+  for(i = 0; i < 4; i++) {
+    if (!getInt32(pObj[i], (i == 3), names[i], &(views[i]))) {
+      releaseAll(views, 4);
+      return NULL;
+    }
+    if (i == 0) {
+      count = countOf(&(views[0]));
+    } else if (!checkCount(&(views[i]), count, names[i])) {
+      releaseAll(views, 4);
+      return NULL;
+    }
+  }
+  
+  Py_BEGIN_ALLOW_THREADS
+  invalid = grcal_dateToOffsetBatch(
+      (const int32_t *) views[0].buf,
+      (const int32_t *) views[1].buf,
+      (const int32_t *) views[2].buf,
+      count,
+      (int32_t *) views[3].buf);
+  Py_END_ALLOW_THREADS
+  
+  releaseAll(views, 4);
+  return PyLong_FromSize_t(invalid);
+}
+
+/*
+ * weekday(offsets, weekdays)
+ */
+static PyObject *py_weekday(PyObject *pSelf, PyObject *pArgs) {
+  
+  PyObject *pOffs = NULL;
+  PyObject *pDays = NULL;
+  Py_buffer views[2];
+  size_t count = 0;
+  int bad = 0;
+  
+  (void) pSelf;
+  memset(views, 0, sizeof(views));
+  
+  if (!PyArg_ParseTuple(pArgs, "OO:weekday", &pOffs, &pDays)) {
+    return NULL;
+  }
+  if ((!getInt32(pOffs, 0, "offsets", &(views[0]))) ||
+      (!getInt32(pDays, 1, "weekdays", &(views[1])))) {
+    releaseAll(views, 2);
+    return NULL;
+  }
+  count = countOf(&(views[0]));
+  if (!checkCount(&(views[1]), count, "weekdays")) {
+    releaseAll(views, 2);
+    return NULL;
+  }
+  
+  Py_BEGIN_ALLOW_THREADS
+  bad = grcal_privBadOffsets((const int32_t *) views[0].buf, count);
+  if (!bad) {
+    grcal_weekdayBatch((const int32_t *) views[0].buf, count,
+      (int32_t *) views[1].buf);
+  }
+  Py_END_ALLOW_THREADS
+  
+  releaseAll(views, 2);
+  if (bad) {
+    PyErr_SetString(PyExc_ValueError, "day offset out of range");
+    return NULL;
+  }
+  
+  Py_RETURN_NONE;
+}
+
+/*
+ * iso_to_offset(strings, offsets) -> invalid count
+ */
+static PyObject *py_isoToOffset(PyObject *pSelf, PyObject *pArgs) {
+  
+  PyObject *pStrs = NULL;
+  PyObject *pOffs = NULL;
+  Py_buffer views[2];
+  size_t count = 0;
+  size_t invalid = 0;
+  
+  (void) pSelf;
+  memset(views, 0, sizeof(views));
+  
+  if (!PyArg_ParseTuple(pArgs, "OO:iso_to_offset", &pStrs, &pOffs)) {
+    return NULL;
+  }
+  if ((!getBytes(pStrs, 0, &(views[0]))) ||
+      (!getInt32(pOffs, 1, "offsets", &(views[1])))) {
+    releaseAll(views, 2);
+    return NULL;
+  }
+  count = countOf(&(views[1]));
+  if ((size_t) views[0].len != count * GRCAL_ISO_LENGTH) {
+    releaseAll(views, 2);
+    PyErr_Format(PyExc_ValueError,
+      "strings must have %zu bytes", count * GRCAL_ISO_LENGTH);
+    return NULL;
+  }
+  
+  Py_BEGIN_ALLOW_THREADS
+  invalid = grcal_isoToOffsetBatch((const char *) views[0].buf,
+      GRCAL_ISO_LENGTH, count, (int32_t *) views[1].buf);
+  Py_END_ALLOW_THREADS
+  
+  releaseAll(views, 2);
+  return PyLong_FromSize_t(invalid);
+}
+
+/*
+ * offset_to_iso(offsets, strings)
+ */
+static PyObject *py_offsetToIso(PyObject *pSelf, PyObject *pArgs) {
+  
+  PyObject *pOffs = NULL;
+  PyObject *pStrs = NULL;
+  Py_buffer views[2];
+  size_t count = 0;
+  int bad = 0;
+  
+  (void) pSelf;
+  memset(views, 0, sizeof(views));
+  
+  if (!PyArg_ParseTuple(pArgs, "OO:offset_to_iso", &pOffs, &pStrs)) {
+    return NULL;
+  }
+  if ((!getInt32(pOffs, 0, "offsets", &(views[0]))) ||
+      (!getBytes(pStrs, 1, &(views[1])))) {
+    releaseAll(views, 2);
+    return NULL;
+  }
+  count = countOf(&(views[0]));
+  if ((size_t) views[1].len != count * GRCAL_ISO_LENGTH) {
+    releaseAll(views, 2);
+    PyErr_Format(PyExc_ValueError,
+      "strings must have %zu bytes", count * GRCAL_ISO_LENGTH);
+    return NULL;
+  }
+  
+  Py_BEGIN_ALLOW_THREADS
+  bad = grcal_privBadOffsets((const int32_t *) views[0].buf, count);
+  if (!bad) {
+    grcal_offsetToIsoBatch((const int32_t *) views[0].buf, count,
+      (char *) views[1].buf, GRCAL_ISO_LENGTH);
+  }
+  Py_END_ALLOW_THREADS
+  
+  releaseAll(views, 2);
+  if (bad) {
+    PyErr_SetString(PyExc_ValueError, "day offset out of range");
+    return NULL;
+  }
+  
+  Py_RETURN_NONE;
+}
+
+/*
+ * Module initialization
+ * =====================
+ */
+
+PyMODINIT_FUNC PyInit_grcal(void) {
+  
+  PyObject *pModule = NULL;
+  
+  pModule = PyModule_Create(&m_module);
+  if (pModule == NULL) {
+    return NULL;
+  }
+  
+  if ((PyModule_AddIntConstant(pModule, "DAY_MAX",
+          (long) GRCAL_DAY_MAX) != 0) ||
+      (PyModule_AddIntConstant(pModule, "ISO_LENGTH",
+          (long) GRCAL_ISO_LENGTH) != 0)) {
+    Py_DECREF(pModule);
+    return NULL;
+  }
+  
+  return pModule;
+}
@@ -10,6 +10,7 @@
  * 
  *   grcal_query [offset]
  *   grcal_query [year] [month] [day]
+ *   grcal_query -json [field] [mode]
  * 
  * Operation
  * ---------
@@ -21,6 +22,24 @@
  * The three-argument invocation takes a year, month, day in the
  * Gregorian calendar and reports the day offset.
  * 
+ * The -json invocation reads newline-delimited JSON from standard input
+ * and writes it to standard output, converting the value of the named
+ * field of each top-level object in place.  The mode is one of:
+ * 
+ *   offset - "YYYY-MM-DD" string to day offset
+ *   date   - day offset to "YYYY-MM-DD" string
+ *   unix   - "YYYY-MM-DD" string to Unix time of midnight UTC
+ * 
+ * Lines where the field is missing or its value can not be converted
+ * are passed through unchanged, and a count of them is reported to
+ * standard error at the end.  Everything other than the field value is
+ * copied byte for byte.
+ * 
+ * On Linux, the -json invocation streams through io_uring when the
+ * kernel allows it, so that reading the next chunk of input and
+ * writing the output of the previous chunk overlap with conversion.
+ * Otherwise, it falls back to blocking reads and writes.
+ * 
  * Successful results are reported to standard output.  Errors are
  * reported to standard error.
  * 
@@ -30,15 +49,46 @@
  * Must be built with the grcal library.  Sample invocation for gcc:
  * 
  *   gcc -o grcal_query grcal_query.c grcal.c
+ * 
+ * The io_uring backend is compiled in when building for Linux with gcc
+ * or clang and <linux/io_uring.h> is available.  It needs no liburing.
+ * Define QUERY_NO_URING to leave it out.
+ * 
+ * The Makefile also builds this program, along with static, shared,
+ * LTO, and profile-guided variants of the library.
  */
 
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "grcal.h"
 
+/*
+ * QUERY_URING is defined if the io_uring backend is compiled in.
+ */
+#if defined(__linux__) && defined(__GNUC__) && !defined(QUERY_NO_URING)
+#ifdef __has_include
+#if __has_include(<linux/io_uring.h>)
+#define QUERY_URING
+#endif
+#endif
+#endif
+
+#ifdef QUERY_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 /*
  * Constants
  * =========
@@ -58,6 +108,146 @@ static char *DAY_NAMES[7] = {
   "Sun"
 };
 
+/*
+ * The field conversion modes of the -json invocation.
+ */
+#define JSON_OFFSET 1
+#define JSON_DATE   2
+#define JSON_UNIX   3
+
+/*
+ * The size in bytes of the input chunks of the -json invocation.
+ * 
+ * Lines may be longer than a chunk.  Output buffers start at this size
+ * and grow as needed.
+ */
+#define JSON_CHUNK 262144
+
+/*
+ * The number of input chunks and output buffers the io_uring backend
+ * rotates through, and the number of entries in its rings.
+ */
+#define URING_IN_SLOTS 3
+#define URING_OUT_SLOTS 3
+#define URING_ENTRIES 8
+
+/*
+ * The tags that identify io_uring completions.
+ */
+#define URING_TAG_READ 1
+#define URING_TAG_WRITE 2
+
+/*
+ * The number of characters in a YYYY-MM-DD date.
+ */
+#define ISO_LENGTH 10
+
+/*
+ * The number of seconds in a day.
+ */
+#define DAY_SECONDS 86400
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A growable output buffer.
+ */
+typedef struct {
+  
+  /*
+   * The buffered bytes, or NULL if nothing has been allocated yet.
+   */
+  char *pData;
+  
+  /*
+   * The number of bytes buffered.
+   */
+  size_t len;
+  
+  /*
+   * The number of bytes allocated.
+   */
+  size_t cap;
+  
+} OUTBUF;
+
+/*
+ * State of the -json conversion that carries across input chunks.
+ */
+typedef struct {
+  
+  /*
+   * The name of the field to convert.
+   */
+  const char *pField;
+  
+  /*
+   * The conversion mode, one of the JSON constants.
+   */
+  int mode;
+  
+  /*
+   * The number of lines passed through unconverted.
+   */
+  long skipped;
+  
+  /*
+   * A partial line from the end of the previous chunk, with its length
+   * and allocated size.  The allocated size is always greater than the
+   * length, so there is room for a terminating nul.
+   */
+  char *pCarry;
+  size_t carryLen;
+  size_t carryCap;
+  
+} JSON_STATE;
+
+#ifdef QUERY_URING
+
+/*
+ * A raw io_uring instance with its rings mapped.
+ */
+typedef struct {
+  
+  /*
+   * The io_uring file descriptor.
+   */
+  int fd;
+  
+  /*
+   * The ring mappings and their sizes.  The completion ring mapping
+   * size is zero if it shares the submission ring mapping.
+   */
+  void *pSqMap;
+  size_t sqMapSize;
+  void *pCqMap;
+  size_t cqMapSize;
+  struct io_uring_sqe *pSqes;
+  size_t sqeSize;
+  
+  /*
+   * Pointers to the ring fields within the mappings.
+   */
+  unsigned *pSqTail;
+  unsigned *pSqMask;
+  unsigned *pSqArray;
+  unsigned *pCqHead;
+  unsigned *pCqTail;
+  unsigned *pCqMask;
+  struct io_uring_cqe *pCqes;
+  
+  /*
+   * The number of queued entries not yet submitted to the kernel.
+   */
+  unsigned queued;
+  
+} URING;
+
+#endif
+
 /*
  * Local functions
  * ===============
@@ -65,6 +255,48 @@ static char *DAY_NAMES[7] = {
 
 /* Prototypes */
 static int parseInt(const char *pstr, int32_t *pv);
+static int parseIsoDate(const char *pc, size_t len, int32_t *pOffs);
+static const char *skipString(const char *pc, const char *pEnd);
+static int findField(
+    const char   * pLine,
+          size_t   len,
+    const char   * pField,
+          size_t * pStart,
+          size_t * pEnd);
+static int outAppend(OUTBUF *pOut, const char *pc, size_t n);
+static int jsonLine(
+          JSON_STATE * ps,
+    const char       * pLine,
+          size_t       len,
+          OUTBUF     * pOut);
+static int jsonFeed(
+    JSON_STATE * ps,
+    char       * pChunk,
+    size_t       len,
+    OUTBUF     * pOut);
+static int jsonFinish(JSON_STATE *ps, OUTBUF *pOut);
+static int streamBlocking(JSON_STATE *ps, const char *pModule);
+#ifdef QUERY_URING
+static int uringOpen(URING *pr);
+static void uringClose(URING *pr);
+static void uringQueue(
+    URING    * pr,
+    int        op,
+    int        fd,
+    void     * pBuf,
+    size_t     len,
+    uint64_t   tag);
+static int uringEnter(URING *pr, int wait);
+static int uringReap(URING *pr, uint64_t *pTag, int32_t *pRes);
+static int streamUring(
+          JSON_STATE * ps,
+    const char       * pModule,
+          int        * pStatus);
+#endif
+static int runJson(
+    const char * pModule,
+    const char * pField,
+    const char * pMode);
 
 /*
  * Parse the given string as a signed integer.
@@ -169,6 +401,1038 @@ static int parseInt(const char *pstr, int32_t *pv) {
   return status;
 }
 
+/*
+ * Parse a date in YYYY-MM-DD format and convert it to a day offset.
+ * 
+ * Parameters:
+ * 
+ *   pc - the date characters, which need not be nul-terminated
+ * 
+ *   len - the number of date characters
+ * 
+ *   pOffs - pointer to the variable to receive the day offset
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if not a valid date
+ */
+static int parseIsoDate(const char *pc, size_t len, int32_t *pOffs) {
+  
+  int v[3];
+  int field = 0;
+  size_t i = 0;
+  
+  /* Check length */
+  if (len != ISO_LENGTH) {
+    return 0;
+  }
+  
+  /* Parse the three digit groups, which are separated by hyphens at
+   * positions four and seven */
+  v[0] = 0;
+  v[1] = 0;
+  v[2] = 0;
+  for(i = 0; i < ISO_LENGTH; i++) {
+    if ((i == 4) || (i == 7)) {
+      if (pc[i] != '-') {
+        return 0;
+      }
+      field++;
+      
+    } else if ((pc[i] >= '0') && (pc[i] <= '9')) {
+      v[field] = (v[field] * 10) + (pc[i] - '0');
+      
+    } else {
+      return 0;
+    }
+  }
+  
+  /* Convert to day offset */
+  return grcal_dateToOffset(pOffs, v[0], v[1], v[2]);
+}
+
+/*
+ * Find the end of a JSON string.
+ * 
+ * The closing quote is located with memchr(), which the C library
+ * implements with vector instructions on most platforms, so the
+ * contents of long strings are skipped quickly.  Quotes that are
+ * escaped by an odd number of backslashes are skipped.
+ * 
+ * Parameters:
+ * 
+ *   pc - pointer to the first character after the opening quote
+ * 
+ *   pEnd - pointer to the end of the line
+ * 
+ * Return:
+ * 
+ *   pointer to the closing quote, or NULL if the string is not closed
+ */
+static const char *skipString(const char *pc, const char *pEnd) {
+  
+  const char *pq = NULL;
+  const char *pb = NULL;
+  
+  for(;;) {
+    pq = (const char *) memchr(pc, '"', (size_t) (pEnd - pc));
+    if (pq == NULL) {
+      return NULL;
+    }
+    
+    /* Count the backslashes before the quote */
+    pb = pq;
+    while ((pb > pc) && (pb[-1] == '\\')) {
+      pb--;
+    }
+    if (((pq - pb) % 2) == 0) {
+      return pq;
+    }
+    
+    pc = pq + 1;
+  }
+}
+
+/*
+ * Locate the value of a named field of the top-level JSON object on a
+ * line.
+ * 
+ * Only structural characters are examined: strings are skipped with
+ * skipString(), and the gaps between strings are scanned with
+ * strcspn() for quotes and brackets, so the line is never parsed into
+ * a document tree.  Field names are compared byte by byte without
+ * decoding escapes.
+ * 
+ * The line must be followed by a nul character.
+ * 
+ * Parameters:
+ * 
+ *   pLine - the line
+ * 
+ *   len - the length of the line
+ * 
+ *   pField - the field name
+ * 
+ *   pStart - pointer to the variable to receive the index of the first
+ *   character of the value
+ * 
+ *   pEnd - pointer to the variable to receive the index one past the
+ *   last character of the value
+ * 
+ * Return:
+ * 
+ *   non-zero if the field was found, zero if not
+ */
+static int findField(
+    const char   * pLine,
+          size_t   len,
+    const char   * pField,
+          size_t * pStart,
+          size_t * pEnd) {
+  
+  const char *pc = NULL;
+  const char *pLimit = NULL;
+  const char *pq = NULL;
+  const char *pv = NULL;
+  size_t flen = 0;
+  int depth = 0;
+  
+  pc = pLine;
+  pLimit = pLine + len;
+  flen = strlen(pField);
+  
+  while (pc < pLimit) {
+    /* Skip to the next structural character */
+    pc += strcspn(pc, "\"{}[]");
+    if ((pc >= pLimit) || (*pc == 0)) {
+      break;
+    }
+    
+    /* Track nesting depth */
+    if ((*pc == '{') || (*pc == '[')) {
+      depth++;
+      pc++;
+      continue;
+      
+    } else if ((*pc == '}') || (*pc == ']')) {
+      depth--;
+      pc++;
+      continue;
+    }
+    
+    /* We have a string -- find where it ends */
+    pq = skipString(pc + 1, pLimit);
+    if (pq == NULL) {
+      break;
+    }
+    
+    /* If this is at the top level of the object and matches the field
+     * name, check whether it is followed by a colon, which makes it a
+     * key rather than a value */
+    if ((depth == 1) && ((size_t) (pq - pc - 1) == flen) &&
+        (memcmp(pc + 1, pField, flen) == 0)) {
+      
+      pv = pq + 1;
+      pv += strspn(pv, " \t\r");
+      if (*pv == ':') {
+        pv++;
+        pv += strspn(pv, " \t\r");
+        
+        /* The value is either a string or a bare token */
+        *pStart = (size_t) (pv - pLine);
+        if (*pv == '"') {
+          pq = skipString(pv + 1, pLimit);
+          if (pq == NULL) {
+            return 0;
+          }
+          *pEnd = (size_t) (pq + 1 - pLine);
+          
+        } else {
+          *pEnd = *pStart + strcspn(pv, ",}] \t\r");
+        }
+        return 1;
+      }
+    }
+    
+    pc = pq + 1;
+  }
+  
+  return 0;
+}
+
+/*
+ * Append bytes to an output buffer, growing it as needed.
+ * 
+ * Parameters:
+ * 
+ *   pOut - the output buffer
+ * 
+ *   pc - the bytes to append
+ * 
+ *   n - the number of bytes to append
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of memory
+ */
+static int outAppend(OUTBUF *pOut, const char *pc, size_t n) {
+  
+  size_t cap = 0;
+  char *pNew = NULL;
+  
+  if (n > pOut->cap - pOut->len) {
+    cap = (pOut->cap > 0) ? pOut->cap : JSON_CHUNK;
+    while (cap - pOut->len < n) {
+      cap *= 2;
+    }
+    pNew = (char *) realloc(pOut->pData, cap);
+    if (pNew == NULL) {
+      return 0;
+    }
+    pOut->pData = pNew;
+    pOut->cap = cap;
+  }
+  
+  memcpy(pOut->pData + pOut->len, pc, n);
+  pOut->len += n;
+  return 1;
+}
+
+/*
+ * Convert the named field of one line of newline-delimited JSON and
+ * append the line and a line break to an output buffer.
+ * 
+ * The line must be followed by a nul character.  If the field is
+ * missing or its value can not be converted, the line is appended
+ * unchanged and the count of skipped lines is incremented.
+ * 
+ * Parameters:
+ * 
+ *   ps - the conversion state
+ * 
+ *   pLine - the line, without the line break
+ * 
+ *   len - the length of the line
+ * 
+ *   pOut - the output buffer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of memory
+ */
+static int jsonLine(
+          JSON_STATE * ps,
+    const char       * pLine,
+          size_t       len,
+          OUTBUF     * pOut) {
+  
+  size_t vs = 0;
+  size_t ve = 0;
+  int32_t offs = 0;
+  int status = 1;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  char tok[32];
+  
+  /* Find the field value */
+  if (!findField(pLine, len, ps->pField, &vs, &ve)) {
+    status = 0;
+  }
+  
+  /* Get the day offset */
+  if (status) {
+    if (ps->mode == JSON_DATE) {
+      /* Value must be a bare integer */
+      if ((ve - vs < 1) || (ve - vs >= sizeof(tok))) {
+        status = 0;
+      }
+      if (status) {
+        memcpy(tok, pLine + vs, ve - vs);
+        tok[ve - vs] = 0;
+        if (!parseInt(tok, &offs)) {
+          status = 0;
+        }
+      }
+      if (status) {
+        if ((offs < 0) || (offs > GRCAL_DAY_MAX)) {
+          status = 0;
+        }
+      }
+      
+    } else {
+      /* Value must be a quoted date string */
+      if ((ve - vs != ISO_LENGTH + 2) || (pLine[vs] != '"')) {
+        status = 0;
+      }
+      if (status) {
+        if (!parseIsoDate(pLine + vs + 1, ISO_LENGTH, &offs)) {
+          status = 0;
+        }
+      }
+    }
+  }
+  
+  /* If conversion failed, pass the line through */
+  if (!status) {
+    ps->skipped++;
+    return outAppend(pOut, pLine, len) && outAppend(pOut, "\n", 1);
+  }
+  
+  /* Format the replacement value */
+  if (ps->mode == JSON_OFFSET) {
+    sprintf(tok, "%ld", (long) offs);
+    
+  } else if (ps->mode == JSON_UNIX) {
+    sprintf(tok, "%lld",
+      ((long long) (offs - GRCAL_DAY_UNIX)) * (long long) DAY_SECONDS);
+    
+  } else {
+    grcal_offsetToDate(offs, &y, &m, &d);
+    sprintf(tok, "\"%04d-%02d-%02d\"", y, m, d);
+  }
+  
+  /* Append the line with the value replaced */
+  return outAppend(pOut, pLine, vs) &&
+          outAppend(pOut, tok, strlen(tok)) &&
+          outAppend(pOut, pLine + ve, len - ve) &&
+          outAppend(pOut, "\n", 1);
+}
+
+/*
+ * Convert a chunk of newline-delimited JSON input.
+ * 
+ * Chunks may split lines anywhere.  A partial line at the end of the
+ * chunk is held in the conversion state until the rest of it arrives.
+ * The chunk is modified in place and must have one writable byte after
+ * its end, so that lines can be nul-terminated without copying.
+ * 
+ * Parameters:
+ * 
+ *   ps - the conversion state
+ * 
+ *   pChunk - the input chunk
+ * 
+ *   len - the number of bytes in the chunk
+ * 
+ *   pOut - the output buffer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of memory
+ */
+static int jsonFeed(
+    JSON_STATE * ps,
+    char       * pChunk,
+    size_t       len,
+    OUTBUF     * pOut) {
+  
+  char *pNl = NULL;
+  char *pNew = NULL;
+  size_t start = 0;
+  size_t n = 0;
+  size_t cap = 0;
+  
+  /* Complete a line that was split from the previous chunk */
+  if (ps->carryLen > 0) {
+    pNl = (char *) memchr(pChunk, '\n', len);
+    n = (pNl != NULL) ? (size_t) (pNl - pChunk) : len;
+    
+    if (n >= ps->carryCap - ps->carryLen) {
+      cap = ps->carryCap;
+      while (n >= cap - ps->carryLen) {
+        cap *= 2;
+      }
+      pNew = (char *) realloc(ps->pCarry, cap);
+      if (pNew == NULL) {
+        return 0;
+      }
+      ps->pCarry = pNew;
+      ps->carryCap = cap;
+    }
+    memcpy(ps->pCarry + ps->carryLen, pChunk, n);
+    ps->carryLen += n;
+    
+    if (pNl == NULL) {
+      return 1;
+    }
+    ps->pCarry[ps->carryLen] = 0;
+    if (!jsonLine(ps, ps->pCarry, ps->carryLen, pOut)) {
+      return 0;
+    }
+    ps->carryLen = 0;
+    start = n + 1;
+  }
+  
+  /* Convert each complete line in place */
+  for(;;) {
+    pNl = (char *) memchr(pChunk + start, '\n', len - start);
+    if (pNl == NULL) {
+      break;
+    }
+    *pNl = 0;
+    if (!jsonLine(ps, pChunk + start,
+                  (size_t) (pNl - (pChunk + start)), pOut)) {
+      return 0;
+    }
+    start = (size_t) (pNl + 1 - pChunk);
+  }
+  
+  /* Hold on to a partial line at the end of the chunk */
+  if (start < len) {
+    n = len - start;
+    if (n >= ps->carryCap) {
+      cap = (ps->carryCap > 0) ? ps->carryCap : JSON_CHUNK;
+      while (n >= cap) {
+        cap *= 2;
+      }
+      pNew = (char *) realloc(ps->pCarry, cap);
+      if (pNew == NULL) {
+        return 0;
+      }
+      ps->pCarry = pNew;
+      ps->carryCap = cap;
+    }
+    memcpy(ps->pCarry, pChunk + start, n);
+    ps->carryLen = n;
+  }
+  
+  return 1;
+}
+
+/*
+ * Convert a final line of input that had no line break.
+ * 
+ * As with the rest of the input, no line break is added.
+ * 
+ * Parameters:
+ * 
+ *   ps - the conversion state
+ * 
+ *   pOut - the output buffer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of memory
+ */
+static int jsonFinish(JSON_STATE *ps, OUTBUF *pOut) {
+  
+  int status = 1;
+  
+  if (ps->carryLen > 0) {
+    ps->pCarry[ps->carryLen] = 0;
+    status = jsonLine(ps, ps->pCarry, ps->carryLen, pOut);
+    if (status) {
+      pOut->len--;
+    }
+    ps->carryLen = 0;
+  }
+  
+  return status;
+}
+
+/*
+ * Stream standard input to standard output with blocking stdio calls.
+ * 
+ * Parameters:
+ * 
+ *   ps - the conversion state
+ * 
+ *   pModule - the module name for error messages
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if an error occurred
+ */
+static int streamBlocking(JSON_STATE *ps, const char *pModule) {
+  
+  int status = 1;
+  char *pChunk = NULL;
+  OUTBUF out;
+  size_t n = 0;
+  
+  memset(&out, 0, sizeof(OUTBUF));
+  
+  /* Allocate the input chunk, with room for a terminating nul */
+  pChunk = (char *) malloc(JSON_CHUNK + 1);
+  if (pChunk == NULL) {
+    fprintf(stderr, "%s: Out of memory!\n", pModule);
+    status = 0;
+  }
+  
+  /* Convert each chunk and write out the results */
+  while (status) {
+    n = fread(pChunk, 1, JSON_CHUNK, stdin);
+    if (n > 0) {
+      if (!jsonFeed(ps, pChunk, n, &out)) {
+        fprintf(stderr, "%s: Out of memory!\n", pModule);
+        status = 0;
+        break;
+      }
+      fwrite(out.pData, 1, out.len, stdout);
+      out.len = 0;
+    }
+    if (n < JSON_CHUNK) {
+      if (ferror(stdin)) {
+        fprintf(stderr, "%s: Read error!\n", pModule);
+        status = 0;
+      }
+      break;
+    }
+  }
+  
+  /* Convert a final line without a line break */
+  if (status) {
+    if (!jsonFinish(ps, &out)) {
+      fprintf(stderr, "%s: Out of memory!\n", pModule);
+      status = 0;
+    }
+  }
+  if (status && (out.len > 0)) {
+    fwrite(out.pData, 1, out.len, stdout);
+  }
+  
+  /* Check for write errors */
+  if (status) {
+    if (fflush(stdout) || ferror(stdout)) {
+      fprintf(stderr, "%s: Write error!\n", pModule);
+      status = 0;
+    }
+  }
+  
+  free(pChunk);
+  free(out.pData);
+  return status;
+}
+
+#ifdef QUERY_URING
+
+/*
+ * Set up an io_uring instance and map its rings.
+ * 
+ * The kernel must support reads and writes at the current file
+ * position, which also guarantees support for the read and write
+ * operations used here.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring structure to initialize
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if io_uring is not available
+ */
+static int uringOpen(URING *pr) {
+  
+  struct io_uring_params p;
+  unsigned char *pSq = NULL;
+  unsigned char *pCq = NULL;
+  long fd = 0;
+  
+  memset(pr, 0, sizeof(URING));
+  memset(&p, 0, sizeof(p));
+  
+  /* Create the instance */
+  fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+  if (fd < 0) {
+    return 0;
+  }
+  pr->fd = (int) fd;
+  
+  if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+    close(pr->fd);
+    return 0;
+  }
+  
+  /* Map the submission and completion rings, which share one mapping
+   * on kernels that support it */
+  pr->sqMapSize = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+  pr->cqMapSize = p.cq_off.cqes +
+                    (p.cq_entries * sizeof(struct io_uring_cqe));
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (pr->cqMapSize > pr->sqMapSize) {
+      pr->sqMapSize = pr->cqMapSize;
+    }
+    pr->cqMapSize = 0;
+  }
+  
+  pr->pSqMap = mmap(NULL, pr->sqMapSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, pr->fd, IORING_OFF_SQ_RING);
+  if (pr->pSqMap == MAP_FAILED) {
+    close(pr->fd);
+    return 0;
+  }
+  pSq = (unsigned char *) pr->pSqMap;
+  
+  if (pr->cqMapSize > 0) {
+    pr->pCqMap = mmap(NULL, pr->cqMapSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, pr->fd, IORING_OFF_CQ_RING);
+    if (pr->pCqMap == MAP_FAILED) {
+      munmap(pr->pSqMap, pr->sqMapSize);
+      close(pr->fd);
+      return 0;
+    }
+    pCq = (unsigned char *) pr->pCqMap;
+  } else {
+    pCq = pSq;
+  }
+  
+  /* Map the submission queue entries */
+  pr->sqeSize = p.sq_entries * sizeof(struct io_uring_sqe);
+  pr->pSqes = (struct io_uring_sqe *) mmap(
+                  NULL, pr->sqeSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED, pr->fd, IORING_OFF_SQES);
+  if (pr->pSqes == MAP_FAILED) {
+    if (pr->cqMapSize > 0) {
+      munmap(pr->pCqMap, pr->cqMapSize);
+    }
+    munmap(pr->pSqMap, pr->sqMapSize);
+    close(pr->fd);
+    return 0;
+  }
+  
+  /* Locate the ring fields */
+  pr->pSqTail  = (unsigned *) (pSq + p.sq_off.tail);
+  pr->pSqMask  = (unsigned *) (pSq + p.sq_off.ring_mask);
+  pr->pSqArray = (unsigned *) (pSq + p.sq_off.array);
+  pr->pCqHead  = (unsigned *) (pCq + p.cq_off.head);
+  pr->pCqTail  = (unsigned *) (pCq + p.cq_off.tail);
+  pr->pCqMask  = (unsigned *) (pCq + p.cq_off.ring_mask);
+  pr->pCqes    = (struct io_uring_cqe *) (pCq + p.cq_off.cqes);
+  
+  return 1;
+}
+
+/*
+ * Unmap the rings of an io_uring instance and close it.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring to close
+ */
+static void uringClose(URING *pr) {
+  munmap(pr->pSqes, pr->sqeSize);
+  if (pr->cqMapSize > 0) {
+    munmap(pr->pCqMap, pr->cqMapSize);
+  }
+  munmap(pr->pSqMap, pr->sqMapSize);
+  close(pr->fd);
+}
+
+/*
+ * Queue a read or write at the current file position.
+ * 
+ * The operation is not passed to the kernel until the next call to
+ * uringEnter().  The caller must not have more operations outstanding
+ * than the ring has entries.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring
+ * 
+ *   op - IORING_OP_READ or IORING_OP_WRITE
+ * 
+ *   fd - the file descriptor
+ * 
+ *   pBuf - the buffer to transfer
+ * 
+ *   len - the number of bytes to transfer
+ * 
+ *   tag - the value to identify the completion by
+ */
+static void uringQueue(
+    URING    * pr,
+    int        op,
+    int        fd,
+    void     * pBuf,
+    size_t     len,
+    uint64_t   tag) {
+  
+  unsigned tail = 0;
+  unsigned i = 0;
+  struct io_uring_sqe *pe = NULL;
+  
+  tail = *(pr->pSqTail);
+  i = tail & *(pr->pSqMask);
+  pe = &((pr->pSqes)[i]);
+  
+  memset(pe, 0, sizeof(struct io_uring_sqe));
+  pe->opcode = (uint8_t) op;
+  pe->fd = fd;
+  pe->off = (uint64_t) -1;
+  pe->addr = (uint64_t) (uintptr_t) pBuf;
+  pe->len = (uint32_t) len;
+  pe->user_data = tag;
+  
+  (pr->pSqArray)[i] = i;
+  __atomic_store_n(pr->pSqTail, tail + 1, __ATOMIC_RELEASE);
+  pr->queued++;
+}
+
+/*
+ * Submit queued operations and optionally wait for a completion.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring
+ * 
+ *   wait - non-zero to wait until at least one completion is available
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if an error occurred
+ */
+static int uringEnter(URING *pr, int wait) {
+  
+  long rv = 0;
+  
+  while ((pr->queued > 0) || wait) {
+    rv = syscall(__NR_io_uring_enter, pr->fd, pr->queued,
+                  wait ? 1u : 0u, wait ? IORING_ENTER_GETEVENTS : 0u,
+                  NULL, 0);
+    if (rv < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return 0;
+    }
+    pr->queued -= (unsigned) rv;
+    wait = 0;
+  }
+  
+  return 1;
+}
+
+/*
+ * Take the next completion off the completion ring, if there is one.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring
+ * 
+ *   pTag - pointer to the variable to receive the operation tag
+ * 
+ *   pRes - pointer to the variable to receive the operation result
+ * 
+ * Return:
+ * 
+ *   non-zero if a completion was taken, zero if the ring is empty
+ */
+static int uringReap(URING *pr, uint64_t *pTag, int32_t *pRes) {
+  
+  unsigned head = 0;
+  struct io_uring_cqe *pe = NULL;
+  
+  head = *(pr->pCqHead);
+  if (head == __atomic_load_n(pr->pCqTail, __ATOMIC_ACQUIRE)) {
+    return 0;
+  }
+  
+  pe = &((pr->pCqes)[head & *(pr->pCqMask)]);
+  *pTag = pe->user_data;
+  *pRes = pe->res;
+  
+  __atomic_store_n(pr->pCqHead, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/*
+ * Stream standard input to standard output through io_uring.
+ * 
+ * Input chunks and output buffers are used round robin, so that while
+ * one chunk is being converted, the next one is being read and the
+ * output of the previous one is being written.  Only one read and one
+ * write are in flight at a time, because reads and writes at the
+ * current position of a pipe are not ordered with respect to each
+ * other.  Chunks that complete while conversion is busy queue up in
+ * the remaining buffers.
+ * 
+ * If io_uring is not available, nothing is read and the function
+ * fails without reporting an error, so that the caller can fall back
+ * to blocking I/O.
+ * 
+ * Parameters:
+ * 
+ *   ps - the conversion state
+ * 
+ *   pModule - the module name for error messages
+ * 
+ *   pStatus - pointer to the variable to receive non-zero if the
+ *   stream was converted successfully, or zero if an error occurred
+ * 
+ * Return:
+ * 
+ *   non-zero if io_uring was used, zero if it is not available
+ */
+static int streamUring(
+          JSON_STATE * ps,
+    const char       * pModule,
+          int        * pStatus) {
+  
+  URING ring;
+  char *apIn[URING_IN_SLOTS];
+  size_t aInLen[URING_IN_SLOTS];
+  OUTBUF aOut[URING_OUT_SLOTS];
+  
+  int status = 1;
+  int i = 0;
+  int eof = 0;
+  int done = 0;
+  int reading = 0;
+  int writing = 0;
+  unsigned long readCount = 0;
+  unsigned long convCount = 0;
+  unsigned long fillCount = 0;
+  unsigned long writeCount = 0;
+  size_t writePos = 0;
+  OUTBUF *pOut = NULL;
+  uint64_t tag = 0;
+  int32_t res = 0;
+  
+  /* Set up the ring */
+  if (!uringOpen(&ring)) {
+    return 0;
+  }
+  
+  /* Allocate the buffers, with room for a terminating nul after each
+   * input chunk */
+  memset(aOut, 0, sizeof(aOut));
+  for(i = 0; i < URING_IN_SLOTS; i++) {
+    apIn[i] = (char *) malloc(JSON_CHUNK + 1);
+    if (apIn[i] == NULL) {
+      status = 0;
+    }
+  }
+  if (!status) {
+    fprintf(stderr, "%s: Out of memory!\n", pModule);
+  }
+  
+  while (status) {
+    
+    /* Start reading the next chunk if there is a free input slot */
+    if ((!eof) && (!reading) &&
+        (readCount - convCount < URING_IN_SLOTS)) {
+      uringQueue(&ring, IORING_OP_READ, STDIN_FILENO,
+                  apIn[readCount % URING_IN_SLOTS], JSON_CHUNK,
+                  URING_TAG_READ);
+      reading = 1;
+    }
+    
+    /* Start writing the oldest pending output, skipping empty ones */
+    while ((!writing) && (writeCount < fillCount)) {
+      pOut = &(aOut[writeCount % URING_OUT_SLOTS]);
+      if (writePos < pOut->len) {
+        uringQueue(&ring, IORING_OP_WRITE, STDOUT_FILENO,
+                    pOut->pData + writePos, pOut->len - writePos,
+                    URING_TAG_WRITE);
+        writing = 1;
+      } else {
+        writeCount++;
+        writePos = 0;
+      }
+    }
+    
+    /* Hand the new operations to the kernel before converting */
+    if (!uringEnter(&ring, 0)) {
+      fprintf(stderr, "%s: I/O error!\n", pModule);
+      status = 0;
+      break;
+    }
+    
+    /* Convert the oldest chunk if there is a free output slot */
+    if ((convCount < readCount) &&
+        (fillCount - writeCount < URING_OUT_SLOTS)) {
+      pOut = &(aOut[fillCount % URING_OUT_SLOTS]);
+      pOut->len = 0;
+      i = (int) (convCount % URING_IN_SLOTS);
+      if (!jsonFeed(ps, apIn[i], aInLen[i], pOut)) {
+        fprintf(stderr, "%s: Out of memory!\n", pModule);
+        status = 0;
+        break;
+      }
+      convCount++;
+      fillCount++;
+      continue;
+    }
+    
+    /* After the last chunk, convert a final line without a break */
+    if (eof && (!done) && (convCount == readCount) &&
+        (fillCount - writeCount < URING_OUT_SLOTS)) {
+      pOut = &(aOut[fillCount % URING_OUT_SLOTS]);
+      pOut->len = 0;
+      if (!jsonFinish(ps, pOut)) {
+        fprintf(stderr, "%s: Out of memory!\n", pModule);
+        status = 0;
+        break;
+      }
+      fillCount++;
+      done = 1;
+      continue;
+    }
+    
+    /* Finished once everything has been written */
+    if (done && (writeCount == fillCount)) {
+      break;
+    }
+    
+    /* Otherwise, wait for a read or write to complete */
+    if ((!reading) && (!writing)) {
+      abort();
+    }
+    if (!uringEnter(&ring, 1)) {
+      fprintf(stderr, "%s: I/O error!\n", pModule);
+      status = 0;
+      break;
+    }
+    
+    while (uringReap(&ring, &tag, &res)) {
+      if (tag == URING_TAG_READ) {
+        reading = 0;
+        if ((res == -EINTR) || (res == -EAGAIN)) {
+          /* Retried on the next pass */
+        } else if (res < 0) {
+          fprintf(stderr, "%s: Read error!\n", pModule);
+          status = 0;
+        } else if (res == 0) {
+          eof = 1;
+        } else {
+          aInLen[readCount % URING_IN_SLOTS] = (size_t) res;
+          readCount++;
+        }
+        
+      } else {
+        writing = 0;
+        if ((res == -EINTR) || (res == -EAGAIN)) {
+          /* Retried on the next pass */
+        } else if (res <= 0) {
+          fprintf(stderr, "%s: Write error!\n", pModule);
+          status = 0;
+        } else {
+          writePos += (size_t) res;
+        }
+      }
+    }
+  }
+  
+  /* Release everything; if an operation is still in flight after an
+   * error, the kernel may still access its buffer, so the buffers are
+   * left for process exit to reclaim */
+  uringClose(&ring);
+  if ((!reading) && (!writing)) {
+    for(i = 0; i < URING_IN_SLOTS; i++) {
+      free(apIn[i]);
+    }
+    for(i = 0; i < URING_OUT_SLOTS; i++) {
+      free(aOut[i].pData);
+    }
+  }
+  
+  *pStatus = status;
+  return 1;
+}
+
+#endif
+
+/*
+ * Run the -json invocation, converting a field in each line of
+ * newline-delimited JSON read from standard input.
+ * 
+ * Parameters:
+ * 
+ *   pModule - the module name for error messages
+ * 
+ *   pField - the field name
+ * 
+ *   pMode - the conversion mode name
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if an error occurred
+ */
+static int runJson(
+    const char * pModule,
+    const char * pField,
+    const char * pMode) {
+  
+  int status = 1;
+  JSON_STATE st;
+  
+  memset(&st, 0, sizeof(JSON_STATE));
+  st.pField = pField;
+  
+  /* Determine mode */
+  if (strcmp(pMode, "offset") == 0) {
+    st.mode = JSON_OFFSET;
+  } else if (strcmp(pMode, "date") == 0) {
+    st.mode = JSON_DATE;
+  } else if (strcmp(pMode, "unix") == 0) {
+    st.mode = JSON_UNIX;
+  } else {
+    fprintf(stderr, "%s: Unknown conversion mode!\n", pModule);
+    status = 0;
+  }
+  
+  /* Stream the input, preferring io_uring where it is available */
+  if (status) {
+#ifdef QUERY_URING
+    if (!streamUring(&st, pModule, &status)) {
+      status = streamBlocking(&st, pModule);
+    }
+#else
+    status = streamBlocking(&st, pModule);
+#endif
+  }
+  
+  /* Report lines that were passed through unchanged */
+  if (status && (st.skipped > 0)) {
+    fprintf(stderr, "%s: %ld line(s) passed through unconverted\n",
+            pModule, st.skipped);
+  }
+  
+  free(st.pCarry);
+  return status;
+}
+
 /*
  * Program entrypoint
  * ==================
@@ -209,6 +1473,11 @@ int main(int argc, char *argv[]) {
     }
   }
   
+  /* The -json invocation streams standard input */
+  if ((argc == 4) && (strcmp(argv[1], "-json") == 0)) {
+    return runJson(pModule, argv[2], argv[3]) ? 0 : 1;
+  }
+  
   /* Must have either one additional parameter or three */
   if ((argc != 2) && (argc != 4)) {
     fprintf(stderr, "%s: Wrong number of parameters!\n", pModule);
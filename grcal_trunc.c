@@ -0,0 +1,658 @@
+/*
+ * grcal_trunc.c
+ * 
+ * Implementation of grcal_trunc.h
+ * 
+ * See the header for further information.
+ */
+
+#include "grcal_trunc.h"
+#include <stdlib.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of seconds in a day.
+ */
+#define DAY_SECONDS INT64_C(86400)
+
+/*
+ * The number of minutes in a day.
+ */
+#define DAY_MINUTES 1440
+
+/*
+ * The local time at the end of the last day in range, in seconds since
+ * the Unix epoch.
+ */
+#define INSTANT_END \
+  ((((int64_t) GRCAL_DAY_MAX) - GRCAL_DAY_UNIX + 1) * DAY_SECONDS)
+
+/*
+ * Instants more than a day outside the range of local times can not
+ * have a local date in range.  Checking them first keeps the offset
+ * arithmetic from overflowing.
+ */
+#define INSTANT_MIN ((-((int64_t) GRCAL_DAY_UNIX) - 1) * DAY_SECONDS)
+#define INSTANT_MAX (INSTANT_END + DAY_SECONDS)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A period of a time zone during which one offset is in effect.
+ */
+typedef struct {
+  
+  /*
+   * The index of the period, where period zero is before the first
+   * transition and period i starts at transition i - 1.
+   */
+  size_t index;
+  
+  /*
+   * The first instant of the period, and the first instant after it.
+   * These are INT64_MIN and INT64_MAX for the open-ended periods at
+   * either end.
+   */
+  int64_t start;
+  int64_t end;
+  
+  /*
+   * The offset in effect during the period.
+   */
+  int32_t offset;
+  
+} ZONE_PERIOD;
+
+/*
+ * State carried from one instant to the next.
+ */
+typedef struct {
+  
+  /*
+   * The zone, unit, bucket length, and non-zero for ceiling rather
+   * than flooring.
+   */
+  const GRCAL_ZONE *pZone;
+  int unit;
+  int32_t minutes;
+  int ceil;
+  
+  /*
+   * The offset period of the previous instant, if havePeriod is
+   * non-zero.
+   */
+  int havePeriod;
+  ZONE_PERIOD period;
+  
+  /*
+   * The local bucket of the previous instant, from lo up to but not
+   * including hi, in local seconds since the Unix epoch, if haveBucket
+   * is non-zero.  Every instant of the same period whose local time is
+   * strictly inside the bucket has the same result, which is stored in
+   * result if resultValid is non-zero.
+   */
+  int haveBucket;
+  int64_t lo;
+  int64_t hi;
+  int resultValid;
+  int64_t result;
+  
+} TRUNC_STATE;
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The zone used when NULL is passed.
+ */
+static const GRCAL_ZONE m_utc = {0, 0, NULL, NULL};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void checkArgs(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes);
+static void periodAt(
+    const GRCAL_ZONE  * pz,
+          size_t        i,
+          ZONE_PERIOD * pp);
+static void periodFind(
+    const GRCAL_ZONE  * pz,
+          int64_t       t,
+          ZONE_PERIOD * pp);
+static int localBucket(
+    int       unit,
+    int32_t   minutes,
+    int64_t   local,
+    int64_t * pLo,
+    int64_t * pHi);
+static int64_t floorIn(
+    const GRCAL_ZONE  * pz,
+    const ZONE_PERIOD * pp,
+          int64_t       lo);
+static int64_t ceilIn(
+    const GRCAL_ZONE  * pz,
+    const ZONE_PERIOD * pp,
+          int64_t       hi);
+static void stateInit(
+          TRUNC_STATE * ps,
+    const GRCAL_ZONE  * pZone,
+          int           unit,
+          int32_t       minutes,
+          int           ceil);
+static int stateStep(TRUNC_STATE *ps, int64_t t, int64_t *pResult);
+
+/*
+ * Fault if the zone or unit parameters are not valid.
+ * 
+ * Parameters:
+ * 
+ *   pZone - the time zone
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ */
+static void checkArgs(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes) {
+  
+  if ((pZone->count > 0) &&
+      ((pZone->pTime == NULL) || (pZone->pOffset == NULL))) {
+    abort();
+  }
+  if ((unit < GRCAL_TRUNC_MINUTES) || (unit > GRCAL_TRUNC_MONTH)) {
+    abort();
+  }
+  if ((unit == GRCAL_TRUNC_MINUTES) &&
+      ((minutes < 1) || (minutes > DAY_MINUTES))) {
+    abort();
+  }
+}
+
+/*
+ * Get a period of a time zone by index.
+ * 
+ * A fault occurs if the offset of the period is out of range.
+ * 
+ * Parameters:
+ * 
+ *   pz - the time zone
+ * 
+ *   i - the period index, at most the number of transitions
+ * 
+ *   pp - the structure to receive the period
+ */
+static void periodAt(
+    const GRCAL_ZONE  * pz,
+          size_t        i,
+          ZONE_PERIOD * pp) {
+  
+  pp->index = i;
+  if (i > 0) {
+    pp->start = (pz->pTime)[i - 1];
+    pp->offset = (pz->pOffset)[i - 1];
+  } else {
+    pp->start = INT64_MIN;
+    pp->offset = pz->base;
+  }
+  if (i < pz->count) {
+    pp->end = (pz->pTime)[i];
+  } else {
+    pp->end = INT64_MAX;
+  }
+  
+  if ((pp->offset < -GRCAL_ZONE_MAX) || (pp->offset > GRCAL_ZONE_MAX)) {
+    abort();
+  }
+}
+
+/*
+ * Find the period of a time zone that contains an instant.
+ * 
+ * Parameters:
+ * 
+ *   pz - the time zone
+ * 
+ *   t - the instant
+ * 
+ *   pp - the structure to receive the period
+ */
+static void periodFind(
+    const GRCAL_ZONE  * pz,
+          int64_t       t,
+          ZONE_PERIOD * pp) {
+  
+  size_t lo = 0;
+  size_t hi = 0;
+  size_t mid = 0;
+  
+  /* Count the transitions at or before the instant */
+  lo = 0;
+  hi = pz->count;
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    if ((pz->pTime)[mid] <= t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  
+  periodAt(pz, lo, pp);
+}
+
+/*
+ * Find the local bucket that a local time falls into.
+ * 
+ * Parameters:
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   local - the local time, in seconds since the Unix epoch
+ * 
+ *   pLo - pointer to the variable to receive the local time at the
+ *   start of the bucket
+ * 
+ *   pHi - pointer to the variable to receive the local time at the
+ *   start of the next bucket
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the local date or the start of the
+ *   bucket is outside the range of grcal day offsets
+ */
+static int localBucket(
+    int       unit,
+    int32_t   minutes,
+    int64_t   local,
+    int64_t * pLo,
+    int64_t * pHi) {
+  
+  int64_t day = 0;
+  int64_t midnight = 0;
+  int64_t step = 0;
+  int32_t offs = 0;
+  int32_t next = 0;
+  int y = 0;
+  int m = 0;
+  int d = 0;
+  
+  /* Split off the local day, rounding towards negative infinity */
+  day = local / DAY_SECONDS;
+  if (local % DAY_SECONDS < 0) {
+    day--;
+  }
+  if ((day < -GRCAL_DAY_UNIX) ||
+      (day > GRCAL_DAY_MAX - GRCAL_DAY_UNIX)) {
+    return 0;
+  }
+  offs = (int32_t) (day + GRCAL_DAY_UNIX);
+  midnight = day * DAY_SECONDS;
+  
+  if ((unit == GRCAL_TRUNC_MINUTES) || (unit == GRCAL_TRUNC_HOUR)) {
+    /* Buckets of minutes restart at each local midnight */
+    step = ((int64_t) minutes) * 60;
+    if (unit == GRCAL_TRUNC_HOUR) {
+      step = 3600;
+    }
+    *pLo = midnight + (((local - midnight) / step) * step);
+    *pHi = *pLo + step;
+    if (*pHi > midnight + DAY_SECONDS) {
+      *pHi = midnight + DAY_SECONDS;
+    }
+    
+  } else if (unit == GRCAL_TRUNC_DAY) {
+    *pLo = midnight;
+    *pHi = midnight + DAY_SECONDS;
+    
+  } else if (unit == GRCAL_TRUNC_WEEK) {
+    /* Back up to Monday, which may be before day zero */
+    offs = offs - (grcal_weekday(offs) - 1);
+    if (offs < 0) {
+      return 0;
+    }
+    *pLo = (((int64_t) offs) - GRCAL_DAY_UNIX) * DAY_SECONDS;
+    *pHi = *pLo + (7 * DAY_SECONDS);
+    
+  } else {
+    /* Back up to the first of the month, and find the first of the
+     * next month, which may be just past the end of the range */
+    grcal_offsetToDate(offs, &y, &m, &d);
+    offs = offs - (d - 1);
+    if (m < 12) {
+      grcal_dateToOffset(&next, y, m + 1, 1);
+    } else {
+      next = offs + 31;
+    }
+    *pLo = (((int64_t) offs) - GRCAL_DAY_UNIX) * DAY_SECONDS;
+    *pHi = (((int64_t) next) - GRCAL_DAY_UNIX) * DAY_SECONDS;
+  }
+  
+  return 1;
+}
+
+/*
+ * Find the latest instant at which local time is a given boundary,
+ * searching back from a given period.
+ * 
+ * If local time skipped over the boundary at a transition, the
+ * transition instant is returned instead.
+ * 
+ * Parameters:
+ * 
+ *   pz - the time zone
+ * 
+ *   pp - the period to start from, whose local times must not all be
+ *   before the boundary
+ * 
+ *   lo - the boundary, in local seconds since the Unix epoch
+ * 
+ * Return:
+ * 
+ *   the floored instant
+ */
+static int64_t floorIn(
+    const GRCAL_ZONE  * pz,
+    const ZONE_PERIOD * pp,
+          int64_t       lo) {
+  
+  ZONE_PERIOD p;
+  int64_t u = 0;
+  
+  p = *pp;
+  for(;;) {
+    u = lo - p.offset;
+    if (u >= p.start) {
+      return (u < p.end) ? u : p.end;
+    }
+    periodAt(pz, p.index - 1, &p);
+  }
+}
+
+/*
+ * Find the earliest instant at which local time is a given boundary,
+ * searching forward from a given period.
+ * 
+ * If local time skipped over the boundary at a transition, the
+ * transition instant is returned instead.
+ * 
+ * Parameters:
+ * 
+ *   pz - the time zone
+ * 
+ *   pp - the period to start from, whose local times must not all be
+ *   after the boundary
+ * 
+ *   hi - the boundary, in local seconds since the Unix epoch
+ * 
+ * Return:
+ * 
+ *   the ceiled instant
+ */
+static int64_t ceilIn(
+    const GRCAL_ZONE  * pz,
+    const ZONE_PERIOD * pp,
+          int64_t       hi) {
+  
+  ZONE_PERIOD p;
+  int64_t u = 0;
+  
+  p = *pp;
+  for(;;) {
+    u = hi - p.offset;
+    if (u < p.end) {
+      return (u >= p.start) ? u : p.start;
+    }
+    periodAt(pz, p.index + 1, &p);
+  }
+}
+
+/*
+ * Initialize the state for a run of instants.
+ * 
+ * Parameters:
+ * 
+ *   ps - the state to initialize
+ * 
+ *   pZone - the time zone, or NULL for UTC
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   ceil - non-zero for ceiling, zero for flooring
+ */
+static void stateInit(
+          TRUNC_STATE * ps,
+    const GRCAL_ZONE  * pZone,
+          int           unit,
+          int32_t       minutes,
+          int           ceil) {
+  
+  if (pZone == NULL) {
+    pZone = &m_utc;
+  }
+  checkArgs(pZone, unit, minutes);
+  
+  ps->pZone = pZone;
+  ps->unit = unit;
+  ps->minutes = minutes;
+  ps->ceil = ceil;
+  ps->havePeriod = 0;
+  ps->haveBucket = 0;
+}
+
+/*
+ * Floor or ceil the next instant of a run.
+ * 
+ * Parameters:
+ * 
+ *   ps - the state
+ * 
+ *   t - the instant
+ * 
+ *   pResult - pointer to the variable to receive the result
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of range
+ */
+static int stateStep(TRUNC_STATE *ps, int64_t t, int64_t *pResult) {
+  
+  const GRCAL_ZONE *pz = NULL;
+  ZONE_PERIOD *pp = NULL;
+  int64_t local = 0;
+  
+  pz = ps->pZone;
+  pp = &(ps->period);
+  
+  if ((t < INSTANT_MIN) || (t > INSTANT_MAX)) {
+    return 0;
+  }
+  
+  /* Find the offset period, trying the current and the next one before
+   * searching */
+  if ((!ps->havePeriod) || (t < pp->start) || (t >= pp->end)) {
+    if (ps->havePeriod && (t >= pp->end) && (pp->index + 1 < pz->count)
+        && (t < (pz->pTime)[pp->index + 1])) {
+      periodAt(pz, pp->index + 1, pp);
+    } else {
+      periodFind(pz, t, pp);
+    }
+    ps->havePeriod = 1;
+    ps->haveBucket = 0;
+  }
+  local = t + pp->offset;
+  
+  /* Compute the bucket unless the instant is inside the previous one */
+  if ((!ps->haveBucket) || (local < ps->lo) || (local >= ps->hi)) {
+    ps->haveBucket = 0;
+    if (!localBucket(ps->unit, ps->minutes, local, &(ps->lo),
+                      &(ps->hi))) {
+      return 0;
+    }
+    ps->haveBucket = 1;
+    
+    if (ps->ceil) {
+      ps->resultValid = (ps->hi < INSTANT_END);
+      if (ps->resultValid) {
+        ps->result = ceilIn(pz, pp, ps->hi);
+      }
+    } else {
+      ps->resultValid = 1;
+      ps->result = floorIn(pz, pp, ps->lo);
+    }
+  }
+  
+  /* An instant exactly on a boundary is its own floor and ceiling */
+  if (local == ps->lo) {
+    *pResult = t;
+    return 1;
+  }
+  
+  /* An instant at a transition that skipped over the boundary is also
+   * its own ceiling, since it is its own floor */
+  if (ps->ceil && (t == pp->start)) {
+    if (floorIn(pz, pp, ps->lo) == t) {
+      *pResult = t;
+      return 1;
+    }
+  }
+  
+  if (!ps->resultValid) {
+    return 0;
+  }
+  *pResult = ps->result;
+  return 1;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * grcal_truncFloor function.
+ */
+int grcal_truncFloor(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+          int64_t      t,
+          int64_t    * pResult) {
+  
+  TRUNC_STATE st;
+  
+  if (pResult == NULL) {
+    abort();
+  }
+  
+  stateInit(&st, pZone, unit, minutes, 0);
+  return stateStep(&st, t, pResult);
+}
+
+/*
+ * grcal_truncCeil function.
+ */
+int grcal_truncCeil(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+          int64_t      t,
+          int64_t    * pResult) {
+  
+  TRUNC_STATE st;
+  
+  if (pResult == NULL) {
+    abort();
+  }
+  
+  stateInit(&st, pZone, unit, minutes, 1);
+  return stateStep(&st, t, pResult);
+}
+
+/*
+ * grcal_truncFloorBatch function.
+ */
+size_t grcal_truncFloorBatch(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+    const int64_t    * pIn,
+          size_t       count,
+          int64_t    * pOut) {
+  
+  TRUNC_STATE st;
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t r = 0;
+  
+  if ((count > 0) && ((pIn == NULL) || (pOut == NULL))) {
+    abort();
+  }
+  
+  stateInit(&st, pZone, unit, minutes, 0);
+  for(i = 0; i < count; i++) {
+    if (stateStep(&st, pIn[i], &r)) {
+      pOut[i] = r;
+    } else {
+      pOut[i] = GRCAL_TRUNC_INVALID;
+      bad++;
+    }
+  }
+  
+  return bad;
+}
+
+/*
+ * grcal_truncCeilBatch function.
+ */
+size_t grcal_truncCeilBatch(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+    const int64_t    * pIn,
+          size_t       count,
+          int64_t    * pOut) {
+  
+  TRUNC_STATE st;
+  size_t i = 0;
+  size_t bad = 0;
+  int64_t r = 0;
+  
+  if ((count > 0) && ((pIn == NULL) || (pOut == NULL))) {
+    abort();
+  }
+  
+  stateInit(&st, pZone, unit, minutes, 1);
+  for(i = 0; i < count; i++) {
+    if (stateStep(&st, pIn[i], &r)) {
+      pOut[i] = r;
+    } else {
+      pOut[i] = GRCAL_TRUNC_INVALID;
+      bad++;
+    }
+  }
+  
+  return bad;
+}
@@ -0,0 +1,226 @@
+#ifndef GRCAL_TRUNC_H_INCLUDED
+#define GRCAL_TRUNC_H_INCLUDED
+
+/*
+ * grcal_trunc.h
+ * =============
+ * 
+ * Time zone aware flooring and ceiling of instants to local time
+ * boundaries, for bucketing timestamps by local minute ranges, hours,
+ * days, weeks, or months.
+ * 
+ * Instants are given in seconds since the Unix epoch, UTC.  They are
+ * floored or ceiled to a boundary of local time in a time zone, and the
+ * result is again an instant in UTC.
+ * 
+ * grcal has no time zone database, so a time zone is described by the
+ * caller as a table of the UTC offsets it has used, in the GRCAL_ZONE
+ * structure below.  Offsets are in seconds and positive east of
+ * Greenwich, the same as in grcal_clock.h.  A fixed offset is a table
+ * with no transitions.
+ * 
+ * Around a transition, local time can skip ahead or repeat.  A floored
+ * instant is the latest instant, no later than the input, at which
+ * local time is exactly the boundary.  If local time skipped over the
+ * boundary, it is the transition instant instead.  Ceiling works the
+ * same way in the other direction, using the earliest instant.  An
+ * instant that is exactly on a boundary is its own floor and ceiling.
+ * As a result, each bucket of a repeated local hour only covers one of
+ * its occurrences.
+ * 
+ * The batch functions are meant for columns of timestamps that are
+ * mostly in order.  They remember the offset period of the previous
+ * instant and the local bucket it fell into.  An instant that falls
+ * into the same bucket gets the previous result with no further work.
+ * An instant in the same offset period only needs its bucket
+ * recomputed.  The zone table is only searched when an instant leaves
+ * the current offset period for anything other than the next one.
+ * 
+ * This module is not available in the freestanding configuration.
+ */
+
+#include "grcal_clock.h"
+#include <stddef.h>
+
+/*
+ * Truncation units.
+ * 
+ * GRCAL_TRUNC_MINUTES divides each local day into buckets of a given
+ * number of minutes, starting at local midnight.  If the number of
+ * minutes does not divide a day evenly, the last bucket of each day is
+ * shorter.  GRCAL_TRUNC_HOUR is the same as 60 minutes.
+ * 
+ * GRCAL_TRUNC_WEEK weeks start on Monday.
+ */
+#define GRCAL_TRUNC_MINUTES 1
+#define GRCAL_TRUNC_HOUR    2
+#define GRCAL_TRUNC_DAY     3
+#define GRCAL_TRUNC_WEEK    4
+#define GRCAL_TRUNC_MONTH   5
+
+/*
+ * The result stored by the batch functions for instants that could not
+ * be converted.
+ */
+#define GRCAL_TRUNC_INVALID INT64_MIN
+
+/*
+ * Time zone description.
+ */
+typedef struct {
+  
+  /*
+   * The offset in effect before the first transition, or at all times
+   * if there are no transitions.
+   */
+  int32_t base;
+  
+  /*
+   * The number of transitions.
+   */
+  size_t count;
+  
+  /*
+   * The transition instants, in strictly ascending order, and the
+   * offset that takes effect at each of them.  Both may be NULL if the
+   * count is zero.
+   */
+  const int64_t *pTime;
+  const int32_t *pOffset;
+  
+} GRCAL_ZONE;
+
+/*
+ * Floor an instant to a local time boundary.
+ * 
+ * pZone may be NULL for UTC.  All offsets in the zone must have a
+ * magnitude of at most GRCAL_ZONE_MAX, unit must be one of the
+ * GRCAL_TRUNC constants, and for GRCAL_TRUNC_MINUTES, minutes must be
+ * in range 1 to 1440; otherwise, a fault occurs.  minutes is ignored
+ * for the other units.
+ * 
+ * The function fails if the local date of the instant or of the result
+ * is outside the range of grcal day offsets.  In that case, zero is
+ * returned and nothing is written.
+ * 
+ * Parameters:
+ * 
+ *   pZone - the time zone, or NULL for UTC
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   t - the instant, in seconds since the Unix epoch
+ * 
+ *   pResult - pointer to the variable to receive the floored instant
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of range
+ */
+int grcal_truncFloor(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+          int64_t      t,
+          int64_t    * pResult);
+
+/*
+ * Ceil an instant to a local time boundary.
+ * 
+ * The parameters and failure conditions are the same as for
+ * grcal_truncFloor().
+ * 
+ * Parameters:
+ * 
+ *   pZone - the time zone, or NULL for UTC
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   t - the instant, in seconds since the Unix epoch
+ * 
+ *   pResult - pointer to the variable to receive the ceiled instant
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if out of range
+ */
+int grcal_truncCeil(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+          int64_t      t,
+          int64_t    * pResult);
+
+/*
+ * Floor an array of instants to local time boundaries.
+ * 
+ * The results are the same as calling grcal_truncFloor() on each
+ * instant, except that GRCAL_TRUNC_INVALID is stored for instants that
+ * could not be converted.  The input and output arrays may be the same
+ * array.
+ * 
+ * Parameters:
+ * 
+ *   pZone - the time zone, or NULL for UTC
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   pIn - the instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the floored instants
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be converted
+ */
+size_t grcal_truncFloorBatch(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+    const int64_t    * pIn,
+          size_t       count,
+          int64_t    * pOut);
+
+/*
+ * Ceil an array of instants to local time boundaries.
+ * 
+ * The results are the same as calling grcal_truncCeil() on each
+ * instant, except that GRCAL_TRUNC_INVALID is stored for instants that
+ * could not be converted.  The input and output arrays may be the same
+ * array.
+ * 
+ * Parameters:
+ * 
+ *   pZone - the time zone, or NULL for UTC
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   pIn - the instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the ceiled instants
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be converted
+ */
+size_t grcal_truncCeilBatch(
+    const GRCAL_ZONE * pZone,
+          int          unit,
+          int32_t      minutes,
+    const int64_t    * pIn,
+          size_t       count,
+          int64_t    * pOut);
+
+#endif
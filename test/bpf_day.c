@@ -0,0 +1,65 @@
+/*
+ * bpf_day.c
+ * =========
+ * 
+ * Minimal eBPF program that uses grcal_bpf.h, to check that the header
+ * compiles for the BPF target.
+ * 
+ * The program is a socket filter that converts the timestamp of each
+ * packet to a date and weekday, and accepts the packet only if the
+ * conversion succeeds.  It needs no BPF helper functions or maps, so it
+ * only depends on the kernel UAPI headers.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Built by the "bpf" target of the Makefile, which requires clang.
+ * Sample invocation:
+ * 
+ *   clang -target bpf -O2 -I. -c -o bpf_day.o test/bpf_day.c
+ * 
+ * The object can be loaded with any BPF loader, such as bpftool, to
+ * run it through the verifier.
+ */
+
+#include <linux/bpf.h>
+
+#include "grcal_bpf.h"
+
+/*
+ * The program.
+ * 
+ * Parameters:
+ * 
+ *   skb - the packet
+ * 
+ * Return:
+ * 
+ *   the number of bytes of the packet to keep
+ */
+__attribute__((section("socket"), used))
+int grcal_bpf_day(struct __sk_buff *skb) {
+  
+  GRCAL_BPF_U32 offs = 0;
+  GRCAL_BPF_U32 y = 0;
+  GRCAL_BPF_U32 m = 0;
+  GRCAL_BPF_U32 d = 0;
+  
+  if (!grcal_bpf_unixToOffset(&offs, skb->tstamp / 1000000000u)) {
+    return 0;
+  }
+  if (!grcal_bpf_offsetToDate(offs, &y, &m, &d)) {
+    return 0;
+  }
+  if ((grcal_bpf_weekday(offs) == 0) || (m < 1) || (d < 1)) {
+    return 0;
+  }
+  
+  return (int) skb->len;
+}
+
+/*
+ * License of the program.
+ */
+__attribute__((section("license"), used))
+char grcal_bpf_license[] = "GPL";
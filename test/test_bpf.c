@@ -0,0 +1,133 @@
+/*
+ * test_bpf.c
+ * ==========
+ * 
+ * Regression tests for grcal_bpf.h.
+ * 
+ * Syntax
+ * ------
+ * 
+ *   test_bpf
+ * 
+ * Operation
+ * ---------
+ * 
+ * Compiles the eBPF header for the host and compares each of its
+ * functions against the grcal.c functions over every valid day offset,
+ * and checks that offsets and timestamps just past the end of the
+ * range are rejected.
+ * 
+ * Prints a message and exits with status zero if all tests pass, or
+ * prints the failures and exits with a non-zero status otherwise.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Built and run by the "check" target of the Makefile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "grcal.h"
+#include "grcal_bpf.h"
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of seconds in a day.
+ */
+#define DAY_SEC 86400u
+
+/*
+ * The maximum number of failures reported before giving up.
+ */
+#define MAX_FAIL 10
+
+/*
+ * Program entrypoint
+ * ==================
+ */
+
+int main(int argc, char *argv[]) {
+  
+  GRCAL_BPF_U32 offs = 0;
+  GRCAL_BPF_U32 y = 0;
+  GRCAL_BPF_U32 m = 0;
+  GRCAL_BPF_U32 d = 0;
+  GRCAL_BPF_U32 result = 0;
+  GRCAL_BPF_U64 sec = 0;
+  int ry = 0;
+  int rm = 0;
+  int rd = 0;
+  int failed = 0;
+  
+  (void) argc;
+  (void) argv;
+  
+  /* The constants must match grcal.h */
+  if ((GRCAL_BPF_DAY_MAX != (GRCAL_BPF_U32) GRCAL_DAY_MAX) ||
+      (GRCAL_BPF_DAY_UNIX != (GRCAL_BPF_U32) GRCAL_DAY_UNIX)) {
+    fprintf(stderr, "test_bpf: Constants differ from grcal.h!\n");
+    failed++;
+  }
+  
+  /* Compare every valid day offset */
+  for(offs = 0; offs <= GRCAL_BPF_DAY_MAX; offs++) {
+    if (failed >= MAX_FAIL) {
+      break;
+    }
+    
+    grcal_offsetToDate((int32_t) offs, &ry, &rm, &rd);
+    if ((!grcal_bpf_offsetToDate(offs, &y, &m, &d)) ||
+        (y != (GRCAL_BPF_U32) ry) || (m != (GRCAL_BPF_U32) rm) ||
+        (d != (GRCAL_BPF_U32) rd)) {
+      fprintf(stderr, "test_bpf: Wrong date for offset %lu!\n",
+                (unsigned long) offs);
+      failed++;
+    }
+    
+    if (grcal_bpf_weekday(offs) !=
+          (GRCAL_BPF_U32) grcal_weekday((int32_t) offs)) {
+      fprintf(stderr, "test_bpf: Wrong weekday for offset %lu!\n",
+                (unsigned long) offs);
+      failed++;
+    }
+    
+    /* The first and last second of each day from the Unix epoch on */
+    if (offs >= GRCAL_BPF_DAY_UNIX) {
+      sec = ((GRCAL_BPF_U64) (offs - GRCAL_BPF_DAY_UNIX)) * DAY_SEC;
+      if ((!grcal_bpf_unixToOffset(&result, sec)) ||
+          (result != offs) ||
+          (!grcal_bpf_unixToOffset(&result, sec + (DAY_SEC - 1))) ||
+          (result != offs)) {
+        fprintf(stderr, "test_bpf: Wrong offset for day %lu!\n",
+                  (unsigned long) offs);
+        failed++;
+      }
+    }
+  }
+  
+  /* Out of range input must be rejected without writing anything */
+  y = 0;
+  result = 0;
+  if (grcal_bpf_offsetToDate(GRCAL_BPF_DAY_MAX + 1u, &y, &m, &d) ||
+      (y != 0) ||
+      (grcal_bpf_weekday(GRCAL_BPF_DAY_MAX + 1u) != 0) ||
+      grcal_bpf_unixToOffset(&result,
+        ((GRCAL_BPF_U64) (GRCAL_BPF_DAY_MAX + 1u - GRCAL_BPF_DAY_UNIX))
+          * DAY_SEC) ||
+      (result != 0)) {
+    fprintf(stderr, "test_bpf: Out of range input accepted!\n");
+    failed++;
+  }
+  
+  if (failed > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("test_bpf: All tests passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*
+ * test_expr.c
+ * ===========
+ * 
+ * Regression tests for grcal_expr.h.
+ * 
+ * Syntax
+ * ------
+ * 
+ *   test_expr
+ * 
+ * Operation
+ * ---------
+ * 
+ * Compiles a table of expressions and applies each of them to a date,
+ * checking the result against the expected date.  The table covers
+ * clamping of the day of the month, ISO 8601 durations, and moves to
+ * the next and previous weekday.  It also covers day moves in opposite
+ * directions next to both ends of the range of day offsets, which must
+ * fail at the intermediate step rather than cancel out.  Text that is
+ * not a valid expression must fail to compile.
+ * 
+ * Prints a message and exits with status zero if all tests pass, or
+ * prints the failures and exits with a non-zero status otherwise.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Built and run by the "check" target of the Makefile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "grcal.h"
+#include "grcal_expr.h"
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * One test case, where an expected result of -1 means that the
+ * expression must fail on the input.
+ */
+typedef struct {
+  const char *pText;
+  int32_t in;
+  int32_t out;
+} EXPR_CASE;
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * Expressions that must compile, with their inputs and results.
+ */
+static const EXPR_CASE m_cases[] = {
+  
+  /* Clamping to the length of the resulting month */
+  {"+1M", GRCAL_DATE(2024, 1, 31), GRCAL_DATE(2024, 2, 29)},
+  {"+1M", GRCAL_DATE(2023, 1, 31), GRCAL_DATE(2023, 2, 28)},
+  {"+1 month", GRCAL_DATE(2024, 3, 31), GRCAL_DATE(2024, 4, 30)},
+  {"-1Y", GRCAL_DATE(2024, 2, 29), GRCAL_DATE(2023, 2, 28)},
+  {"+1Q", GRCAL_DATE(2024, 11, 30), GRCAL_DATE(2025, 2, 28)},
+  {"+3M EOM", GRCAL_DATE(2024, 1, 15), GRCAL_DATE(2024, 4, 30)},
+  
+  /* ISO durations move the year and month first, then the days */
+  {"P1Y2M10D", GRCAL_DATE(2023, 1, 31), GRCAL_DATE(2024, 4, 10)},
+  {"P1M1D", GRCAL_DATE(2024, 1, 31), GRCAL_DATE(2024, 3, 1)},
+  {"P1W2D", GRCAL_DATE(2024, 1, 1), GRCAL_DATE(2024, 1, 10)},
+  {"-P1M", GRCAL_DATE(2024, 3, 31), GRCAL_DATE(2024, 2, 29)},
+  {"p2w", GRCAL_DATE(2024, 12, 25), GRCAL_DATE(2025, 1, 8)},
+  
+  /* Weekday moves are strict, so a Friday moves a whole week */
+  {"next Friday", GRCAL_DATE(2024, 5, 16), GRCAL_DATE(2024, 5, 17)},
+  {"next Friday", GRCAL_DATE(2024, 5, 17), GRCAL_DATE(2024, 5, 24)},
+  {"previous Mon", GRCAL_DATE(2024, 5, 15), GRCAL_DATE(2024, 5, 13)},
+  {"previous Mon", GRCAL_DATE(2024, 5, 13), GRCAL_DATE(2024, 5, 6)},
+  {"next Sunday", GRCAL_DATE(2024, 12, 30), GRCAL_DATE(2025, 1, 5)},
+  
+  /* Moves in opposite directions are not fused, so they fail if the
+   * intermediate date is out of range */
+  {"-3D +3D", 1, -1},
+  {"+3D -3D", 1, 1},
+  {"+3D -3D", GRCAL_DAY_MAX - 1, -1},
+  {"-3D +3D", GRCAL_DAY_MAX - 1, GRCAL_DAY_MAX - 1},
+  {"-1W +1W", 6, -1},
+  {"+2D +3D", GRCAL_DAY_MAX - 5, GRCAL_DAY_MAX},
+  {"+2D +4D", GRCAL_DAY_MAX - 5, -1},
+  
+  /* Moves past either end of the range */
+  {"previous Friday", 0, -1},
+  {"next Friday", GRCAL_DAY_MAX, -1},
+  {"+1M", GRCAL_DATE(9999, 12, 1), -1},
+  {"-1M", GRCAL_DATE(1582, 10, 20), -1},
+  
+  /* Invalid input */
+  {"+1D", -1, -1},
+  {"", GRCAL_DAY_MAX + 1, -1}
+};
+
+/*
+ * Text that must fail to compile.
+ */
+static const char *m_bad[] = {
+  "+1X",
+  "P1Y2",
+  "PT1H",
+  "next Funday",
+  "+99999999D"
+};
+
+/*
+ * Program entrypoint
+ * ==================
+ */
+
+int main(int argc, char *argv[]) {
+  
+  GRCAL_EXPR ex;
+  size_t errPos = 0;
+  size_t i = 0;
+  int32_t result = 0;
+  int failed = 0;
+  
+  (void) argc;
+  (void) argv;
+  
+  for(i = 0; i < sizeof(m_cases) / sizeof(m_cases[0]); i++) {
+    if (!grcal_exprCompile(&ex, m_cases[i].pText, &errPos)) {
+      fprintf(stderr, "test_expr: \"%s\" failed to compile!\n",
+                m_cases[i].pText);
+      failed++;
+      continue;
+    }
+    
+    grcal_exprApply(&ex, NULL, &(m_cases[i].in), 1, &result);
+    if (result != m_cases[i].out) {
+      fprintf(stderr,
+        "test_expr: \"%s\" on %ld gave %ld, expected %ld!\n",
+        m_cases[i].pText, (long) m_cases[i].in, (long) result,
+        (long) m_cases[i].out);
+      failed++;
+    }
+  }
+  
+  for(i = 0; i < sizeof(m_bad) / sizeof(m_bad[0]); i++) {
+    if (grcal_exprCompile(&ex, m_bad[i], &errPos)) {
+      fprintf(stderr, "test_expr: \"%s\" compiled!\n", m_bad[i]);
+      failed++;
+    }
+  }
+  
+  if (failed > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("test_expr: All tests passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/*
+ * test_par.c
+ * ==========
+ * 
+ * Regression tests for grcal_par.h.
+ * 
+ * Syntax
+ * ------
+ * 
+ *   test_par
+ * 
+ * Operation
+ * ---------
+ * 
+ * Creates thread pools and starts a parallel-for job on each of them
+ * immediately, before the worker threads have had a chance to run,
+ * then checks that every element was processed exactly once.  A pool
+ * whose workers miss the first job hangs, so an alarm fails the test
+ * if it does not finish in time.
+ * 
+ * Prints a message and exits with status zero if all tests pass, or
+ * prints the failures and exits with a non-zero status otherwise.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Built and run by the "check" target of the Makefile.
+ */
+
+#if !defined(_POSIX_C_SOURCE) || (_POSIX_C_SOURCE < 200112L)
+#undef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "grcal_par.h"
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The number of pools to create and the number of lanes of each.
+ */
+#define POOL_COUNT 200
+#define POOL_LANES 16
+
+/*
+ * The number of elements in each job, and the elements per chunk.
+ */
+#define JOB_COUNT 100
+#define JOB_CHUNK 1
+
+/*
+ * The number of seconds before the test is considered hung.
+ */
+#define TIME_LIMIT 60
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The number of times each element has been processed.
+ */
+static int m_hits[JOB_COUNT];
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void countRange(void *pArg, size_t first, size_t count);
+static int runJob(const GRCAL_EXECUTOR *pExec);
+
+/*
+ * Range function that counts the elements it is given.
+ * 
+ * Each element is in exactly one range, so no locking is needed.
+ * 
+ * Parameters:
+ * 
+ *   pArg - ignored
+ * 
+ *   first - the first element
+ * 
+ *   count - the number of elements
+ */
+static void countRange(void *pArg, size_t first, size_t count) {
+  
+  size_t i = 0;
+  
+  (void) pArg;
+  for(i = first; i < first + count; i++) {
+    m_hits[i]++;
+  }
+}
+
+/*
+ * Run a job and check that every element was processed once.
+ * 
+ * Parameters:
+ * 
+ *   pExec - the executor
+ * 
+ * Return:
+ * 
+ *   non-zero if the job was correct, zero if not
+ */
+static int runJob(const GRCAL_EXECUTOR *pExec) {
+  
+  int i = 0;
+  
+  memset(m_hits, 0, sizeof(m_hits));
+  grcal_parFor(pExec, JOB_COUNT, JOB_CHUNK, &countRange, NULL);
+  
+  for(i = 0; i < JOB_COUNT; i++) {
+    if (m_hits[i] != 1) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Program entrypoint
+ * ==================
+ */
+
+int main(int argc, char *argv[]) {
+  
+  GRCAL_POOL *pp = NULL;
+  GRCAL_EXECUTOR e;
+  int failed = 0;
+  int i = 0;
+  
+  (void) argc;
+  (void) argv;
+  
+  /* Fail by the default action of SIGALRM if a job hangs */
+  alarm(TIME_LIMIT);
+  
+  for(i = 0; i < POOL_COUNT; i++) {
+    pp = grcal_poolNew(POOL_LANES);
+    if (pp == NULL) {
+      fprintf(stderr, "test_par: Failed to create pool!\n");
+      return EXIT_FAILURE;
+    }
+    grcal_poolExecutor(pp, &e);
+    
+    /* The first job starts right after the pool is created, and a
+     * second one checks that the pool is still usable after it */
+    if (!runJob(&e)) {
+      fprintf(stderr, "test_par: First job of pool %d wrong!\n", i);
+      failed++;
+    }
+    if (!runJob(&e)) {
+      fprintf(stderr, "test_par: Second job of pool %d wrong!\n", i);
+      failed++;
+    }
+    
+    grcal_poolFree(pp);
+  }
+  
+  if (failed > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("test_par: All tests passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,407 @@
+/*
+ * test_trunc.c
+ * ============
+ * 
+ * Regression tests for grcal_trunc.h.
+ * 
+ * Syntax
+ * ------
+ * 
+ *   test_trunc
+ * 
+ * Operation
+ * ---------
+ * 
+ * Uses a time zone with a half-hour base offset, one transition that
+ * skips an hour of local time ahead, and one that repeats an hour.
+ * 
+ * First checks a table of instants around the transitions against
+ * their expected floors and ceilings.  Around a transition, the result
+ * is the latest (for a floor) or earliest (for a ceiling) instant at
+ * which local time is exactly the boundary, or the transition instant
+ * if local time skipped over the boundary.  Each case is run through
+ * the scalar functions, and the whole table is run through the batch
+ * functions at once, so that the batch functions also see instants
+ * that jump between offset periods.
+ * 
+ * Then compares the batch functions against the scalar functions over
+ * every unit for runs of instants across both transitions, first in
+ * order, which reuses the cached period and bucket, and then shuffled.
+ * 
+ * Prints a message and exits with status zero if all tests pass, or
+ * prints the failures and exits with a non-zero status otherwise.
+ * 
+ * Compilation
+ * -----------
+ * 
+ * Built and run by the "check" target of the Makefile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "grcal.h"
+#include "grcal_trunc.h"
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The offsets of the test zone, +05:30 and +06:30.
+ */
+#define OFF_STD INT32_C(19800)
+#define OFF_DST INT32_C(23400)
+
+/*
+ * The instant of a local time at a given offset.
+ */
+#define LOCAL(y, mo, d, h, mi, off) \
+  ((((int64_t) (GRCAL_DATE(y, mo, d) - GRCAL_DAY_UNIX)) * 86400) + \
+    ((h) * 3600) + ((mi) * 60) - (off))
+
+/*
+ * The transitions of the test zone.  At T_SKIP, local time skips from
+ * 02:00 to 03:00, and at T_REPEAT, it goes back from 02:00 to 01:00.
+ */
+#define T_SKIP   LOCAL(2024, 3, 10, 2, 0, OFF_STD)
+#define T_REPEAT LOCAL(2024, 11, 3, 2, 0, OFF_DST)
+
+/*
+ * The spacing in seconds of the runs of instants for the batch
+ * comparison, and the number of instants in each run.
+ */
+#define RUN_STEP  419
+#define RUN_COUNT 1200
+
+/*
+ * The maximum number of failures reported before giving up.
+ */
+#define MAX_FAIL 10
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * One test case.
+ */
+typedef struct {
+  int ceil;
+  int unit;
+  int32_t minutes;
+  int64_t t;
+  int64_t result;
+} TRUNC_CASE;
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * The transitions of the test zone, and the zone itself.
+ */
+static const int64_t m_time[2] = {T_SKIP, T_REPEAT};
+static const int32_t m_offset[2] = {OFF_DST, OFF_STD};
+
+static const GRCAL_ZONE m_zone = {OFF_STD, 2, m_time, m_offset};
+
+/*
+ * Instants and their expected floors and ceilings.
+ */
+static const TRUNC_CASE m_cases[] = {
+  
+  /* Boundaries away from the transitions, at a half-hour offset */
+  {0, GRCAL_TRUNC_HOUR, 0, LOCAL(2024, 6, 5, 12, 45, OFF_DST),
+    LOCAL(2024, 6, 5, 12, 0, OFF_DST)},
+  {1, GRCAL_TRUNC_HOUR, 0, LOCAL(2024, 6, 5, 12, 45, OFF_DST),
+    LOCAL(2024, 6, 5, 13, 0, OFF_DST)},
+  {0, GRCAL_TRUNC_MINUTES, 20, LOCAL(2024, 1, 8, 23, 59, OFF_STD),
+    LOCAL(2024, 1, 8, 23, 40, OFF_STD)},
+  {1, GRCAL_TRUNC_MINUTES, 20, LOCAL(2024, 1, 8, 23, 59, OFF_STD),
+    LOCAL(2024, 1, 9, 0, 0, OFF_STD)},
+  {0, GRCAL_TRUNC_DAY, 0, LOCAL(2024, 6, 5, 0, 10, OFF_DST),
+    LOCAL(2024, 6, 5, 0, 0, OFF_DST)},
+  {0, GRCAL_TRUNC_WEEK, 0, LOCAL(2024, 6, 5, 9, 0, OFF_DST),
+    LOCAL(2024, 6, 3, 0, 0, OFF_DST)},
+  {1, GRCAL_TRUNC_DAY, 0, LOCAL(2024, 6, 5, 0, 0, OFF_DST),
+    LOCAL(2024, 6, 5, 0, 0, OFF_DST)},
+  
+  /* Months that span a transition */
+  {0, GRCAL_TRUNC_MONTH, 0, LOCAL(2024, 3, 20, 10, 0, OFF_DST),
+    LOCAL(2024, 3, 1, 0, 0, OFF_STD)},
+  {1, GRCAL_TRUNC_MONTH, 0, LOCAL(2024, 3, 5, 10, 0, OFF_STD),
+    LOCAL(2024, 4, 1, 0, 0, OFF_DST)},
+  {1, GRCAL_TRUNC_MONTH, 0, LOCAL(2024, 11, 2, 10, 0, OFF_DST),
+    LOCAL(2024, 12, 1, 0, 0, OFF_STD)},
+  
+  /* Skip ahead: 02:00 to 03:00 does not exist */
+  {0, GRCAL_TRUNC_HOUR, 0, T_SKIP - 600,
+    LOCAL(2024, 3, 10, 1, 0, OFF_STD)},
+  {1, GRCAL_TRUNC_HOUR, 0, T_SKIP - 600, T_SKIP},
+  {0, GRCAL_TRUNC_HOUR, 0, T_SKIP + 600, T_SKIP},
+  {1, GRCAL_TRUNC_HOUR, 0, T_SKIP + 600,
+    LOCAL(2024, 3, 10, 4, 0, OFF_DST)},
+  {0, GRCAL_TRUNC_MINUTES, 150, T_SKIP + 600, T_SKIP},
+  {1, GRCAL_TRUNC_MINUTES, 150, T_SKIP - 600, T_SKIP},
+  {0, GRCAL_TRUNC_DAY, 0, T_SKIP + 600,
+    LOCAL(2024, 3, 10, 0, 0, OFF_STD)},
+  {1, GRCAL_TRUNC_DAY, 0, T_SKIP + 600,
+    LOCAL(2024, 3, 11, 0, 0, OFF_DST)},
+  {0, GRCAL_TRUNC_HOUR, 0, T_SKIP, T_SKIP},
+  {1, GRCAL_TRUNC_HOUR, 0, T_SKIP, T_SKIP},
+  
+  /* Repeat: 01:00 to 02:00 happens twice, and each occurrence floors
+   * to its own start, but the first one ceils past the second */
+  {0, GRCAL_TRUNC_HOUR, 0, T_REPEAT - 1800, T_REPEAT - 3600},
+  {1, GRCAL_TRUNC_HOUR, 0, T_REPEAT - 1800, T_REPEAT + 3600},
+  {0, GRCAL_TRUNC_HOUR, 0, T_REPEAT + 1800, T_REPEAT},
+  {1, GRCAL_TRUNC_HOUR, 0, T_REPEAT + 1800, T_REPEAT + 3600},
+  {0, GRCAL_TRUNC_MINUTES, 30, T_REPEAT + 2700, T_REPEAT + 1800},
+  {0, GRCAL_TRUNC_DAY, 0, T_REPEAT + 1800,
+    LOCAL(2024, 11, 3, 0, 0, OFF_DST)},
+  {1, GRCAL_TRUNC_DAY, 0, T_REPEAT - 1800,
+    LOCAL(2024, 11, 4, 0, 0, OFF_STD)},
+  {0, GRCAL_TRUNC_HOUR, 0, T_REPEAT, T_REPEAT},
+  {1, GRCAL_TRUNC_HOUR, 0, T_REPEAT, T_REPEAT}
+};
+
+/*
+ * The units and bucket lengths that the batch functions are compared
+ * over.
+ */
+static const int m_unit[] = {
+  GRCAL_TRUNC_MINUTES, GRCAL_TRUNC_MINUTES, GRCAL_TRUNC_MINUTES,
+  GRCAL_TRUNC_MINUTES, GRCAL_TRUNC_HOUR, GRCAL_TRUNC_DAY,
+  GRCAL_TRUNC_WEEK, GRCAL_TRUNC_MONTH
+};
+
+static const int32_t m_minutes[] = {
+  1, 7, 90, 150, 0, 0, 0, 0
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t scalar(int ceil, int unit, int32_t minutes, int64_t t);
+static size_t batch(
+          int       ceil,
+          int       unit,
+          int32_t   minutes,
+    const int64_t * pIn,
+          size_t    count,
+          int64_t * pOut);
+static int compareRun(
+    int        ceil,
+    int        unit,
+    int32_t    minutes,
+    int64_t  * pIn,
+    size_t     count);
+
+/*
+ * Floor or ceil an instant with the scalar functions.
+ * 
+ * Parameters:
+ * 
+ *   ceil - non-zero to ceil, zero to floor
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   t - the instant
+ * 
+ * Return:
+ * 
+ *   the result, or GRCAL_TRUNC_INVALID if the function failed
+ */
+static int64_t scalar(int ceil, int unit, int32_t minutes, int64_t t) {
+  
+  int64_t result = 0;
+  int ok = 0;
+  
+  if (ceil) {
+    ok = grcal_truncCeil(&m_zone, unit, minutes, t, &result);
+  } else {
+    ok = grcal_truncFloor(&m_zone, unit, minutes, t, &result);
+  }
+  return ok ? result : GRCAL_TRUNC_INVALID;
+}
+
+/*
+ * Floor or ceil an array of instants with the batch functions.
+ * 
+ * Parameters:
+ * 
+ *   ceil - non-zero to ceil, zero to floor
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   pIn - the instants
+ * 
+ *   count - the number of instants
+ * 
+ *   pOut - the array to receive the results
+ * 
+ * Return:
+ * 
+ *   the number of instants that could not be converted
+ */
+static size_t batch(
+          int       ceil,
+          int       unit,
+          int32_t   minutes,
+    const int64_t * pIn,
+          size_t    count,
+          int64_t * pOut) {
+  if (ceil) {
+    return grcal_truncCeilBatch(&m_zone, unit, minutes, pIn, count,
+                                pOut);
+  }
+  return grcal_truncFloorBatch(&m_zone, unit, minutes, pIn, count,
+                                pOut);
+}
+
+/*
+ * Compare the batch and scalar results over an array of instants.
+ * 
+ * Parameters:
+ * 
+ *   ceil - non-zero to ceil, zero to floor
+ * 
+ *   unit - the truncation unit
+ * 
+ *   minutes - the bucket length for GRCAL_TRUNC_MINUTES
+ * 
+ *   pIn - the instants
+ * 
+ *   count - the number of instants, at most RUN_COUNT * 2
+ * 
+ * Return:
+ * 
+ *   the number of instants whose results differ
+ */
+static int compareRun(
+    int        ceil,
+    int        unit,
+    int32_t    minutes,
+    int64_t  * pIn,
+    size_t     count) {
+  
+  static int64_t out[RUN_COUNT * 2];
+  size_t i = 0;
+  int failed = 0;
+  
+  if (batch(ceil, unit, minutes, pIn, count, out) != 0) {
+    fprintf(stderr, "test_trunc: Batch failed on valid instants!\n");
+    failed++;
+  }
+  
+  for(i = 0; i < count; i++) {
+    if (out[i] != scalar(ceil, unit, minutes, pIn[i])) {
+      if (failed < MAX_FAIL) {
+        fprintf(stderr,
+          "test_trunc: Batch %s of %lld (unit %d, %ld min) differs!\n",
+          ceil ? "ceiling" : "floor", (long long) pIn[i], unit,
+          (long) minutes);
+      }
+      failed++;
+    }
+  }
+  
+  return failed;
+}
+
+/*
+ * Program entrypoint
+ * ==================
+ */
+
+int main(int argc, char *argv[]) {
+  
+  static int64_t in[RUN_COUNT * 2];
+  int64_t out[sizeof(m_cases) / sizeof(m_cases[0])];
+  int64_t t = 0;
+  uint32_t seed = 1;
+  size_t n = sizeof(m_cases) / sizeof(m_cases[0]);
+  size_t i = 0;
+  size_t j = 0;
+  int ceil = 0;
+  int failed = 0;
+  int k = 0;
+  
+  (void) argc;
+  (void) argv;
+  
+  /* Expected results, through the scalar functions */
+  for(i = 0; i < n; i++) {
+    if (scalar(m_cases[i].ceil, m_cases[i].unit, m_cases[i].minutes,
+          m_cases[i].t) != m_cases[i].result) {
+      fprintf(stderr, "test_trunc: Scalar case %lu wrong!\n",
+                (unsigned long) i);
+      failed++;
+    }
+  }
+  
+  /* The same cases through the batch functions, all in one array, so
+   * that consecutive instants jump between offset periods */
+  for(ceil = 0; ceil <= 1; ceil++) {
+    for(i = 0; i < n; i++) {
+      in[i] = m_cases[i].t;
+    }
+    for(i = 0; i < n; i++) {
+      if (m_cases[i].ceil != ceil) {
+        continue;
+      }
+      batch(ceil, m_cases[i].unit, m_cases[i].minutes, in, n, out);
+      if (out[i] != m_cases[i].result) {
+        fprintf(stderr, "test_trunc: Batch case %lu wrong!\n",
+                  (unsigned long) i);
+        failed++;
+      }
+    }
+  }
+  
+  /* Runs of instants in order across both transitions */
+  for(i = 0; i < RUN_COUNT; i++) {
+    in[i] = T_SKIP + ((((int64_t) i) - (RUN_COUNT / 2)) * RUN_STEP);
+    in[RUN_COUNT + i] = T_REPEAT +
+                    ((((int64_t) i) - (RUN_COUNT / 2)) * RUN_STEP);
+  }
+  for(k = 0; k < (int) (sizeof(m_unit) / sizeof(m_unit[0])); k++) {
+    for(ceil = 0; ceil <= 1; ceil++) {
+      failed += compareRun(ceil, m_unit[k], m_minutes[k],
+                            in, RUN_COUNT * 2);
+    }
+  }
+  
+  /* The same instants shuffled, so that most instants change period
+   * or bucket */
+  for(i = (RUN_COUNT * 2) - 1; i > 0; i--) {
+    seed = (seed * UINT32_C(1103515245)) + UINT32_C(12345);
+    j = (size_t) ((seed >> 8) % (uint32_t) (i + 1));
+    t = in[i];
+    in[i] = in[j];
+    in[j] = t;
+  }
+  for(k = 0; k < (int) (sizeof(m_unit) / sizeof(m_unit[0])); k++) {
+    for(ceil = 0; ceil <= 1; ceil++) {
+      failed += compareRun(ceil, m_unit[k], m_minutes[k],
+                            in, RUN_COUNT * 2);
+    }
+  }
+  
+  if (failed > 0) {
+    return EXIT_FAILURE;
+  }
+  printf("test_trunc: All tests passed.\n");
+  return EXIT_SUCCESS;
+}